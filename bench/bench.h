@@ -0,0 +1,141 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// Small helpers shared by the bench__*.c programs. Every benchmark prints its
+// results as CSV on stdout: one header line followed by one row per measured
+// metric, so that results can be collected and compared over time.
+
+#ifndef __CCMS__BENCH__H
+#define __CCMS__BENCH__H
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static inline double bench__now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static inline void bench__header(void) {
+  printf("benchmark,variant,threads,size,metric,value\n");
+}
+
+static inline void bench__metric(const char* benchmark,
+                                 const char* variant,
+                                 const size_t threads,
+                                 const size_t size,
+                                 const char* metric,
+                                 const double value) {
+  printf("%s,%s,%zu,%zu,%s,%.3f\n", benchmark, variant, threads, size, metric,
+         value);
+  fflush(stdout);
+}
+
+// Reports the throughput of `ops` operations that took `seconds`.
+static inline void bench__row(const char* benchmark,
+                              const char* variant,
+                              const size_t threads,
+                              const size_t size,
+                              const size_t ops,
+                              const double seconds) {
+  bench__metric(benchmark, variant, threads, size, "mops_per_sec",
+                ops / seconds / 1e6);
+}
+
+// Keeps the compiler from optimizing away a value that is never used.
+static inline void bench__use(const void* ptr) {
+  __asm__ volatile("" : : "r"(ptr) : "memory");
+}
+
+// Small, fast PRNG (xorshift64*) for generating workloads.
+static inline uint64_t bench__rand(uint64_t* state) {
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return *state * 2685821657736338717ull;
+}
+
+static inline size_t bench__nthreads_max(void) {
+  const char* env = getenv("BENCH_THREADS");
+  return env != NULL ? strtoul(env, NULL, 10) : 8;
+}
+
+//
+//
+// ------------------ multi-threaded runs ------------------
+//
+//
+
+typedef void (*bench_thread_fn)(void* ctx, size_t tid);
+
+typedef struct {
+  bench_thread_fn fn;
+  void* ctx;
+  size_t tid;
+  atomic_int* go;
+} _bench_thread_t;
+
+static inline void* _bench__thread_main(void* arg) {
+  _bench_thread_t* t = (_bench_thread_t*)arg;
+
+  while (!atomic_load_explicit(t->go, memory_order_acquire))
+    ;
+  t->fn(t->ctx, t->tid);
+
+  return NULL;
+}
+
+// Runs fn on nthreads threads that are released at the same time and returns
+// the wall-clock time until the last one finished.
+static inline double bench__run_threads(const size_t nthreads,
+                                        bench_thread_fn fn,
+                                        void* ctx) {
+  pthread_t* threads = (pthread_t*)malloc(sizeof(pthread_t) * nthreads);
+  _bench_thread_t* args =
+      (_bench_thread_t*)malloc(sizeof(_bench_thread_t) * nthreads);
+  atomic_int go = 0;
+
+  for (size_t i = 0; i < nthreads; i++) {
+    args[i] = (_bench_thread_t){.fn = fn, .ctx = ctx, .tid = i, .go = &go};
+    pthread_create(&threads[i], NULL, _bench__thread_main, &args[i]);
+  }
+
+  const double start = bench__now();
+  atomic_store_explicit(&go, 1, memory_order_release);
+  for (size_t i = 0; i < nthreads; i++)
+    pthread_join(threads[i], NULL);
+  const double seconds = bench__now() - start;
+
+  free(threads);
+  free(args);
+
+  return seconds;
+}
+
+#endif  // __CCMS__BENCH__H
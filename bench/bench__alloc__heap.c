@@ -0,0 +1,90 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// Small-object churn through heap_t against malloc/free: a working set of
+// objects with random sizes is filled, then random objects are freed and
+// replaced by objects of a new random size, and finally every object is freed
+// one by one. Creating and freeing the heap itself is not timed.
+
+#include "bench.h"
+#include "ccms/alloc/heap.h"
+
+#define LIVE 100000
+#define CHURN 10000000
+#define REPEAT 3
+
+static void* objs[LIVE];
+static size_t sizes[LIVE + CHURN];
+
+static double run_heap(void) {
+  heap_t* heap = heap__new();
+  uint64_t seed = 42;
+  const double start = bench__now();
+
+  for (size_t i = 0; i < LIVE; i++)
+    bench__use(objs[i] = heap__alloc(heap, sizes[i]));
+  for (size_t i = 0; i < CHURN; i++) {
+    const size_t j = bench__rand(&seed) % LIVE;
+    heap__dealloc(heap, objs[j]);
+    bench__use(objs[j] = heap__alloc(heap, sizes[LIVE + i]));
+  }
+  for (size_t i = 0; i < LIVE; i++)
+    heap__dealloc(heap, objs[i]);
+
+  const double seconds = bench__now() - start;
+  heap__free(heap);
+
+  return seconds;
+}
+
+static double run_malloc(void) {
+  uint64_t seed = 42;
+  const double start = bench__now();
+
+  for (size_t i = 0; i < LIVE; i++)
+    bench__use(objs[i] = malloc(sizes[i]));
+  for (size_t i = 0; i < CHURN; i++) {
+    const size_t j = bench__rand(&seed) % LIVE;
+    free(objs[j]);
+    bench__use(objs[j] = malloc(sizes[LIVE + i]));
+  }
+  for (size_t i = 0; i < LIVE; i++)
+    free(objs[i]);
+
+  return bench__now() - start;
+}
+
+int main(void) {
+  const size_t max_sizes[] = {64, 256, 1024};
+  const size_t ops = 2 * (size_t)LIVE + 2 * (size_t)CHURN;
+  uint64_t seed = 0x9E3779B97F4A7C15ull;
+
+  bench__header();
+  for (size_t s = 0; s < sizeof(max_sizes) / sizeof(max_sizes[0]); s++) {
+    for (size_t i = 0; i < LIVE + CHURN; i++)
+      sizes[i] = 1 + bench__rand(&seed) % max_sizes[s];
+
+    for (size_t r = 0; r < REPEAT; r++) {
+      bench__row("heap_churn", "heap", 1, max_sizes[s], ops, run_heap());
+      bench__row("heap_churn", "malloc", 1, max_sizes[s], ops, run_malloc());
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
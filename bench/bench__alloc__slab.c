@@ -0,0 +1,119 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// Fixed-size object churn with slab_t against malloc/free: a working set of
+// objects is filled, then random objects are freed and replaced. Afterwards
+// most of the objects are freed at random and the memory still held per byte
+// of live objects is reported as "overhead" (1.0 would be perfect). For malloc
+// this is taken from mallinfo2 and only reported on glibc.
+
+#include "bench.h"
+#include "ccms/alloc/slab.h"
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#define LIVE 100000
+#define CHURN 10000000
+#define KEEP_PERCENT 10
+
+static void* objs[LIVE];
+
+static double run_slab(slab_t* slab, uint64_t seed) {
+  const double start = bench__now();
+
+  for (size_t i = 0; i < LIVE; i++)
+    objs[i] = slab__alloc(slab);
+  for (size_t i = 0; i < CHURN; i++) {
+    const size_t j = bench__rand(&seed) % LIVE;
+    slab__dealloc(slab, objs[j]);
+    objs[j] = slab__alloc(slab);
+  }
+
+  return bench__now() - start;
+}
+
+static double run_malloc(const size_t size, uint64_t seed) {
+  const double start = bench__now();
+
+  for (size_t i = 0; i < LIVE; i++)
+    bench__use(objs[i] = malloc(size));
+  for (size_t i = 0; i < CHURN; i++) {
+    const size_t j = bench__rand(&seed) % LIVE;
+    free(objs[j]);
+    bench__use(objs[j] = malloc(size));
+  }
+
+  return bench__now() - start;
+}
+
+// Frees all but KEEP_PERCENT of the objects at random, returns how many are
+// left at the front of objs.
+static size_t thin_out(slab_t* slab, uint64_t seed) {
+  size_t live = 0;
+
+  for (size_t i = 0; i < LIVE; i++) {
+    if (bench__rand(&seed) % 100 < KEEP_PERCENT) {
+      objs[live++] = objs[i];
+    } else if (slab != NULL) {
+      slab__dealloc(slab, objs[i]);
+    } else {
+      free(objs[i]);
+    }
+  }
+
+  return live;
+}
+
+static void bench_slab(const char* variant, slab_t* slab, const size_t size) {
+  const size_t ops = (size_t)LIVE + 2 * (size_t)CHURN;
+
+  bench__row("slab_churn", variant, 1, size, ops, run_slab(slab, 42));
+
+  const size_t live = thin_out(slab, 7);
+  bench__metric("slab_churn", variant, 1, size, "overhead",
+                (double)(slab->npages * slab->page_size) / (live * size));
+  slab__free(slab);
+}
+
+int main(void) {
+  const size_t sizes[] = {16, 48, 128, 512};
+  const size_t ops = (size_t)LIVE + 2 * (size_t)CHURN;
+
+  bench__header();
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    const size_t size = sizes[s];
+
+    bench_slab("slab", slab__new(size, KiB(64)), size);
+    bench_slab("slab_tracked", slab__new_tracked(size, KiB(64)), size);
+
+    bench__row("slab_churn", "malloc", 1, size, ops, run_malloc(size, 42));
+    const size_t live = thin_out(NULL, 7);
+#ifdef __GLIBC__
+    const struct mallinfo2 info = mallinfo2();
+    bench__metric("slab_churn", "malloc", 1, size, "overhead",
+                  (double)(info.arena + info.hblkhd) / (live * size));
+#endif
+    for (size_t i = 0; i < live; i++)
+      free(objs[i]);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,348 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// malloc against every single-threaded arena on the same workloads:
+//
+// - arena_alloc_<dist>: allocation throughput (including the reset or the
+//   frees that end every round) for several request size distributions
+// - arena_reset_<dist>: cost of one reset (or of freeing every chunk) after a
+//   round
+// - arena_overhead_<dist>: memory held after a round (including headers and
+//   memory kept for reuse) per byte requested; for malloc only on glibc
+// - arena_alloc_mt: throughput with one arena (or malloc) per thread, for the
+//   uniform distribution
+//
+// Every chunk is touched once, so that lazily committed memory is paid for.
+// The arenas pack chunks as tightly as __CCMS__DEFAULT_ALIGN allows (1 by
+// default), while malloc always aligns to max_align_t.
+// The size column holds the largest request of the distribution.
+
+#include "bench.h"
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#include "ccms/arena/dynamic.h"
+#include "ccms/arena/paged.h"
+#include "ccms/arena/static.h"
+#include "ccms/arena/virtual.h"
+
+#define ALLOCS_PER_ROUND 100000
+#define ROUNDS 50
+#define MT_ROUNDS 20
+#define PAGE_SIZE 65536
+
+// Request sizes, see fill_sizes
+typedef enum dist_t {
+  DIST_FIXED,
+  DIST_UNIFORM,
+  DIST_MIXED,
+} dist_t;
+
+static const char* dist_names[] = {"fixed_32", "uniform_16_256", "mixed"};
+static const size_t dist_max[] = {32, 256, 16384};
+
+typedef enum variant_t {
+  VARIANT_MALLOC,
+  VARIANT_ST,
+  VARIANT_PG,
+  VARIANT_VM,
+  VARIANT_DYN,
+} variant_t;
+
+#define NVARIANTS 5
+
+static const char* variant_names[] = {"malloc", "st_arena", "pg_arena",
+                                      "vm_arena", "dyn_arena"};
+
+// Fills `sizes` with requests following the distribution. The mixed one is
+// mostly small objects with a tail of larger ones: 90% of 8-64 bytes, 9% of
+// 64 bytes-1 KiB and 1% of 1-16 KiB.
+static size_t fill_sizes(size_t* sizes, const dist_t dist, uint64_t seed) {
+  size_t total = 0;
+
+  for (size_t i = 0; i < ALLOCS_PER_ROUND; i++) {
+    const uint64_t r = bench__rand(&seed);
+
+    switch (dist) {
+      case DIST_FIXED:
+        sizes[i] = 32;
+        break;
+      case DIST_UNIFORM:
+        sizes[i] = 16 + r % 241;
+        break;
+      case DIST_MIXED:
+        if (r % 100 < 90)
+          sizes[i] = 8 + (r >> 8) % 57;
+        else if (r % 100 < 99)
+          sizes[i] = 64 + (r >> 8) % 961;
+        else
+          sizes[i] = 1024 + (r >> 8) % 15361;
+        break;
+    }
+    total += sizes[i];
+  }
+
+  return total;
+}
+
+// One arena (or malloc) and the chunks allocated from it in the current round
+typedef struct {
+  variant_t variant;
+  st_arena_t* st;
+  pg_arena_t* pg;
+  vm_arena_t* vm;
+  dyn_arena_t* dyn;
+  uint8_t** ptrs;
+} alloc_t;
+
+static alloc_t alloc_new(const variant_t variant, const size_t total) {
+  alloc_t self = {.variant = variant};
+
+  switch (variant) {
+    case VARIANT_MALLOC:
+      self.ptrs = (uint8_t**)malloc(sizeof(uint8_t*) * ALLOCS_PER_ROUND);
+      break;
+    case VARIANT_ST:
+      self.st = st_arena__new(total);
+      break;
+    case VARIANT_PG:
+      self.pg = pg_arena__new(PAGE_SIZE);
+      break;
+    case VARIANT_VM:
+      self.vm = vm_arena__new(GiB(1));
+      break;
+    case VARIANT_DYN:
+      self.dyn = dyn_arena__new();
+      break;
+  }
+
+  return self;
+}
+
+static void alloc_free(alloc_t* self) {
+  switch (self->variant) {
+    case VARIANT_MALLOC:
+      free(self->ptrs);
+      break;
+    case VARIANT_ST:
+      st_arena__free(self->st);
+      break;
+    case VARIANT_PG:
+      pg_arena__free(self->pg);
+      break;
+    case VARIANT_VM:
+      vm_arena__free(self->vm);
+      break;
+    case VARIANT_DYN:
+      dyn_arena__free(self->dyn);
+      break;
+  }
+}
+
+static void alloc_fill(alloc_t* self, const size_t* sizes) {
+  for (size_t i = 0; i < ALLOCS_PER_ROUND; i++) {
+    uint8_t* ptr = NULL;
+
+    switch (self->variant) {
+      case VARIANT_MALLOC:
+        ptr = self->ptrs[i] = (uint8_t*)malloc(sizes[i]);
+        break;
+      case VARIANT_ST:
+        ptr = st_arena__alloc(self->st, sizes[i]);
+        break;
+      case VARIANT_PG:
+        ptr = pg_arena__alloc(self->pg, sizes[i]);
+        break;
+      case VARIANT_VM:
+        ptr = vm_arena__alloc(self->vm, sizes[i]);
+        break;
+      case VARIANT_DYN:
+        ptr = dyn_arena__alloc(self->dyn, sizes[i]);
+        break;
+    }
+
+    ptr[0] = (uint8_t)i;
+  }
+}
+
+static void alloc_reset(alloc_t* self) {
+  switch (self->variant) {
+    case VARIANT_MALLOC:
+      for (size_t i = 0; i < ALLOCS_PER_ROUND; i++)
+        free(self->ptrs[i]);
+      break;
+    case VARIANT_ST:
+      st_arena__reset(self->st);
+      break;
+    case VARIANT_PG:
+      pg_arena__reset(self->pg);
+      break;
+    case VARIANT_VM:
+      vm_arena__reset(self->vm);
+      break;
+    case VARIANT_DYN:
+      dyn_arena__soft_reset(self->dyn);
+      break;
+  }
+}
+
+// Memory in use by malloc, or 0 if that is unknown
+static size_t malloc_held(void) {
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  const struct mallinfo2 info = mallinfo2();
+  return info.uordblks + info.hblkhd;
+#else
+  return 0;
+#endif
+}
+
+// Memory held by the arena, including headers and memory kept for reuse
+static size_t alloc_held(const alloc_t* self) {
+  size_t held = 0;
+
+  switch (self->variant) {
+    case VARIANT_MALLOC:
+      break;
+    case VARIANT_ST:
+      held = _ST_ARENA_HEADER_SIZE + self->st->size;
+      break;
+    case VARIANT_PG:
+      for (_pg_arena_page_t* itr = self->pg->head; itr != NULL;
+           itr = itr->next)
+        held += _PG_ARENA_PAGE_HEADER_SIZE + itr->size;
+      for (_pg_arena_large_t* itr = self->pg->large; itr != NULL;
+           itr = itr->next)
+        held += _PG_ARENA_LARGE_HEADER_SIZE + itr->size;
+      break;
+    case VARIANT_VM:
+      held = self->vm->committed;
+      break;
+    case VARIANT_DYN:
+      for (_dyn_arena_chunk_t* itr = self->dyn->chunks; itr != NULL;
+           itr = itr->next)
+        held += _DYN_ARENA_CHUNK_HEADER_SIZE + itr->size;
+      for (_dyn_arena_block_t* itr = self->dyn->head; itr != NULL;
+           itr = itr->next)
+        held += _DYN_ARENA_BLOCK_HEADER_SIZE + itr->size;
+      break;
+  }
+
+  return held;
+}
+
+//
+//
+// ------------------ single-threaded ------------------
+//
+//
+
+static void bench_alloc(const variant_t variant,
+                        const dist_t dist,
+                        const size_t* sizes,
+                        const size_t total) {
+  alloc_t alloc = alloc_new(variant, total);
+  double fill = 0., reset = 0.;
+  char name[64];
+
+  // A fresh round, to see what the workload needs from scratch
+  const size_t before = malloc_held();
+  alloc_fill(&alloc, sizes);
+  const size_t held = variant == VARIANT_MALLOC ? malloc_held() - before
+                                                : alloc_held(&alloc);
+  alloc_reset(&alloc);
+
+  if (variant != VARIANT_MALLOC || before != 0) {
+    snprintf(name, sizeof(name), "arena_overhead_%s", dist_names[dist]);
+    bench__metric(name, variant_names[variant], 1, dist_max[dist],
+                  "held_per_requested", (double)held / total);
+  }
+
+  for (size_t round = 0; round < ROUNDS; round++) {
+    const double start = bench__now();
+    alloc_fill(&alloc, sizes);
+    const double mid = bench__now();
+    alloc_reset(&alloc);
+    const double end = bench__now();
+
+    fill += mid - start;
+    reset += end - mid;
+  }
+
+  snprintf(name, sizeof(name), "arena_alloc_%s", dist_names[dist]);
+  bench__row(name, variant_names[variant], 1, dist_max[dist],
+             (size_t)ALLOCS_PER_ROUND * ROUNDS, fill + reset);
+  snprintf(name, sizeof(name), "arena_reset_%s", dist_names[dist]);
+  bench__metric(name, variant_names[variant], 1, dist_max[dist],
+                "us_per_reset", reset / ROUNDS * 1e6);
+  alloc_free(&alloc);
+}
+
+//
+//
+// ------------------ multi-threaded ------------------
+//
+//
+
+typedef struct {
+  variant_t variant;
+  const size_t* sizes;
+  size_t total;
+} mt_ctx_t;
+
+static void worker(void* arg, size_t tid) {
+  mt_ctx_t* ctx = (mt_ctx_t*)arg;
+  alloc_t alloc = alloc_new(ctx->variant, ctx->total);
+
+  for (size_t round = 0; round < MT_ROUNDS; round++) {
+    alloc_fill(&alloc, ctx->sizes);
+    alloc_reset(&alloc);
+  }
+
+  alloc_free(&alloc);
+  (void)tid;
+}
+
+int main(void) {
+  static size_t sizes[ALLOCS_PER_ROUND];
+  const size_t nthreads_max = bench__nthreads_max();
+
+  bench__header();
+
+  for (dist_t dist = DIST_FIXED; dist <= DIST_MIXED; dist++) {
+    const size_t total = fill_sizes(sizes, dist, 0x9E3779B97F4A7C15ull);
+
+    for (variant_t variant = 0; variant < NVARIANTS; variant++)
+      bench_alloc(variant, dist, sizes, total);
+  }
+
+  const size_t total = fill_sizes(sizes, DIST_UNIFORM, 0x9E3779B97F4A7C15ull);
+
+  for (size_t nthreads = 1; nthreads <= nthreads_max; nthreads *= 2)
+    for (variant_t variant = 0; variant < NVARIANTS; variant++) {
+      mt_ctx_t ctx = {.variant = variant, .sizes = sizes, .total = total};
+
+      bench__row("arena_alloc_mt", variant_names[variant], nthreads,
+                 dist_max[DIST_UNIFORM],
+                 (size_t)ALLOCS_PER_ROUND * MT_ROUNDS * nthreads,
+                 bench__run_threads(nthreads, worker, &ctx));
+    }
+
+  return EXIT_SUCCESS;
+}
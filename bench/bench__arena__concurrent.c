@@ -0,0 +1,83 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// Many threads filling one shared static arena: the lock-free cst_arena_t
+// against a st_arena_t guarded by a mutex.
+
+#include "bench.h"
+#include "ccms/arena/concurrent.h"
+#include "ccms/arena/static.h"
+
+#define CHUNK_SIZE 32
+#define CHUNKS_PER_THREAD 2000000
+#define REPEAT 5
+
+typedef struct {
+  cst_arena_t* cst;
+  st_arena_t* st;
+  pthread_mutex_t lock;
+} ctx_t;
+
+static void worker_atomic(void* arg, size_t tid) {
+  ctx_t* ctx = (ctx_t*)arg;
+
+  for (size_t i = 0; i < CHUNKS_PER_THREAD; i++)
+    bench__use(cst_arena__alloc(ctx->cst, CHUNK_SIZE));
+  (void)tid;
+}
+
+static void worker_mutex(void* arg, size_t tid) {
+  ctx_t* ctx = (ctx_t*)arg;
+
+  for (size_t i = 0; i < CHUNKS_PER_THREAD; i++) {
+    pthread_mutex_lock(&ctx->lock);
+    uint8_t* chunk = st_arena__alloc(ctx->st, CHUNK_SIZE);
+    pthread_mutex_unlock(&ctx->lock);
+    bench__use(chunk);
+  }
+  (void)tid;
+}
+
+int main(void) {
+  bench__header();
+  for (size_t nthreads = 1; nthreads <= bench__nthreads_max(); nthreads *= 2) {
+    const size_t ops = (size_t)CHUNKS_PER_THREAD * nthreads;
+    ctx_t ctx;
+
+    ctx.cst = cst_arena__new(ops * CHUNK_SIZE);
+    ctx.st = st_arena__new(ops * CHUNK_SIZE);
+    pthread_mutex_init(&ctx.lock, NULL);
+
+    for (size_t r = 0; r < REPEAT; r++) {
+      cst_arena__reset(ctx.cst);
+      bench__row("shared_static_arena", "atomic", nthreads, CHUNK_SIZE, ops,
+                 bench__run_threads(nthreads, worker_atomic, &ctx));
+
+      st_arena__reset(ctx.st);
+      bench__row("shared_static_arena", "mutex", nthreads, CHUNK_SIZE, ops,
+                 bench__run_threads(nthreads, worker_mutex, &ctx));
+    }
+
+    pthread_mutex_destroy(&ctx.lock);
+    cst_arena__free(ctx.cst);
+    st_arena__free(ctx.st);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// Allocation rate of dyn_arena_t with small requests carved from shared chunks
+// against one block per request (threshold 0, the previous behaviour), each
+// followed by a reset. Plain malloc/free is included as a reference.
+
+#include "bench.h"
+#include "ccms/arena/dynamic.h"
+
+#define ALLOCS_PER_ROUND 10000
+#define ROUNDS 500
+
+static size_t sizes[ALLOCS_PER_ROUND];
+
+static double run_arena(dyn_arena_t* arena) {
+  const double start = bench__now();
+
+  for (size_t round = 0; round < ROUNDS; round++) {
+    for (size_t i = 0; i < ALLOCS_PER_ROUND; i++)
+      bench__use(dyn_arena__alloc(arena, sizes[i]));
+    dyn_arena__soft_reset(arena);
+  }
+
+  return bench__now() - start;
+}
+
+static double run_malloc(void) {
+  static void* ptrs[ALLOCS_PER_ROUND];
+  const double start = bench__now();
+
+  for (size_t round = 0; round < ROUNDS; round++) {
+    for (size_t i = 0; i < ALLOCS_PER_ROUND; i++)
+      bench__use(ptrs[i] = malloc(sizes[i]));
+    for (size_t i = 0; i < ALLOCS_PER_ROUND; i++)
+      free(ptrs[i]);
+  }
+
+  return bench__now() - start;
+}
+
+int main(void) {
+  const size_t max_sizes[] = {16, 64, 256, 1024};
+  const size_t ops = (size_t)ALLOCS_PER_ROUND * ROUNDS;
+  uint64_t seed = 0x9E3779B97F4A7C15ull;
+
+  bench__header();
+  for (size_t s = 0; s < sizeof(max_sizes) / sizeof(max_sizes[0]); s++) {
+    for (size_t i = 0; i < ALLOCS_PER_ROUND; i++)
+      sizes[i] = 1 + bench__rand(&seed) % max_sizes[s];
+
+    dyn_arena_t* chunked = dyn_arena__new();
+    bench__row("dyn_arena_alloc_reset", "chunked", 1, max_sizes[s], ops,
+               run_arena(chunked));
+    dyn_arena__free(chunked);
+
+    dyn_arena_t* per_alloc =
+        dyn_arena__new_chunked(__CCMS__DYN_ARENA_CHUNK_SIZE, 0);
+    bench__row("dyn_arena_alloc_reset", "block_per_alloc", 1, max_sizes[s],
+               ops, run_arena(per_alloc));
+    dyn_arena__free(per_alloc);
+
+    bench__row("dyn_arena_alloc_reset", "malloc", 1, max_sizes[s], ops,
+               run_malloc());
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,126 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// Random 8-byte reads spread over a large arena, backed by regular pages
+// against huge pages. With the working set far beyond what the TLB covers,
+// nearly every read misses it, so the difference is mostly the cost of the
+// page walk. The arena size defaults to 512 MiB and can be set in MiB through
+// BENCH_HUGE_MIB.
+
+#include "bench.h"
+#include "ccms/arena/paged.h"
+#include "ccms/arena/static.h"
+#include "ccms/arena/virtual.h"
+
+#define READS 20000000
+
+static size_t arena_size(void) {
+  const char* env = getenv("BENCH_HUGE_MIB");
+  const long mib = env != NULL ? atol(env) : 0;
+  return MiB(mib > 0 ? _M_cast(size_t, mib) : 512);
+}
+
+static double run_flat(const uint8_t* data, const size_t size) {
+  uint64_t seed = 0x9E3779B97F4A7C15ull;
+  uint64_t sum = 0;
+  const double start = bench__now();
+
+  for (size_t i = 0; i < READS; i++) {
+    uint64_t word;
+    memcpy(&word, data + (bench__rand(&seed) % (size >> 3) << 3), 8);
+    sum += word;
+  }
+
+  const double seconds = bench__now() - start;
+  bench__use(&sum);
+  return seconds;
+}
+
+static double run_paged(uint8_t** pages, const size_t npages,
+                        const size_t page_size) {
+  uint64_t seed = 0x9E3779B97F4A7C15ull;
+  uint64_t sum = 0;
+  const double start = bench__now();
+
+  for (size_t i = 0; i < READS; i++) {
+    const uint64_t r = bench__rand(&seed);
+    uint64_t word;
+    memcpy(&word, pages[r % npages] + ((r >> 32) % (page_size >> 3) << 3), 8);
+    sum += word;
+  }
+
+  const double seconds = bench__now() - start;
+  bench__use(&sum);
+  return seconds;
+}
+
+static void bench_st_arena(const char* variant, st_arena_t* arena) {
+  const size_t size = st_arena__cap(arena);
+  uint8_t* data = st_arena__alloc(arena, size);
+
+  memset(data, 1, size);
+  bench__row("arena_random_read", variant, 1, size, READS,
+             run_flat(data, size));
+  st_arena__free(arena);
+}
+
+static void bench_vm_arena(const char* variant, vm_arena_t* arena,
+                           const size_t size) {
+  uint8_t* data = vm_arena__alloc(arena, size);
+
+  memset(data, 1, size);
+  bench__row("arena_random_read", variant, 1, size, READS,
+             run_flat(data, size));
+  vm_arena__free(arena);
+}
+
+static void bench_pg_arena(const char* variant, pg_arena_t* arena,
+                           const size_t size) {
+  const size_t npages = size / arena->page_size;
+  uint8_t** pages = _M_new_arr(uint8_t*, npages);
+
+  for (size_t i = 0; i < npages; i++) {
+    pages[i] = pg_arena__alloc(arena, arena->page_size);
+    memset(pages[i], 1, arena->page_size);
+  }
+  bench__row("arena_random_read", variant, 1, npages * arena->page_size,
+             READS, run_paged(pages, npages, arena->page_size));
+
+  _M_free(pages);
+  pg_arena__free(arena);
+}
+
+int main(void) {
+  const size_t size = arena_size();
+
+  bench__header();
+
+  bench_st_arena("st_arena", st_arena__new(size));
+  bench_st_arena("st_arena_huge", st_arena__new_huge(size));
+
+  bench_vm_arena("vm_arena", vm_arena__new(size), size);
+  bench_vm_arena("vm_arena_huge", vm_arena__new_huge(size), size);
+
+  // Same usable page size in both, so only the backing differs
+  pg_arena_t* huge = pg_arena__new_huge(MiB(2));
+  bench_pg_arena("pg_arena", pg_arena__new(huge->page_size), size);
+  bench_pg_arena("pg_arena_huge", huge, size);
+
+  return EXIT_SUCCESS;
+}
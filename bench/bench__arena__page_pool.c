@@ -0,0 +1,71 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// Multi-threaded page churn: every thread owns a pg_arena_t, fills a couple of
+// pages and hard-resets it again, so every round acquires and releases pages.
+// Compares arenas that get their pages from _M_alloc against arenas sharing a
+// lock-free pg_pool_t.
+
+#include "bench.h"
+#include "ccms/arena/paged.h"
+
+#define PAGE_SIZE 4096
+#define CHUNK_SIZE 64
+#define PAGES_PER_ROUND 16
+#define ROUNDS 20000
+
+typedef struct {
+  pg_pool_t* pool;
+} ctx_t;
+
+static void worker(void* arg, size_t tid) {
+  ctx_t* ctx = (ctx_t*)arg;
+  pg_arena_t* arena = ctx->pool != NULL ? pg_arena__new_pooled(ctx->pool)
+                                        : pg_arena__new(PAGE_SIZE);
+
+  for (size_t round = 0; round < ROUNDS; round++) {
+    for (size_t i = 0; i < PAGES_PER_ROUND * (PAGE_SIZE / CHUNK_SIZE); i++)
+      bench__use(pg_arena__alloc(arena, CHUNK_SIZE));
+    pg_arena__hard_reset(arena);
+  }
+
+  pg_arena__free(arena);
+  (void)tid;
+}
+
+int main(void) {
+  const size_t ops_per_thread =
+      (size_t)ROUNDS * PAGES_PER_ROUND * (PAGE_SIZE / CHUNK_SIZE);
+
+  bench__header();
+  for (size_t nthreads = 1; nthreads <= bench__nthreads_max(); nthreads *= 2) {
+    ctx_t ctx = {.pool = NULL};
+    double seconds = bench__run_threads(nthreads, worker, &ctx);
+    bench__row("pg_arena_page_churn", "malloc", nthreads, CHUNK_SIZE,
+               ops_per_thread * nthreads, seconds);
+
+    ctx.pool = pg_arena__new_pool(PAGE_SIZE, 4096);
+    seconds = bench__run_threads(nthreads, worker, &ctx);
+    bench__row("pg_arena_page_churn", "pool", nthreads, CHUNK_SIZE,
+               ops_per_thread * nthreads, seconds);
+    pg_pool__free(ctx.pool);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// Byte string kernels on buffers from 8 B up to 1 MiB: box__eq and box__cmp
+// against memcmp on two equal buffers (the whole buffer has to be read), and
+// box__hash against 64 bit FNV-1a. Reports the operations and the bytes
+// processed per second.
+
+#include "bench.h"
+#include "ccms/box.h"
+
+#define MAX_SIZE (1024 * 1024)
+#define BYTES_PER_RUN (256ull * 1024 * 1024)
+#define REPEAT 3
+
+static uint64_t fnv1a(const uint8_t* ptr, const size_t size) {
+  uint64_t hash = 0xCBF29CE484222325ull;
+
+  for (size_t i = 0; i < size; i++)
+    hash = (hash ^ ptr[i]) * 0x100000001B3ull;
+
+  return hash;
+}
+
+enum { EQ, CMP, MEMCMP, HASH, FNV };
+
+static void run(const char* bench,
+                const char* variant,
+                const int kernel,
+                const box_t a,
+                const box_t b) {
+  const size_t iters = BYTES_PER_RUN / a.size;
+  uint64_t sum = 0;
+
+  const double start = bench__now();
+  for (size_t i = 0; i < iters; i++) {
+    // Forces the buffers to be read again in every iteration
+    bench__use(a.ptr);
+    switch (kernel) {
+      case EQ:
+        sum += box__eq(a, b);
+        break;
+      case CMP:
+        sum += box__cmp(a, b);
+        break;
+      case MEMCMP:
+        sum += memcmp(a.ptr, b.ptr, a.size);
+        break;
+      case HASH:
+        sum += box__hash(a);
+        break;
+      case FNV:
+        sum += fnv1a(a.ptr, a.size);
+        break;
+    }
+  }
+  const double seconds = bench__now() - start;
+
+  bench__use(&sum);
+  bench__row(bench, variant, 1, a.size, iters, seconds);
+  bench__metric(bench, variant, 1, a.size, "gb_per_sec",
+                iters * a.size / seconds / 1e9);
+}
+
+int main(void) {
+  uint8_t* a = malloc(MAX_SIZE);
+  uint8_t* b = malloc(MAX_SIZE);
+  uint64_t seed = 42;
+  const size_t sizes[] = {8, 16, 64, 256, 1024, 4096, 65536, MAX_SIZE};
+
+  for (size_t i = 0; i < MAX_SIZE; i++)
+    a[i] = b[i] = (uint8_t)bench__rand(&seed);
+
+  bench__header();
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    const box_t x = box__ctor(a, sizes[s]), y = box__ctor(b, sizes[s]);
+
+    for (size_t r = 0; r < REPEAT; r++) {
+      run("box_eq", "box__eq", EQ, x, y);
+      run("box_eq", "box__cmp", CMP, x, y);
+      run("box_eq", "memcmp", MEMCMP, x, y);
+      run("box_hash", "box__hash", HASH, x, y);
+      run("box_hash", "fnv1a", FNV, x, y);
+    }
+  }
+
+  free(a);
+  free(b);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// Insert and lookup throughput of box_map_t with 16 byte keys, from 1K entries
+// up to BENCH_MAP_MAX entries (default 10M, 100M needs about 8 GiB of memory),
+// with the map on _M_alloc and on a pg_arena_t.
+
+#include "bench.h"
+#include "ccms/box_map.h"
+
+#define KEY_SIZE 16
+
+static uint8_t* make_keys(const size_t n, uint64_t seed) {
+  uint8_t* keys = malloc(n * KEY_SIZE);
+
+  for (size_t i = 0; i < n * KEY_SIZE; i += 8) {
+    const uint64_t word = bench__rand(&seed);
+    memcpy(keys + i, &word, 8);
+  }
+
+  return keys;
+}
+
+static void run(const char* variant,
+                allocator_t alloc,
+                const uint8_t* keys,
+                const uint8_t* misses,
+                const size_t n) {
+  box_map_t* map = box_map__new(alloc);
+
+  double start = bench__now();
+  for (size_t i = 0; i < n; i++)
+    box_map__insert(map, box__ctor(_M_cast(uint8_t*, keys + i * KEY_SIZE),
+                                   KEY_SIZE),
+                    i);
+  bench__row("box_map_insert", variant, 1, n, n, bench__now() - start);
+
+  // Look up every key in a different order than they were inserted
+  const size_t lookups = n < 10000000 ? 10000000 : n;
+  uint64_t seed = 7, sum = 0;
+
+  start = bench__now();
+  for (size_t i = 0; i < lookups; i++) {
+    const size_t j = bench__rand(&seed) % n;
+    sum += *box_map__get(
+        map, box__ctor(_M_cast(uint8_t*, keys + j * KEY_SIZE), KEY_SIZE));
+  }
+  bench__row("box_map_get_hit", variant, 1, n, lookups, bench__now() - start);
+
+  start = bench__now();
+  for (size_t i = 0; i < lookups; i++) {
+    const size_t j = bench__rand(&seed) % n;
+    sum += box_map__get(map, box__ctor(_M_cast(uint8_t*, misses +
+                                                             j * KEY_SIZE),
+                                       KEY_SIZE)) != NULL;
+  }
+  bench__row("box_map_get_miss", variant, 1, n, lookups,
+             bench__now() - start);
+
+  bench__use(_M_cast(void*, _M_cast(uintptr_t, sum)));
+  box_map__free(map);
+}
+
+int main(void) {
+  const char* env = getenv("BENCH_MAP_MAX");
+  const size_t max = env != NULL ? strtoull(env, NULL, 10) : 10000000;
+
+  bench__header();
+  for (size_t n = 1000; n <= max; n *= 10) {
+    uint8_t* keys = make_keys(n, 42);
+    uint8_t* misses = make_keys(n, 43);
+
+    run("malloc", allocator__malloc(), keys, misses, n);
+
+    pg_arena_t* arena = pg_arena__new(MiB(1));
+    run("pg_arena", allocator__pg_arena(arena), keys, misses, n);
+    pg_arena__free(arena);
+
+    free(keys);
+    free(misses);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,137 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// Every thread alternately enqueues and dequeues on one shared queue, so the
+// queue stays close to empty and producers and consumers always contend. The
+// lock-free mpmc_queue_t (single items, and batches of BATCH items) against a
+// ring buffer guarded by a mutex. Set BENCH_THREADS=64 for the full range.
+
+#include <sched.h>
+
+#include "bench.h"
+#include "ccms/mpmc_queue.h"
+
+#define CAP 1024
+#define BATCH 16
+#define OPS 4000000
+#define REPEAT 5
+
+typedef struct {
+  mpmc_queue_t* queue;
+  size_t ops_per_thread;
+  pthread_mutex_t lock;
+  void** ring;
+  size_t head;
+  size_t tail;
+} ctx_t;
+
+static void worker_single(void* arg, size_t tid) {
+  ctx_t* ctx = (ctx_t*)arg;
+  void* item = &ctx;
+
+  for (size_t i = 0; i < ctx->ops_per_thread; i++) {
+    while (!mpmc_queue__try_enqueue(ctx->queue, item))
+      sched_yield();
+    while (!mpmc_queue__try_dequeue(ctx->queue, &item))
+      sched_yield();
+  }
+  bench__use(item);
+  (void)tid;
+}
+
+static void worker_batch(void* arg, size_t tid) {
+  ctx_t* ctx = (ctx_t*)arg;
+  void* items[BATCH];
+
+  for (size_t k = 0; k < BATCH; k++)
+    items[k] = &items[k];
+
+  for (size_t i = 0; i < ctx->ops_per_thread; i += BATCH) {
+    for (size_t k = 0; k < BATCH;) {
+      const size_t n =
+          mpmc_queue__try_enqueue_batch(ctx->queue, items + k, BATCH - k);
+      if (n == 0) sched_yield();
+      k += n;
+    }
+    for (size_t k = 0; k < BATCH;) {
+      const size_t n =
+          mpmc_queue__try_dequeue_batch(ctx->queue, items + k, BATCH - k);
+      if (n == 0) sched_yield();
+      k += n;
+    }
+  }
+  bench__use(items[0]);
+  (void)tid;
+}
+
+static void worker_mutex(void* arg, size_t tid) {
+  ctx_t* ctx = (ctx_t*)arg;
+  void* item = &ctx;
+
+  for (size_t i = 0; i < ctx->ops_per_thread; i++) {
+    pthread_mutex_lock(&ctx->lock);
+    ctx->ring[ctx->tail++ % CAP] = item;
+    pthread_mutex_unlock(&ctx->lock);
+
+    for (;;) {
+      pthread_mutex_lock(&ctx->lock);
+      const int empty = ctx->head == ctx->tail;
+      if (!empty) item = ctx->ring[ctx->head++ % CAP];
+      pthread_mutex_unlock(&ctx->lock);
+      if (!empty) break;
+      sched_yield();
+    }
+  }
+  bench__use(item);
+  (void)tid;
+}
+
+int main(void) {
+  st_arena_t* arena = st_arena__new(mpmc_queue__buffer_size(CAP) + KiB(4));
+  ctx_t ctx;
+
+  ctx.queue = mpmc_queue__new(arena, CAP);
+  ctx.ring = malloc(CAP * sizeof(void*));
+  pthread_mutex_init(&ctx.lock, NULL);
+
+  bench__header();
+  for (size_t nthreads = 1; nthreads <= bench__nthreads_max(); nthreads *= 2) {
+    // The total number of transfers stays the same for every thread count, a
+    // thread holds at most BATCH items so the queue never fills up
+    ctx.ops_per_thread = OPS / nthreads / BATCH * BATCH;
+    const size_t ops = 2 * ctx.ops_per_thread * nthreads;
+
+    for (size_t r = 0; r < REPEAT; r++) {
+      bench__row("mpmc_queue", "single", nthreads, sizeof(void*), ops,
+                 bench__run_threads(nthreads, worker_single, &ctx));
+      bench__row("mpmc_queue", "batch", nthreads, sizeof(void*), ops,
+                 bench__run_threads(nthreads, worker_batch, &ctx));
+
+      ctx.head = ctx.tail = 0;
+      bench__row("mpmc_queue", "mutex", nthreads, sizeof(void*), ops,
+                 bench__run_threads(nthreads, worker_mutex, &ctx));
+    }
+  }
+
+  pthread_mutex_destroy(&ctx.lock);
+  free(ctx.ring);
+  st_arena__free(arena);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,141 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// Push and iterate throughput of vectors from vec__define on different
+// allocators, against a hand-written vector that calls realloc on every push
+// (realloc_naive) and one that doubles its capacity with realloc
+// (realloc_doubling).
+
+#include "bench.h"
+#include "ccms/vec.h"
+
+vec__define(u64_vec, uint64_t)
+
+typedef struct naive_vec_t {
+  uint64_t* data;
+  size_t len;
+  size_t cap;
+} naive_vec_t;
+
+static void naive_vec__push(naive_vec_t* self, uint64_t value, int doubling) {
+  if (self->len == self->cap) {
+    self->cap = doubling ? (self->cap ? self->cap * 2 : 8) : self->len + 1;
+    self->data = realloc(self->data, self->cap * sizeof(uint64_t));
+  }
+  self->data[self->len++] = value;
+}
+
+static uint64_t sum(const uint64_t* data, const size_t len) {
+  uint64_t result = 0;
+  for (size_t i = 0; i < len; i++)
+    result += data[i];
+  return result;
+}
+
+static void run_naive(const char* variant,
+                      const int doubling,
+                      const size_t len,
+                      const size_t rounds) {
+  double push = 0, iterate = 0;
+
+  for (size_t round = 0; round < rounds; round++) {
+    naive_vec_t vec = {NULL, 0, 0};
+
+    double start = bench__now();
+    for (size_t i = 0; i < len; i++)
+      naive_vec__push(&vec, i, doubling);
+    push += bench__now() - start;
+
+    start = bench__now();
+    bench__use(_M_cast(void*, _M_cast(uintptr_t, sum(vec.data, vec.len))));
+    iterate += bench__now() - start;
+
+    free(vec.data);
+  }
+
+  bench__row("vec_push", variant, 1, len, len * rounds, push);
+  bench__row("vec_iterate", variant, 1, len, len * rounds, iterate);
+}
+
+// `reset` is called after every round to give the storage back
+static void run_vec(const char* variant,
+                    allocator_t alloc,
+                    void (*reset)(void*),
+                    const size_t len,
+                    const size_t rounds) {
+  double push = 0, iterate = 0;
+
+  for (size_t round = 0; round < rounds; round++) {
+    u64_vec_t vec = u64_vec__ctor(alloc);
+
+    double start = bench__now();
+    for (size_t i = 0; i < len; i++)
+      u64_vec__push(&vec, i);
+    push += bench__now() - start;
+
+    start = bench__now();
+    bench__use(_M_cast(void*, _M_cast(uintptr_t, sum(vec.data, vec.len))));
+    iterate += bench__now() - start;
+
+    u64_vec__free(&vec);
+    if (reset != NULL) reset(alloc.ctx);
+  }
+
+  bench__row("vec_push", variant, 1, len, len * rounds, push);
+  bench__row("vec_iterate", variant, 1, len, len * rounds, iterate);
+}
+
+static void reset_st(void* arena) {
+  st_arena__reset(_M_cast(st_arena_t*, arena));
+}
+
+static void reset_pg(void* arena) {
+  pg_arena__reset(_M_cast(pg_arena_t*, arena));
+}
+
+static void reset_vm(void* arena) {
+  vm_arena__reset(_M_cast(vm_arena_t*, arena));
+}
+
+int main(void) {
+  const size_t lens[] = {1000, 100000, 10000000};
+
+  bench__header();
+  for (size_t l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) {
+    const size_t len = lens[l];
+    const size_t rounds = 100000000 / len;
+
+    st_arena_t* st_arena = st_arena__new(4 * len * sizeof(uint64_t));
+    pg_arena_t* pg_arena = pg_arena__new(KiB(64));
+    vm_arena_t* vm_arena = vm_arena__new(GiB(_M_cast(size_t, 1)));
+
+    run_naive("realloc_naive", 0, len, rounds);
+    run_naive("realloc_doubling", 1, len, rounds);
+    run_vec("malloc", allocator__malloc(), NULL, len, rounds);
+    run_vec("st_arena", allocator__st_arena(st_arena), reset_st, len, rounds);
+    run_vec("pg_arena", allocator__pg_arena(pg_arena), reset_pg, len, rounds);
+    run_vec("vm_arena", allocator__vm_arena(vm_arena), reset_vm, len, rounds);
+
+    st_arena__free(st_arena);
+    pg_arena__free(pg_arena);
+    vm_arena__free(vm_arena);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -30,9 +30,10 @@ int32_t main(void) {
       _M_cast(int32_t*, pg_arena__alloc(arena, sizeof(int32_t) * 10));
   assert(arr0 != NULL);
 
+  // larger than a page, gets a block of its own
   int32_t* arr1 =
       _M_cast(int32_t*, pg_arena__alloc(arena, sizeof(int32_t) * 16));
-  assert(arr1 == NULL);
+  assert(arr1 != NULL);
 
   pg_arena__free(arena);
   return EXIT_SUCCESS;
@@ -26,4 +26,36 @@
 #define __CCMS__INLINE static inline
 #endif
 
+// C11 atomics are needed by the lock-free / concurrent structures. They are
+// not available from C++ (before C++23) or on compilers that opt out of them.
+#if !defined(__cplusplus) && !defined(__STDC_NO_ATOMICS__) && \
+    defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define __CCMS__HAS_ATOMICS
+#endif
+
+// SIMD code paths are picked from the instruction sets the compiler targets
+// (e.g. -mavx2 or -march=native for AVX2). Define __CCMS__NO_SIMD to always
+// use the portable scalar versions instead.
+#ifndef __CCMS__NO_SIMD
+#if defined(__AVX2__)
+#define __CCMS__HAS_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define __CCMS__HAS_SSE2
+#endif
+#endif
+
+// Alignment (in bytes) used by the plain `*_alloc` functions of all arenas.
+// Must be a power of two. The default of 1 packs allocations back to back;
+// define it to e.g. 8 or 16 before including any ccms header to get naturally
+// aligned allocations everywhere without calling `*_alloc_aligned`.
+#ifndef __CCMS__DEFAULT_ALIGN
+#define __CCMS__DEFAULT_ALIGN 1
+#endif
+
+// Define __CCMS__ARENA_STATS to have every arena keep allocation statistics
+// up to date as it goes (see ccms/arena/stats.h and the `*_stats` functions).
+// Without it, neither the counters nor the code updating them exist.
+
 #endif  // __CCMS__DEFS_H
\ No newline at end of file
@@ -24,6 +24,8 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
+
 #define _M_cast(T, expr) ((T)(expr))
 
 #define _M_addr(expr) (&(expr))
@@ -40,10 +42,57 @@ extern "C" {
 #define _M_free(ptr) free(ptr)
 #endif
 
+#ifndef _M_realloc
+#include <stdlib.h>
+
+#define _M_realloc(ptr, size) realloc(ptr, size)
+#endif
+
+// Allocates `size` bytes aligned to `align` (a power of two), `size` has to be
+// a multiple of `align`. Memory from _M_alloc_aligned has to be released with
+// _M_free_aligned.
+#ifndef _M_alloc_aligned
+#if defined(_WIN32)
+#include <malloc.h>
+
+#define _M_alloc_aligned(align, size) _aligned_malloc(size, align)
+#else
+#include <stdlib.h>
+
+#define _M_alloc_aligned(align, size) aligned_alloc(align, size)
+#endif
+#endif
+
+#ifndef _M_free_aligned
+#if defined(_WIN32)
+#include <malloc.h>
+
+#define _M_free_aligned(ptr) _aligned_free(ptr)
+#else
+#include <stdlib.h>
+
+#define _M_free_aligned(ptr) free(ptr)
+#endif
+#endif
+
 #define _M_new(T) _M_cast(T*, _M_alloc(sizeof(T)))
 
 #define _M_new_arr(T, len) _M_cast(T*, _M_alloc(sizeof(T) * len))
 
+#ifdef __cplusplus
+#define _M_alignof(T) alignof(T)
+#else
+#define _M_alignof(T) _Alignof(T)
+#endif
+
+#define _M_MAX_ALIGN _M_alignof(max_align_t)
+
+#define _M_is_pow2(n) ((n) != 0 && ((n) & ((n) - 1)) == 0)
+
+#define _M_align_up(n, align) (((n) + ((align) - 1)) & ~((align) - 1))
+
+#define _M_align_pad(n, align) (_M_align_up(n, align) - (n))
+
 #ifndef __CCMS__NO_SIZE_MACROS
 
 #define KiB(n) ((n) * 1024)
@@ -0,0 +1,478 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+#ifndef __CCMS___OS__H
+#define __CCMS___OS__H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ccms/_defs.h"
+#include "ccms/_macros.h"
+
+// Thin wrappers around the virtual memory API of the operating system, used by
+// the structures that work with reserved address space or mapped memory
+// instead of _M_alloc. __CCMS__HAS_VMEM is defined if they are available.
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#define __CCMS__HAS_VMEM
+#elif defined(__unix__) || defined(__APPLE__)
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+
+// The MAP_* / MADV_* extensions are hidden in strict ISO C mode (-std=c11)
+// unless _GNU_SOURCE or _DEFAULT_SOURCE is defined
+#ifdef MAP_ANONYMOUS
+#define __CCMS__HAS_VMEM
+#endif
+#endif
+
+// Size and alignment of the memory of arenas created with *_new_huge, the size
+// of a (transparent) huge page on x86-64 and most ARM64 systems.
+#ifndef __CCMS__HUGE_PAGE_SIZE
+#define __CCMS__HUGE_PAGE_SIZE 2097152
+#endif
+
+// Define __CCMS__USE_HUGETLB to try explicit huge pages (MAP_HUGETLB, which
+// need pages reserved in /proc/sys/vm/nr_hugepages) before transparent ones.
+
+#ifdef __CCMS__HAS_VMEM
+
+__CCMS__INLINE
+size_t _os__page_size(void) {
+#if defined(_WIN32)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return _M_cast(size_t, info.dwPageSize);
+#else
+  return _M_cast(size_t, sysconf(_SC_PAGESIZE));
+#endif
+}
+
+// Reserves `size` bytes of address space without backing them with memory.
+// Returns NULL on failure.
+__CCMS__INLINE
+uint8_t* _os__reserve(const size_t size) {
+#if defined(_WIN32)
+  return _M_cast(uint8_t*,
+                 VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS));
+#else
+  void* ptr = mmap(NULL, size, PROT_NONE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  return ptr == MAP_FAILED ? NULL : _M_cast(uint8_t*, ptr);
+#endif
+}
+
+__CCMS__INLINE
+void _os__release(uint8_t* ptr, const size_t size) {
+#if defined(_WIN32)
+  VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+  munmap(ptr, size);
+#endif
+}
+
+// Reserves `size` bytes of address space starting at a multiple of `align`
+// (a power of two multiple of the page size). Returns NULL on failure.
+__CCMS__INLINE
+uint8_t* _os__reserve_aligned(const size_t size, const size_t align) {
+#if defined(_WIN32)
+  // Reserving more and giving back the ends is not possible with
+  // VirtualAlloc, so an aligned address is looked up and then reserved on its
+  // own, which can fail if another thread takes it in between
+  for (int attempt = 0; attempt < 16; attempt++) {
+    uint8_t* probe = _os__reserve(size + align);
+    if (probe == NULL) return NULL;
+    _os__release(probe, size + align);
+
+    uint8_t* ptr = _M_cast(
+        uint8_t*,
+        VirtualAlloc(_M_cast(uint8_t*, _M_align_up(_M_cast(uintptr_t, probe),
+                                                   _M_cast(uintptr_t, align))),
+                     size, MEM_RESERVE, PAGE_NOACCESS));
+    if (ptr != NULL) return ptr;
+  }
+  return NULL;
+#else
+  uint8_t* probe = _os__reserve(size + align);
+  if (probe == NULL) return NULL;
+
+  uint8_t* ptr = _M_cast(uint8_t*, _M_align_up(_M_cast(uintptr_t, probe),
+                                               _M_cast(uintptr_t, align)));
+  if (ptr > probe) munmap(probe, _M_cast(size_t, ptr - probe));
+  if (ptr + size < probe + size + align)
+    munmap(ptr + size, _M_cast(size_t, probe + size + align - (ptr + size)));
+
+  return ptr;
+#endif
+}
+
+// Makes a page aligned range of reserved address space readable and writable.
+// Returns 0 on success.
+__CCMS__INLINE
+int _os__commit(uint8_t* ptr, const size_t size) {
+#if defined(_WIN32)
+  return VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) != NULL ? 0 : -1;
+#else
+  return mprotect(ptr, size, PROT_READ | PROT_WRITE);
+#endif
+}
+
+// Hands the memory behind a page aligned range back to the operating system
+// and makes it inaccessible again. The address space stays reserved.
+__CCMS__INLINE
+void _os__decommit(uint8_t* ptr, const size_t size) {
+#if defined(_WIN32)
+  VirtualFree(ptr, size, MEM_DECOMMIT);
+#else
+  madvise(ptr, size, MADV_DONTNEED);
+  mprotect(ptr, size, PROT_NONE);
+#endif
+}
+
+// Maps `size` bytes of shared memory twice, back to back, so that
+// ptr[i] and ptr[size + i] are the same byte. `size` has to be a multiple of
+// 64 KiB (the allocation granularity on Windows). Returns NULL on failure.
+__CCMS__INLINE
+uint8_t* _os__map_mirrored(const size_t size) {
+#if defined(_WIN32)
+  HANDLE mapping = CreateFileMappingA(
+      INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+      _M_cast(DWORD, _M_cast(uint64_t, size) >> 32), _M_cast(DWORD, size),
+      NULL);
+  if (mapping == NULL) return NULL;
+
+  // The address range found by VirtualAlloc can be taken by another thread
+  // before both views are mapped into it, so this is retried a few times
+  for (int attempt = 0; attempt < 16; attempt++) {
+    uint8_t* base = _M_cast(
+        uint8_t*, VirtualAlloc(NULL, 2 * size, MEM_RESERVE, PAGE_NOACCESS));
+    if (base == NULL) break;
+    VirtualFree(base, 0, MEM_RELEASE);
+
+    void* lo =
+        MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, base);
+    void* hi = lo == NULL ? NULL
+                          : MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0,
+                                            size, base + size);
+
+    if (hi != NULL) {
+      // The views keep the mapping alive
+      CloseHandle(mapping);
+      return base;
+    }
+    if (lo != NULL) UnmapViewOfFile(lo);
+  }
+
+  CloseHandle(mapping);
+  return NULL;
+#else
+  int fd = -1;
+
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+  fd = memfd_create("ccms-mirror", MFD_CLOEXEC);
+#endif
+
+  // Without memfd, fall back to a POSIX shared memory object that is unlinked
+  // right away, so only the mappings keep it alive
+  for (unsigned attempt = 0; fd < 0 && attempt < 16; attempt++) {
+    char name[64];
+    snprintf(name, sizeof(name), "/ccms-mirror-%ld-%u",
+             _M_cast(long, getpid()), attempt);
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0)
+      shm_unlink(name);
+    else if (errno != EEXIST)
+      break;
+  }
+  if (fd < 0) return NULL;
+
+  uint8_t* base = NULL;
+
+  if (ftruncate(fd, _M_cast(off_t, size)) == 0) {
+    base = _os__reserve(2 * size);
+
+    if (base != NULL &&
+        (mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd,
+              0) == MAP_FAILED ||
+         mmap(base + size, size, PROT_READ | PROT_WRITE,
+              MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)) {
+      munmap(base, 2 * size);
+      base = NULL;
+    }
+  }
+
+  close(fd);
+  return base;
+#endif
+}
+
+__CCMS__INLINE
+void _os__unmap_mirrored(uint8_t* ptr, const size_t size) {
+#if defined(_WIN32)
+  UnmapViewOfFile(ptr);
+  UnmapViewOfFile(ptr + size);
+#else
+  munmap(ptr, 2 * size);
+#endif
+}
+
+// Maps the file at `path` into memory: read-only and shared with every other
+// mapping of the file, or (if `writable`) private and copy-on-write, so that
+// writes never reach the file. An empty file gives a NULL mapping of size 0.
+// Returns 0 on success.
+__CCMS__INLINE
+int _os__map_file(const char* path,
+                  const int writable,
+                  uint8_t** ptr,
+                  size_t* size) {
+#if defined(_WIN32)
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  LARGE_INTEGER length;
+
+  if (file == INVALID_HANDLE_VALUE) return -1;
+  if (!GetFileSizeEx(file, &length)) {
+    CloseHandle(file);
+    return -1;
+  }
+
+  *ptr = NULL;
+  *size = _M_cast(size_t, length.QuadPart);
+  if (*size > 0) {
+    HANDLE mapping = CreateFileMappingA(
+        file, NULL, writable ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
+    if (mapping != NULL) {
+      *ptr = _M_cast(uint8_t*,
+                     MapViewOfFile(mapping,
+                                   writable ? FILE_MAP_COPY : FILE_MAP_READ, 0,
+                                   0, 0));
+      // The view keeps the mapping and the file alive
+      CloseHandle(mapping);
+    }
+  }
+
+  CloseHandle(file);
+  return *size > 0 && *ptr == NULL ? -1 : 0;
+#else
+  struct stat info;
+  const int fd = open(path, O_RDONLY);
+
+  if (fd < 0) return -1;
+  if (fstat(fd, &info) != 0) {
+    close(fd);
+    return -1;
+  }
+
+  *ptr = NULL;
+  *size = _M_cast(size_t, info.st_size);
+  if (*size > 0) {
+    void* map = writable ? mmap(NULL, *size, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE, fd, 0)
+                         : mmap(NULL, *size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map != MAP_FAILED) *ptr = _M_cast(uint8_t*, map);
+  }
+
+  // The mapping keeps the file alive
+  close(fd);
+  return *size > 0 && *ptr == NULL ? -1 : 0;
+#endif
+}
+
+__CCMS__INLINE
+void _os__unmap_file(uint8_t* ptr, const size_t size) {
+  if (ptr == NULL) return;
+#if defined(_WIN32)
+  UnmapViewOfFile(ptr);
+#else
+  munmap(ptr, size);
+#endif
+}
+
+// Makes the file at `path` the start of the reserved range at `base` (of
+// `reserved` bytes), readable, writable and private: it is mapped
+// copy-on-write on POSIX systems and read into committed memory on Windows,
+// where files can not be mapped into reserved address space. The rest of the
+// range stays reserved. Stores the size of the file in `size`. Returns 0 on
+// success, -1 if the file can not be read or does not fit.
+__CCMS__INLINE
+int _os__load_file(const char* path,
+                   uint8_t* base,
+                   const size_t reserved,
+                   size_t* size) {
+#if defined(_WIN32)
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  LARGE_INTEGER length;
+  int result = -1;
+
+  if (file == INVALID_HANDLE_VALUE) return -1;
+  if (GetFileSizeEx(file, &length) &&
+      _M_cast(uint64_t, length.QuadPart) <= reserved) {
+    *size = _M_cast(size_t, length.QuadPart);
+    result = _os__commit(base, _M_align_up(*size, _os__page_size()));
+
+    for (size_t pos = 0; result == 0 && pos < *size;) {
+      const size_t left = *size - pos;
+      DWORD chunk = _M_cast(DWORD, left < (1u << 30) ? left : (1u << 30));
+      DWORD read = 0;
+      if (!ReadFile(file, base + pos, chunk, &read, NULL) || read == 0)
+        result = -1;
+      pos += read;
+    }
+  }
+
+  CloseHandle(file);
+  return result;
+#else
+  struct stat info;
+  const int fd = open(path, O_RDONLY);
+  int result = -1;
+
+  if (fd < 0) return -1;
+  if (fstat(fd, &info) == 0 && _M_cast(size_t, info.st_size) <= reserved) {
+    *size = _M_cast(size_t, info.st_size);
+    result = *size == 0 || mmap(base, *size, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_FIXED, fd,
+                                0) != MAP_FAILED
+                 ? 0
+                 : -1;
+  }
+
+  close(fd);
+  return result;
+#endif
+}
+
+typedef enum _os_advice_t {
+  _OS_ADVICE_NORMAL,
+  _OS_ADVICE_SEQUENTIAL,
+  _OS_ADVICE_RANDOM,
+  _OS_ADVICE_WILLNEED,
+  _OS_ADVICE_HUGEPAGE,
+  _OS_ADVICE_DONTNEED,
+} _os_advice_t;
+
+// Tells the operating system how a page aligned range of mapped memory is
+// going to be used. Returns 0 on success, -1 if the hint is not supported.
+// With _OS_ADVICE_DONTNEED the memory is given back while the range stays
+// usable; its contents are lost (zero on Linux, undefined elsewhere).
+__CCMS__INLINE
+int _os__advise(uint8_t* ptr, const size_t size, const _os_advice_t advice) {
+  if (size == 0) return 0;
+#if defined(_WIN32)
+  // Windows only knows about prefetching, the other hints are ignored. Large
+  // pages can not be requested for memory that is already mapped.
+  if (advice == _OS_ADVICE_WILLNEED) {
+#if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0602
+    WIN32_MEMORY_RANGE_ENTRY range = {ptr, size};
+    return PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0) ? 0 : -1;
+#else
+    return -1;
+#endif
+  }
+  if (advice == _OS_ADVICE_DONTNEED)
+    return VirtualAlloc(ptr, size, MEM_RESET, PAGE_READWRITE) != NULL ? 0 : -1;
+  return advice == _OS_ADVICE_HUGEPAGE ? -1 : 0;
+#else
+  int flag = MADV_NORMAL;
+
+  switch (advice) {
+    case _OS_ADVICE_NORMAL:
+      flag = MADV_NORMAL;
+      break;
+    case _OS_ADVICE_SEQUENTIAL:
+      flag = MADV_SEQUENTIAL;
+      break;
+    case _OS_ADVICE_RANDOM:
+      flag = MADV_RANDOM;
+      break;
+    case _OS_ADVICE_WILLNEED:
+      flag = MADV_WILLNEED;
+      break;
+    case _OS_ADVICE_HUGEPAGE:
+#ifdef MADV_HUGEPAGE
+      flag = MADV_HUGEPAGE;
+      break;
+#else
+      return -1;
+#endif
+    case _OS_ADVICE_DONTNEED:
+      flag = MADV_DONTNEED;
+      break;
+  }
+
+  return madvise(ptr, size, flag) == 0 ? 0 : -1;
+#endif
+}
+
+// Allocates readable and writable memory aligned to __CCMS__HUGE_PAGE_SIZE,
+// rounding `size` up to a multiple of it. The memory is backed by explicit
+// huge pages if __CCMS__USE_HUGETLB is defined and enough are available,
+// otherwise by transparent huge pages where the system supports them
+// (madvise(MADV_HUGEPAGE)) and by regular pages elsewhere. Free it with
+// _os__release. Returns NULL on failure.
+__CCMS__INLINE
+uint8_t* _os__alloc_huge(size_t* size) {
+  *size = _M_align_up(*size, _M_cast(size_t, __CCMS__HUGE_PAGE_SIZE));
+
+#if defined(__CCMS__USE_HUGETLB) && defined(MAP_HUGETLB)
+  void* explicit_huge = mmap(NULL, *size, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (explicit_huge != MAP_FAILED) return _M_cast(uint8_t*, explicit_huge);
+#endif
+
+  uint8_t* ptr = _os__reserve_aligned(*size, __CCMS__HUGE_PAGE_SIZE);
+  if (ptr == NULL) return NULL;
+  if (_os__commit(ptr, *size) != 0) {
+    _os__release(ptr, *size);
+    return NULL;
+  }
+
+  // Only a hint, regular pages are fine as well
+  _os__advise(ptr, *size, _OS_ADVICE_HUGEPAGE);
+  return ptr;
+}
+
+#endif  // __CCMS__HAS_VMEM
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __CCMS___OS__H
@@ -0,0 +1,262 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+#ifndef __CCMS__ALLOC__BUDDY__H
+#define __CCMS__ALLOC__BUDDY__H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef __CCMS__SUPPRESS_WARNINGS
+#include <stdio.h>
+#endif
+
+#include "ccms/_defs.h"
+#include "ccms/_macros.h"
+#include "ccms/arena/static.h"
+
+// A buddy allocator over a fixed budget of memory. The whole allocator (its
+// header, metadata and the managed region) lives in a single st_arena_t, so
+// after buddy__new no memory is requested from _M_alloc anymore.
+//
+// The region is split into blocks of power of two sizes between `min_block`
+// and the largest power of two that fits. A request is served by the smallest
+// free block it fits into, splitting larger blocks in halves as needed. Freed
+// blocks are merged with their buddy (the other half of the block they were
+// split from) as long as that one is free as well. Both take O(log n).
+
+#define _BUDDY_FREE 0x80
+
+typedef struct _buddy_node_t _buddy_node_t;
+
+// Kept in the first bytes of every free block
+struct _buddy_node_t {
+  _buddy_node_t *next, *prev;
+};
+
+typedef struct buddy_t buddy_t;
+
+struct buddy_t {
+  st_arena_t* arena;
+  uint8_t* base;
+  size_t size;
+  // Order (log2 of the size) of the block starting at each multiple of
+  // min_block, or'ed with _BUDDY_FREE for free blocks. Entries that are not
+  // the start of a block are stale.
+  uint8_t* orders;
+  // Free list per order, indexed by order - min_order
+  _buddy_node_t** free;
+  size_t min_order;
+  size_t max_order;
+  // Bytes handed out in blocks
+  size_t used;
+};
+
+__CCMS__INLINE
+void _buddy__push(buddy_t* self, const size_t offset, const size_t order) {
+  _buddy_node_t* node = _M_cast(_buddy_node_t*, self->base + offset);
+  _buddy_node_t** head = &self->free[order - self->min_order];
+
+  node->prev = NULL;
+  node->next = *head;
+  if (*head != NULL) (*head)->prev = node;
+  *head = node;
+
+  self->orders[offset >> self->min_order] =
+      _M_cast(uint8_t, order | _BUDDY_FREE);
+}
+
+__CCMS__INLINE
+void _buddy__remove(buddy_t* self, _buddy_node_t* node, const size_t order) {
+  if (node->prev != NULL)
+    node->prev->next = node->next;
+  else
+    self->free[order - self->min_order] = node->next;
+  if (node->next != NULL) node->next->prev = node->prev;
+}
+
+// Frees all blocks at once
+__CCMS__INLINE
+void buddy__reset(buddy_t* self) {
+  for (size_t order = self->min_order; order <= self->max_order; order++)
+    self->free[order - self->min_order] = NULL;
+
+  // Cover the region with the largest blocks that fit, every block ends up at
+  // an offset that is a multiple of its size
+  size_t offset = 0;
+  for (size_t order = self->max_order + 1; order-- > self->min_order;) {
+    if (self->size - offset >= _M_cast(size_t, 1) << order) {
+      _buddy__push(self, offset, order);
+      offset += _M_cast(size_t, 1) << order;
+    }
+  }
+
+  self->used = 0;
+}
+
+// Creates a buddy allocator managing `size` bytes (rounded down to a multiple
+// of `min_block`). `min_block` is the smallest block handed out and has to be
+// a power of two, it is raised to the size of two pointers if smaller. Blocks
+// are aligned to `min_block` or _M_MAX_ALIGN, whichever is larger.
+__CCMS__INLINE
+buddy_t* buddy__new(const size_t size, size_t min_block) {
+  if (min_block < sizeof(_buddy_node_t)) min_block = sizeof(_buddy_node_t);
+  if (min_block < _M_MAX_ALIGN) min_block = _M_MAX_ALIGN;
+
+  const size_t nblocks = size / min_block;
+
+  if (!_M_is_pow2(min_block) || nblocks == 0) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+    fprintf(stderr,
+            "warning: tried creating a buddy allocator of size %ld with "
+            "minimum block size %ld (needs to be a power of two no larger "
+            "than the size), returned NULL\n",
+            size, min_block);
+#endif
+    return NULL;
+  }
+
+  size_t min_order = 0, max_order = 0;
+  while ((_M_cast(size_t, 1) << min_order) < min_block)
+    min_order++;
+  while ((_M_cast(size_t, 2) << max_order) <= nblocks * min_block)
+    max_order++;
+
+  const size_t norders = max_order - min_order + 1;
+  st_arena_t* arena = st_arena__new(
+      _M_align_up(sizeof(buddy_t), _M_MAX_ALIGN) +
+      _M_align_up(sizeof(_buddy_node_t*) * norders, _M_MAX_ALIGN) +
+      _M_align_up(nblocks, _M_MAX_ALIGN) + (min_block - 1) +
+      nblocks * min_block);
+
+  buddy_t* self = _M_cast(
+      buddy_t*, st_arena__alloc_aligned(arena, sizeof(buddy_t), _M_MAX_ALIGN));
+
+  self->arena = arena;
+  self->free = _M_cast(
+      _buddy_node_t**,
+      st_arena__alloc_aligned(arena, sizeof(_buddy_node_t*) * norders,
+                              _M_MAX_ALIGN));
+  self->orders = st_arena__alloc_aligned(arena, nblocks, _M_MAX_ALIGN);
+  self->base =
+      st_arena__alloc_aligned(arena, nblocks * min_block, min_block);
+  self->size = nblocks * min_block;
+  self->min_order = min_order;
+  self->max_order = max_order;
+
+  buddy__reset(self);
+
+  return self;
+}
+
+__CCMS__INLINE
+void buddy__free(buddy_t* self) {
+  st_arena__free(self->arena);
+}
+
+// Size of the block at `ptr`, at least the size it was requested with
+__CCMS__INLINE
+size_t buddy__size(const buddy_t* self, const void* ptr) {
+  const size_t offset =
+      _M_cast(size_t, _M_cast(const uint8_t*, ptr) - self->base);
+
+  return _M_cast(size_t, 1)
+         << (self->orders[offset >> self->min_order] & ~_BUDDY_FREE);
+}
+
+__CCMS__INLINE
+uint8_t* buddy__alloc(buddy_t* self, const size_t size) {
+  size_t order = self->min_order;
+  while (order <= self->max_order && (_M_cast(size_t, 1) << order) < size)
+    order++;
+
+  // Smallest order with a free block that is large enough
+  size_t from = order;
+  while (from <= self->max_order && self->free[from - self->min_order] == NULL)
+    from++;
+
+  if (from > self->max_order) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+    fprintf(stderr,
+            "warning: tried to allocate a chunk of memory of size %ld from a "
+            "buddy allocator without a free block that large, returned NULL\n",
+            size);
+#endif
+    return NULL;
+  }
+
+  _buddy_node_t* node = self->free[from - self->min_order];
+  const size_t offset = _M_cast(size_t, _M_cast(uint8_t*, node) - self->base);
+  _buddy__remove(self, node, from);
+
+  // Split off the upper halves until the block has the requested order
+  while (from > order) {
+    from--;
+    _buddy__push(self, offset + (_M_cast(size_t, 1) << from), from);
+  }
+
+  self->orders[offset >> self->min_order] = _M_cast(uint8_t, order);
+  self->used += _M_cast(size_t, 1) << order;
+
+  return self->base + offset;
+}
+
+__CCMS__INLINE
+void buddy__dealloc(buddy_t* self, void* ptr) {
+  if (ptr == NULL) return;
+
+  size_t offset = _M_cast(size_t, _M_cast(uint8_t*, ptr) - self->base);
+  size_t order = self->orders[offset >> self->min_order];
+
+  if (order & _BUDDY_FREE) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+    fprintf(stderr,
+            "warning: tried freeing a block that is not allocated from a "
+            "buddy allocator, ignored\n");
+#endif
+    return;
+  }
+
+  self->used -= _M_cast(size_t, 1) << order;
+
+  // Merge with the buddy for as long as it is a free block of the same order
+  while (order < self->max_order) {
+    const size_t buddy = offset ^ (_M_cast(size_t, 1) << order);
+
+    if (buddy + (_M_cast(size_t, 1) << order) > self->size ||
+        self->orders[buddy >> self->min_order] != (order | _BUDDY_FREE))
+      break;
+
+    _buddy__remove(self, _M_cast(_buddy_node_t*, self->base + buddy), order);
+    if (buddy < offset) offset = buddy;
+    order++;
+  }
+
+  _buddy__push(self, offset, order);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __CCMS__ALLOC__BUDDY__H
@@ -0,0 +1,295 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+#ifndef __CCMS__ALLOC__HEAP__H
+#define __CCMS__ALLOC__HEAP__H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef __CCMS__SUPPRESS_WARNINGS
+#include <stdio.h>
+#endif
+
+#include "ccms/_defs.h"
+#include "ccms/_macros.h"
+#include "ccms/alloc/slab.h"
+
+// A general purpose allocator with segregated size classes. Requests up to
+// __CCMS__HEAP_MAX_SMALL bytes are rounded up to one of 32 size classes (steps
+// of 16 bytes up to 128, then four classes per power of two) and served by a
+// tracked slab_t per class. Larger requests get a dedicated block.
+//
+// Slab pages and large blocks are aligned to the page size of the heap and
+// start with a pointer to the owning slab (NULL for a large block), so
+// heap__dealloc finds everything it needs from the address alone and objects
+// carry no size header.
+//
+// In front of every slab sits a small cache of freed objects: heap__dealloc
+// parks objects there (up to __CCMS__HEAP_CACHE_SIZE bytes per class, 0 turns
+// the cache off) and heap__alloc hands them out again first. This keeps the
+// bookkeeping of the tracked slab off the hot path of programs that free and
+// allocate in turn.
+// The slab only sees an object again once the cache of its class is full, so
+// a double free is only caught for objects that do not end up in the cache.
+
+#ifndef __CCMS__HEAP_PAGE_SIZE
+#define __CCMS__HEAP_PAGE_SIZE 65536
+#endif
+
+#ifndef __CCMS__HEAP_MAX_SMALL
+#define __CCMS__HEAP_MAX_SMALL 8192
+#endif
+
+// The 32 size classes end at 8192 bytes, larger small objects would index
+// past them
+#if __CCMS__HEAP_MAX_SMALL > 8192
+#error "__CCMS__HEAP_MAX_SMALL can be at most 8192 (the largest size class)"
+#endif
+
+#ifndef __CCMS__HEAP_CACHE_SIZE
+#define __CCMS__HEAP_CACHE_SIZE 32768
+#endif
+
+#define _HEAP_NCLASSES 32
+
+typedef struct _heap_large_t _heap_large_t;
+
+struct _heap_large_t {
+  // Always NULL, in place of the slab pointer of a slab page
+  slab_t* slab;
+  _heap_large_t *next, *prev;
+  size_t size;
+};
+
+#define _HEAP_LARGE_HEADER_SIZE \
+  _M_align_up(sizeof(_heap_large_t), _M_MAX_ALIGN)
+
+__CCMS__INLINE
+uint8_t* _heap_large__data(_heap_large_t* self) {
+  return _M_cast(uint8_t*, self) + _HEAP_LARGE_HEADER_SIZE;
+}
+
+typedef struct heap_t heap_t;
+
+struct heap_t {
+  // Slab per size class, created on first use
+  slab_t* classes[_HEAP_NCLASSES];
+  // Freed objects per size class, linked through their first bytes, and the
+  // number of bytes they take up
+  uint8_t* cache[_HEAP_NCLASSES];
+  size_t cached[_HEAP_NCLASSES];
+  _heap_large_t* large;
+  size_t page_size;
+};
+
+__CCMS__INLINE
+size_t _heap__log2(size_t n) {
+#if defined(__GNUC__) || defined(__clang__)
+  return sizeof(unsigned long long) * 8 - 1 -
+         __builtin_clzll(_M_cast(unsigned long long, n));
+#else
+  size_t log = 0;
+  while (n >>= 1)
+    log++;
+  return log;
+#endif
+}
+
+// Size class of a request of `size` bytes (at most __CCMS__HEAP_MAX_SMALL)
+__CCMS__INLINE
+size_t _heap__class(const size_t size) {
+  if (size <= 128) return size == 0 ? 0 : (size - 1) / 16;
+
+  const size_t n = size - 1;
+  const size_t log = _heap__log2(n);
+  return 8 + (log - 7) * 4 + ((n >> (log - 2)) & 3);
+}
+
+// Object size of a size class, the inverse of _heap__class
+__CCMS__INLINE
+size_t _heap__class_size(const size_t cls) {
+  if (cls < 8) return (cls + 1) * 16;
+
+  const size_t log = 7 + (cls - 8) / 4;
+  return (_M_cast(size_t, 1) << log) +
+         ((cls - 8) % 4 + 1) * (_M_cast(size_t, 1) << (log - 2));
+}
+
+__CCMS__INLINE
+heap_t* heap__new() {
+  heap_t* self = _M_new(heap_t);
+
+  for (size_t i = 0; i < _HEAP_NCLASSES; i++) {
+    self->classes[i] = NULL;
+    self->cache[i] = NULL;
+    self->cached[i] = 0;
+  }
+  self->large = NULL;
+  self->page_size = __CCMS__HEAP_PAGE_SIZE;
+
+  return self;
+}
+
+// Frees the heap together with every object still allocated from it.
+__CCMS__INLINE
+void heap__free(heap_t* self) {
+  for (size_t i = 0; i < _HEAP_NCLASSES; i++)
+    if (self->classes[i] != NULL) slab__free(self->classes[i]);
+
+  for (_heap_large_t *itr = self->large, *tmp; itr != NULL; itr = tmp) {
+    tmp = itr->next;
+    _M_free_aligned(itr);
+  }
+
+  _M_free(self);
+}
+
+__CCMS__INLINE
+uint8_t* _heap__alloc_large(heap_t* self, const size_t size) {
+  const size_t total =
+      _M_align_up(_HEAP_LARGE_HEADER_SIZE + size, self->page_size);
+  _heap_large_t* block = _M_cast(
+      _heap_large_t*, _M_alloc_aligned(self->page_size, total));
+
+  if (block == NULL) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+    fprintf(stderr,
+            "warning: failed to allocate a block of size %ld from a heap, "
+            "returned NULL\n",
+            size);
+#endif
+    return NULL;
+  }
+
+  block->slab = NULL;
+  block->prev = NULL;
+  block->next = self->large;
+  block->size = total - _HEAP_LARGE_HEADER_SIZE;
+  if (self->large != NULL) self->large->prev = block;
+  self->large = block;
+
+  return _heap_large__data(block);
+}
+
+__CCMS__INLINE
+uint8_t* heap__alloc(heap_t* self, const size_t size) {
+  if (size > __CCMS__HEAP_MAX_SMALL) return _heap__alloc_large(self, size);
+
+  const size_t cls = _heap__class(size);
+  uint8_t* obj = self->cache[cls];
+
+  if (obj != NULL) {
+    memcpy(&self->cache[cls], obj, sizeof(uint8_t*));
+    self->cached[cls] -= _heap__class_size(cls);
+    return obj;
+  }
+
+  slab_t* slab = self->classes[cls];
+
+  if (slab == NULL) {
+    slab = self->classes[cls] =
+        slab__new_tracked(_heap__class_size(cls), self->page_size);
+    if (slab == NULL) return NULL;
+  }
+
+  return slab__alloc(slab);
+}
+
+// Number of bytes usable at `ptr`, at least the size it was requested with
+__CCMS__INLINE
+size_t heap__size(heap_t* self, const void* ptr) {
+  slab_t* slab = slab__of(ptr, self->page_size);
+
+  if (slab != NULL) return slab->slot_size;
+
+  return _M_cast(_heap_large_t*,
+                 _M_cast(uintptr_t, ptr) & ~(self->page_size - 1))
+      ->size;
+}
+
+__CCMS__INLINE
+void heap__dealloc(heap_t* self, void* ptr) {
+  if (ptr == NULL) return;
+
+  slab_t* slab = slab__of(ptr, self->page_size);
+
+  if (slab != NULL) {
+    // Slots are exactly as large as their size class
+    const size_t cls = _heap__class(slab->slot_size);
+
+    if (self->cached[cls] + slab->slot_size <= __CCMS__HEAP_CACHE_SIZE) {
+      memcpy(ptr, &self->cache[cls], sizeof(uint8_t*));
+      self->cache[cls] = _M_cast(uint8_t*, ptr);
+      self->cached[cls] += slab->slot_size;
+    } else {
+      slab__dealloc(slab, ptr);
+    }
+    return;
+  }
+
+  _heap_large_t* block = _M_cast(
+      _heap_large_t*, _M_cast(uintptr_t, ptr) & ~(self->page_size - 1));
+
+  if (block->prev != NULL)
+    block->prev->next = block->next;
+  else
+    self->large = block->next;
+  if (block->next != NULL) block->next->prev = block->prev;
+
+  _M_free_aligned(block);
+}
+
+// Resizes the object at `ptr` to `size` bytes, moving it if it does not fit
+// into its size class (or block) anymore. Behaves like heap__alloc for a NULL
+// `ptr`. If the object has to move but the new allocation fails, `ptr` is left
+// untouched and NULL is returned.
+__CCMS__INLINE
+uint8_t* heap__realloc(heap_t* self, void* ptr, const size_t size) {
+  if (ptr == NULL) return heap__alloc(self, size);
+
+  const size_t old_size = heap__size(self, ptr);
+
+  // Stay in place if the new size still rounds up to the same class, or for
+  // a large block, if it does not waste more than half of the block
+  if (size <= old_size &&
+      (old_size > __CCMS__HEAP_MAX_SMALL
+           ? size > __CCMS__HEAP_MAX_SMALL && size >= old_size / 2
+           : _heap__class(size) == _heap__class(old_size)))
+    return _M_cast(uint8_t*, ptr);
+
+  uint8_t* new_ptr = heap__alloc(self, size);
+  if (new_ptr == NULL) return NULL;
+
+  memcpy(new_ptr, ptr, size < old_size ? size : old_size);
+  heap__dealloc(self, ptr);
+
+  return new_ptr;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __CCMS__ALLOC__HEAP__H
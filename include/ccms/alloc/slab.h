@@ -0,0 +1,338 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+#ifndef __CCMS__ALLOC__SLAB__H
+#define __CCMS__ALLOC__SLAB__H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef __CCMS__SUPPRESS_WARNINGS
+#include <stdio.h>
+#endif
+
+#include "ccms/_defs.h"
+#include "ccms/_macros.h"
+
+// A pool of fixed-size objects that, unlike the arenas, can free individual
+// objects again. Objects are carved as slots from pages (like the pages of a
+// pg_arena_t) and every page keeps an intrusive list of its free slots, so
+// both slab__alloc and slab__dealloc are O(1).
+//
+// Pages are aligned to their (power of two) size, which lets slab__dealloc
+// find the page of an object by masking its address. A tracked slab
+// (slab__new_tracked) additionally keeps an occupancy bitmap per page, catches
+// double frees and hands pages that become empty back to _M_free_aligned.
+
+typedef struct slab_t slab_t;
+typedef struct _slab_page_t _slab_page_t;
+
+struct _slab_page_t {
+  // The slab this page belongs to, found from any object through slab__of
+  slab_t* slab;
+  _slab_page_t *next, *prev;
+  // Slots that were freed again, linked through their first bytes
+  uint8_t* free;
+  // Index of the first slot that was never handed out
+  uint32_t bump;
+  uint32_t used;
+};
+
+#define _SLAB_PAGE_HEADER_SIZE \
+  _M_align_up(sizeof(_slab_page_t), sizeof(uint64_t))
+
+__CCMS__INLINE
+uint64_t* _slab_page__bitmap(_slab_page_t* self) {
+  return _M_cast(uint64_t*, _M_cast(uint8_t*, self) + _SLAB_PAGE_HEADER_SIZE);
+}
+
+__CCMS__INLINE
+void _slab_page__unlink(_slab_page_t** list, _slab_page_t* page) {
+  if (page->prev != NULL)
+    page->prev->next = page->next;
+  else
+    *list = page->next;
+  if (page->next != NULL) page->next->prev = page->prev;
+}
+
+__CCMS__INLINE
+void _slab_page__push(_slab_page_t** list, _slab_page_t* page) {
+  page->prev = NULL;
+  page->next = *list;
+  if (*list != NULL) (*list)->prev = page;
+  *list = page;
+}
+
+__CCMS__INLINE
+void _slab_page__free_all(_slab_page_t* self) {
+  for (_slab_page_t *itr = self, *tmp; itr != NULL; itr = tmp) {
+    tmp = itr->next;
+    _M_free_aligned(itr);
+  }
+}
+
+struct slab_t {
+  // Pages with at least one free slot / without any
+  _slab_page_t *partial, *full;
+  // An empty page a tracked slab holds on to, so that one object being
+  // allocated and freed over and over does not allocate a page every time
+  _slab_page_t* spare;
+  size_t slot_size;
+  // ceil(2^32 / slot_size), turns the division by slot_size that a tracked
+  // slab does on every call into a multiplication
+  uint64_t slot_recip;
+  size_t page_size;
+  // Offset of the first slot from the start of a page
+  size_t slot_offset;
+  uint32_t slots_per_page;
+  int tracked;
+  // Number of pages held and of live objects
+  size_t npages;
+  size_t nobjs;
+};
+
+__CCMS__INLINE
+slab_t* _slab__new(const size_t obj_size,
+                   const size_t page_size,
+                   const int tracked) {
+  // Free slots store the link to the next one, so they hold at least a pointer
+  const size_t slot_size = _M_align_up(
+      obj_size < sizeof(void*) ? sizeof(void*) : obj_size, sizeof(void*));
+
+  // Slots that fit into a page if there was no bitmap, and the bitmap for them
+  size_t slots = page_size > _SLAB_PAGE_HEADER_SIZE
+                     ? (page_size - _SLAB_PAGE_HEADER_SIZE) / slot_size
+                     : 0;
+  const size_t bitmap_size =
+      tracked ? sizeof(uint64_t) * ((slots + 63) / 64) : 0;
+  const size_t slot_offset =
+      _M_align_up(_SLAB_PAGE_HEADER_SIZE + bitmap_size, _M_MAX_ALIGN);
+
+  slots = page_size > slot_offset ? (page_size - slot_offset) / slot_size : 0;
+
+  if (!_M_is_pow2(page_size) || page_size > UINT32_MAX || slots == 0) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+    fprintf(stderr,
+            "warning: tried creating a slab for objects of size %ld with page "
+            "size %ld (needs to be a power of two that fits at least one "
+            "object), returned NULL\n",
+            obj_size, page_size);
+#endif
+    return NULL;
+  }
+
+  slab_t* self = _M_new(slab_t);
+
+  self->partial = self->full = self->spare = NULL;
+  self->slot_size = slot_size;
+  self->slot_recip = ((_M_cast(uint64_t, 1) << 32) + slot_size - 1) / slot_size;
+  self->page_size = page_size;
+  self->slot_offset = slot_offset;
+  self->slots_per_page = _M_cast(uint32_t, slots);
+  self->tracked = tracked;
+  self->npages = self->nobjs = 0;
+
+  return self;
+}
+
+// Creates a slab for objects of `obj_size` bytes, carved from pages of
+// `page_size` bytes (a power of two). Pages are kept until the slab is freed.
+__CCMS__INLINE
+slab_t* slab__new(const size_t obj_size, const size_t page_size) {
+  return _slab__new(obj_size, page_size, 0);
+}
+
+// Like slab__new, but keeps an occupancy bitmap per page: double frees are
+// caught and pages that become empty are returned to _M_free_aligned (except
+// for one that is kept as a spare).
+__CCMS__INLINE
+slab_t* slab__new_tracked(const size_t obj_size, const size_t page_size) {
+  return _slab__new(obj_size, page_size, 1);
+}
+
+__CCMS__INLINE
+void slab__free(slab_t* self) {
+  _slab_page__free_all(self->partial);
+  _slab_page__free_all(self->full);
+  if (self->spare != NULL) _M_free_aligned(self->spare);
+  _M_free(self);
+}
+
+__CCMS__INLINE
+void _slab__page_reset(slab_t* self, _slab_page_t* page) {
+  page->free = NULL;
+  page->bump = page->used = 0;
+
+  if (self->tracked)
+    memset(_slab_page__bitmap(page), 0,
+           self->slot_offset - _SLAB_PAGE_HEADER_SIZE);
+}
+
+// Frees all objects at once. The pages are kept for reuse.
+__CCMS__INLINE
+void slab__reset(slab_t* self) {
+  while (self->full != NULL) {
+    _slab_page_t* page = self->full;
+    _slab_page__unlink(&self->full, page);
+    _slab_page__push(&self->partial, page);
+  }
+
+  for (_slab_page_t* itr = self->partial; itr != NULL; itr = itr->next)
+    _slab__page_reset(self, itr);
+
+  self->nobjs = 0;
+}
+
+__CCMS__INLINE
+_slab_page_t* _slab__page_new(slab_t* self) {
+  _slab_page_t* page = self->spare;
+
+  if (page != NULL) {
+    self->spare = NULL;
+    return page;
+  }
+
+  page = _M_cast(_slab_page_t*,
+                 _M_alloc_aligned(self->page_size, self->page_size));
+  if (page == NULL) return NULL;
+
+  page->slab = self;
+  _slab__page_reset(self, page);
+  self->npages++;
+
+  return page;
+}
+
+// Index of `slot` within `page`. Exact as long as the offset of the slot is a
+// multiple of slot_size below 2^32, which the page size guarantees.
+__CCMS__INLINE
+size_t _slab__index(slab_t* self, _slab_page_t* page, uint8_t* slot) {
+  const uint64_t offset = _M_cast(uint64_t, slot - _M_cast(uint8_t*, page) -
+                                                self->slot_offset);
+  return _M_cast(size_t, (offset * self->slot_recip) >> 32);
+}
+
+// Returns the slab that `ptr` was allocated from, `page_size` has to be the
+// page size of that slab. Lets a caller that spreads objects over several
+// slabs with the same page size free them without remembering the slab.
+__CCMS__INLINE
+slab_t* slab__of(const void* ptr, const size_t page_size) {
+  return _M_cast(_slab_page_t*, _M_cast(uintptr_t, ptr) & ~(page_size - 1))
+      ->slab;
+}
+
+__CCMS__INLINE
+uint8_t* slab__alloc(slab_t* self) {
+  _slab_page_t* page = self->partial;
+
+  if (page == NULL) {
+    page = _slab__page_new(self);
+    if (page == NULL) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+      fprintf(stderr,
+              "warning: failed to allocate a page of size %ld for a slab, "
+              "returned NULL\n",
+              self->page_size);
+#endif
+      return NULL;
+    }
+    _slab_page__push(&self->partial, page);
+  }
+
+  uint8_t* slot = page->free;
+  if (slot != NULL)
+    memcpy(&page->free, slot, sizeof(uint8_t*));
+  else
+    slot = _M_cast(uint8_t*, page) + self->slot_offset +
+           page->bump++ * self->slot_size;
+
+  if (self->tracked) {
+    const size_t index = _slab__index(self, page, slot);
+    _slab_page__bitmap(page)[index / 64] |= _M_cast(uint64_t, 1) << index % 64;
+  }
+
+  // A page without free slots leaves the partial list until one is freed
+  if (++page->used == self->slots_per_page) {
+    _slab_page__unlink(&self->partial, page);
+    _slab_page__push(&self->full, page);
+  }
+
+  self->nobjs++;
+  return slot;
+}
+
+__CCMS__INLINE
+void slab__dealloc(slab_t* self, void* ptr) {
+  uint8_t* slot = _M_cast(uint8_t*, ptr);
+  _slab_page_t* page = _M_cast(
+      _slab_page_t*, _M_cast(uintptr_t, slot) & ~(self->page_size - 1));
+
+  if (self->tracked) {
+    const size_t index = _slab__index(self, page, slot);
+    uint64_t* word = &_slab_page__bitmap(page)[index / 64];
+    const uint64_t bit = _M_cast(uint64_t, 1) << index % 64;
+
+    if ((*word & bit) == 0) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+      fprintf(stderr,
+              "warning: tried freeing an object that is not allocated from a "
+              "slab, ignored\n");
+#endif
+      return;
+    }
+    *word &= ~bit;
+  }
+
+  // The page moves to the front of the partial list, so that the next
+  // allocation hands out this slot again while it is still in cache
+  if (page != self->partial) {
+    _slab_page__unlink(
+        page->used == self->slots_per_page ? &self->full : &self->partial,
+        page);
+    _slab_page__push(&self->partial, page);
+  }
+
+  memcpy(slot, &page->free, sizeof(uint8_t*));
+  page->free = slot;
+  page->used--;
+  self->nobjs--;
+
+  if (self->tracked && page->used == 0) {
+    _slab_page__unlink(&self->partial, page);
+
+    if (self->spare == NULL) {
+      _slab__page_reset(self, page);
+      self->spare = page;
+    } else {
+      _M_free_aligned(page);
+      self->npages--;
+    }
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __CCMS__ALLOC__SLAB__H
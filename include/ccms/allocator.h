@@ -0,0 +1,483 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+#ifndef __CCMS__ALLOCATOR__H
+#define __CCMS__ALLOCATOR__H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef __CCMS__SUPPRESS_WARNINGS
+#include <stdio.h>
+#endif
+
+#include "ccms/_defs.h"
+#include "ccms/_macros.h"
+#include "ccms/_os.h"
+#include "ccms/alloc/heap.h"
+#include "ccms/arena/dynamic.h"
+#include "ccms/arena/paged.h"
+#include "ccms/arena/static.h"
+
+#ifdef __CCMS__HAS_VMEM
+#include "ccms/arena/virtual.h"
+#endif
+
+/**
+ * @enum allocator_kind_t
+ * @brief The kinds of memory sources an allocator_t can draw from.
+ */
+typedef enum allocator_kind_t {
+  ALLOCATOR_MALLOC,
+  ALLOCATOR_HEAP,
+  ALLOCATOR_ST_ARENA,
+  ALLOCATOR_PG_ARENA,
+  ALLOCATOR_DYN_ARENA,
+#ifdef __CCMS__HAS_VMEM
+  ALLOCATOR_VM_ARENA,
+#endif
+} allocator_kind_t;
+
+/**
+ * @typedef allocator_t
+ * @brief Typedef for struct allocator_t
+ */
+typedef struct allocator_t allocator_t;
+
+/**
+ * @struct allocator_t
+ * @brief A handle to any of the memory sources of ccms.
+ *
+ * Lets containers take their storage from _M_alloc, a heap_t or any arena
+ * without being written once per source. The handle does not own the source,
+ * which has to outlive everything allocated through the handle.
+ *
+ * @var allocator_t::kind
+ * The kind of memory source.
+ *
+ * @var allocator_t::ctx
+ * The memory source itself, NULL for ALLOCATOR_MALLOC.
+ */
+struct allocator_t {
+  allocator_kind_t kind;
+  void* ctx;
+};
+
+/**
+ * @brief An allocator_t using _M_alloc, _M_realloc and _M_free.
+ */
+__CCMS__INLINE
+allocator_t allocator__malloc(void) {
+  return (allocator_t){.kind = ALLOCATOR_MALLOC, .ctx = NULL};
+}
+
+/**
+ * @brief An allocator_t allocating from a heap_t.
+ */
+__CCMS__INLINE
+allocator_t allocator__heap(heap_t* heap) {
+  return (allocator_t){.kind = ALLOCATOR_HEAP, .ctx = heap};
+}
+
+/**
+ * @brief An allocator_t allocating from a st_arena_t.
+ */
+__CCMS__INLINE
+allocator_t allocator__st_arena(st_arena_t* arena) {
+  return (allocator_t){.kind = ALLOCATOR_ST_ARENA, .ctx = arena};
+}
+
+/**
+ * @brief An allocator_t allocating from a pg_arena_t.
+ */
+__CCMS__INLINE
+allocator_t allocator__pg_arena(pg_arena_t* arena) {
+  return (allocator_t){.kind = ALLOCATOR_PG_ARENA, .ctx = arena};
+}
+
+/**
+ * @brief An allocator_t allocating from a dyn_arena_t.
+ */
+__CCMS__INLINE
+allocator_t allocator__dyn_arena(dyn_arena_t* arena) {
+  return (allocator_t){.kind = ALLOCATOR_DYN_ARENA, .ctx = arena};
+}
+
+#ifdef __CCMS__HAS_VMEM
+/**
+ * @brief An allocator_t allocating from a vm_arena_t.
+ */
+__CCMS__INLINE
+allocator_t allocator__vm_arena(vm_arena_t* arena) {
+  return (allocator_t){.kind = ALLOCATOR_VM_ARENA, .ctx = arena};
+}
+#endif
+
+//
+//
+// ------------------ per-source functions ------------------
+//
+//
+
+// The functions below give every memory source the same three signatures
+// (alloc, realloc, dealloc), so that allocator_t can switch over them and the
+// ccms__* macros can pick one at compile time.
+
+/**
+ * @typedef ccms_malloc_t
+ * @brief Tag type standing for _M_alloc in the ccms__* macros, see CCMS_MALLOC.
+ */
+typedef struct ccms_malloc_t ccms_malloc_t;
+
+/**
+ * @brief The memory source to pass to the ccms__* macros for _M_alloc.
+ */
+#define CCMS_MALLOC _M_cast(ccms_malloc_t*, NULL)
+
+// _M_alloc and heap_t only guarantee the alignment of max_align_t
+__CCMS__INLINE
+int _allocator__check_align(const size_t align) {
+  if (align > _M_MAX_ALIGN) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+    fprintf(stderr,
+            "warning: tried to allocate a chunk of memory with alignment %ld "
+            "from an allocator that only supports up to %ld, returned NULL\n",
+            align, _M_cast(size_t, _M_MAX_ALIGN));
+#endif
+    return -1;
+  }
+
+  return 0;
+}
+
+__CCMS__INLINE
+uint8_t* _allocator__malloc_alloc(ccms_malloc_t* self,
+                                  const size_t size,
+                                  const size_t align) {
+  (void)self;
+  if (_allocator__check_align(align) != 0) return NULL;
+  return _M_cast(uint8_t*, _M_alloc(size));
+}
+
+__CCMS__INLINE
+uint8_t* _allocator__malloc_realloc(ccms_malloc_t* self,
+                                    uint8_t* ptr,
+                                    const size_t old_size,
+                                    const size_t new_size,
+                                    const size_t align) {
+  (void)self;
+  (void)old_size;
+  if (_allocator__check_align(align) != 0) return NULL;
+  return _M_cast(uint8_t*, _M_realloc(ptr, new_size));
+}
+
+__CCMS__INLINE
+void _allocator__malloc_dealloc(ccms_malloc_t* self,
+                                uint8_t* ptr,
+                                const size_t size) {
+  (void)self;
+  (void)size;
+  _M_free(ptr);
+}
+
+__CCMS__INLINE
+uint8_t* _allocator__heap_alloc(heap_t* self,
+                                const size_t size,
+                                const size_t align) {
+  if (_allocator__check_align(align) != 0) return NULL;
+  return heap__alloc(self, size);
+}
+
+__CCMS__INLINE
+uint8_t* _allocator__heap_realloc(heap_t* self,
+                                  uint8_t* ptr,
+                                  const size_t old_size,
+                                  const size_t new_size,
+                                  const size_t align) {
+  (void)old_size;
+  if (_allocator__check_align(align) != 0) return NULL;
+  return heap__realloc(self, ptr, new_size);
+}
+
+__CCMS__INLINE
+void _allocator__heap_dealloc(heap_t* self, uint8_t* ptr, const size_t size) {
+  (void)size;
+  if (ptr != NULL) heap__dealloc(self, ptr);
+}
+
+__CCMS__INLINE
+void _allocator__st_arena_dealloc(st_arena_t* self,
+                                  uint8_t* ptr,
+                                  const size_t size) {
+  if (ptr != NULL) st_arena__shrink(self, ptr, size, 0);
+}
+
+__CCMS__INLINE
+void _allocator__pg_arena_dealloc(pg_arena_t* self,
+                                  uint8_t* ptr,
+                                  const size_t size) {
+  if (ptr != NULL) pg_arena__shrink(self, ptr, size, 0);
+}
+
+// dyn_arena_t can not resize chunks, a growing chunk is always moved
+__CCMS__INLINE
+uint8_t* _allocator__dyn_arena_realloc(dyn_arena_t* self,
+                                       uint8_t* ptr,
+                                       const size_t old_size,
+                                       const size_t new_size,
+                                       const size_t align) {
+  if (ptr != NULL && new_size <= old_size) return ptr;
+
+  uint8_t* result = dyn_arena__alloc_aligned(self, new_size, align);
+  if (result != NULL && ptr != NULL) memcpy(result, ptr, old_size);
+  return result;
+}
+
+__CCMS__INLINE
+void _allocator__dyn_arena_dealloc(dyn_arena_t* self,
+                                   uint8_t* ptr,
+                                   const size_t size) {
+  (void)self;
+  (void)ptr;
+  (void)size;
+}
+
+#ifdef __CCMS__HAS_VMEM
+__CCMS__INLINE
+void _allocator__vm_arena_dealloc(vm_arena_t* self,
+                                  uint8_t* ptr,
+                                  const size_t size) {
+  if (ptr != NULL) vm_arena__shrink(self, ptr, size, 0);
+}
+#endif
+
+//
+//
+// ------------------ allocator_t ------------------
+//
+//
+
+/**
+ * @brief Allocates `size` bytes aligned to `align` (a power of two).
+ *
+ * @return The allocated memory, or NULL on failure.
+ */
+__CCMS__INLINE
+uint8_t* allocator__alloc(const allocator_t* self,
+                          const size_t size,
+                          const size_t align) {
+  switch (self->kind) {
+    case ALLOCATOR_MALLOC:
+      return _allocator__malloc_alloc(CCMS_MALLOC, size, align);
+    case ALLOCATOR_HEAP:
+      return _allocator__heap_alloc(_M_cast(heap_t*, self->ctx), size, align);
+    case ALLOCATOR_ST_ARENA:
+      return st_arena__alloc_aligned(_M_cast(st_arena_t*, self->ctx), size,
+                                     align);
+    case ALLOCATOR_PG_ARENA:
+      return pg_arena__alloc_aligned(_M_cast(pg_arena_t*, self->ctx), size,
+                                     align);
+    case ALLOCATOR_DYN_ARENA:
+      return dyn_arena__alloc_aligned(_M_cast(dyn_arena_t*, self->ctx), size,
+                                      align);
+#ifdef __CCMS__HAS_VMEM
+    case ALLOCATOR_VM_ARENA:
+      return vm_arena__alloc_aligned(_M_cast(vm_arena_t*, self->ctx), size,
+                                     align);
+#endif
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Resizes the chunk at `ptr` from `old_size` to `new_size` bytes.
+ *
+ * Arenas resize their most recent chunk in place if they have room for it,
+ * see the `*_realloc_aligned` functions of the arenas.
+ *
+ * @return The resized chunk, or NULL on failure (`ptr` stays valid then).
+ */
+__CCMS__INLINE
+uint8_t* allocator__realloc(const allocator_t* self,
+                            uint8_t* ptr,
+                            const size_t old_size,
+                            const size_t new_size,
+                            const size_t align) {
+  switch (self->kind) {
+    case ALLOCATOR_MALLOC:
+      return _allocator__malloc_realloc(CCMS_MALLOC, ptr, old_size, new_size,
+                                        align);
+    case ALLOCATOR_HEAP:
+      return _allocator__heap_realloc(_M_cast(heap_t*, self->ctx), ptr,
+                                      old_size, new_size, align);
+    case ALLOCATOR_ST_ARENA:
+      return st_arena__realloc_aligned(_M_cast(st_arena_t*, self->ctx), ptr,
+                                       old_size, new_size, align);
+    case ALLOCATOR_PG_ARENA:
+      return pg_arena__realloc_aligned(_M_cast(pg_arena_t*, self->ctx), ptr,
+                                       old_size, new_size, align);
+    case ALLOCATOR_DYN_ARENA:
+      return _allocator__dyn_arena_realloc(_M_cast(dyn_arena_t*, self->ctx),
+                                           ptr, old_size, new_size, align);
+#ifdef __CCMS__HAS_VMEM
+    case ALLOCATOR_VM_ARENA:
+      return vm_arena__realloc_aligned(_M_cast(vm_arena_t*, self->ctx), ptr,
+                                       old_size, new_size, align);
+#endif
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Releases the chunk at `ptr` of `size` bytes.
+ *
+ * Arenas only take back the space of their most recent chunk, any other chunk
+ * stays allocated until the arena is reset.
+ */
+__CCMS__INLINE
+void allocator__dealloc(const allocator_t* self,
+                        uint8_t* ptr,
+                        const size_t size) {
+  switch (self->kind) {
+    case ALLOCATOR_MALLOC:
+      _allocator__malloc_dealloc(CCMS_MALLOC, ptr, size);
+      break;
+    case ALLOCATOR_HEAP:
+      _allocator__heap_dealloc(_M_cast(heap_t*, self->ctx), ptr, size);
+      break;
+    case ALLOCATOR_ST_ARENA:
+      _allocator__st_arena_dealloc(_M_cast(st_arena_t*, self->ctx), ptr, size);
+      break;
+    case ALLOCATOR_PG_ARENA:
+      _allocator__pg_arena_dealloc(_M_cast(pg_arena_t*, self->ctx), ptr, size);
+      break;
+    case ALLOCATOR_DYN_ARENA:
+      _allocator__dyn_arena_dealloc(_M_cast(dyn_arena_t*, self->ctx), ptr,
+                                    size);
+      break;
+#ifdef __CCMS__HAS_VMEM
+    case ALLOCATOR_VM_ARENA:
+      _allocator__vm_arena_dealloc(_M_cast(vm_arena_t*, self->ctx), ptr, size);
+      break;
+#endif
+  }
+}
+
+//
+//
+// ------------------ static dispatch ------------------
+//
+//
+
+// The ccms__* macros pick the function for the type of the memory source `a`
+// at compile time (C11 _Generic), so a call through them is a direct call to
+// e.g. st_arena__alloc_aligned that inlines like one. `a` can be CCMS_MALLOC,
+// a heap_t*, any arena except cst_arena_t, or an allocator_t* for a source
+// only known at runtime. `a` is evaluated once.
+
+__CCMS__INLINE
+allocator_t _allocator__from_malloc(ccms_malloc_t* self) {
+  (void)self;
+  return allocator__malloc();
+}
+
+__CCMS__INLINE
+allocator_t _allocator__from_allocator(const allocator_t* self) {
+  return *self;
+}
+
+#ifdef __CCMS__HAS_VMEM
+#define _allocator__vm_case(fn) vm_arena_t* : fn,
+#else
+#define _allocator__vm_case(fn)
+#endif
+
+#define _allocator__select(a, malloc_fn, heap_fn, st_fn, pg_fn, dyn_fn, vm_fn, \
+                           rt_fn)                                              \
+  _Generic((a),                                                                \
+      ccms_malloc_t*: malloc_fn,                                               \
+      heap_t*: heap_fn,                                                        \
+      st_arena_t*: st_fn,                                                      \
+      pg_arena_t*: pg_fn,                                                      \
+      dyn_arena_t*: dyn_fn,                                                    \
+      _allocator__vm_case(vm_fn) allocator_t*: rt_fn,                          \
+      const allocator_t*: rt_fn)
+
+/**
+ * @brief Allocates `size` bytes aligned to `align` (a power of two) from `a`.
+ *
+ * @return The allocated memory, or NULL on failure.
+ */
+#define ccms__alloc_aligned(a, size, align)                                  \
+  _allocator__select(a, _allocator__malloc_alloc, _allocator__heap_alloc,     \
+                     st_arena__alloc_aligned, pg_arena__alloc_aligned,        \
+                     dyn_arena__alloc_aligned, vm_arena__alloc_aligned,       \
+                     allocator__alloc)(a, size, align)
+
+/**
+ * @brief Allocates `size` bytes aligned to __CCMS__DEFAULT_ALIGN from `a`.
+ */
+#define ccms__alloc(a, size) ccms__alloc_aligned(a, size, __CCMS__DEFAULT_ALIGN)
+
+/**
+ * @brief Resizes the chunk at `ptr` from `old_size` to `new_size` bytes, see
+ * allocator__realloc.
+ */
+#define ccms__realloc_aligned(a, ptr, old_size, new_size, align)               \
+  _allocator__select(a, _allocator__malloc_realloc, _allocator__heap_realloc,  \
+                     st_arena__realloc_aligned, pg_arena__realloc_aligned,     \
+                     _allocator__dyn_arena_realloc, vm_arena__realloc_aligned, \
+                     allocator__realloc)(a, ptr, old_size, new_size, align)
+
+#define ccms__realloc(a, ptr, old_size, new_size) \
+  ccms__realloc_aligned(a, ptr, old_size, new_size, __CCMS__DEFAULT_ALIGN)
+
+/**
+ * @brief Releases the chunk at `ptr` of `size` bytes, see allocator__dealloc.
+ */
+#define ccms__dealloc(a, ptr, size)                                          \
+  _allocator__select(a, _allocator__malloc_dealloc, _allocator__heap_dealloc, \
+                     _allocator__st_arena_dealloc,                            \
+                     _allocator__pg_arena_dealloc,                            \
+                     _allocator__dyn_arena_dealloc,                           \
+                     _allocator__vm_arena_dealloc,                            \
+                     allocator__dealloc)(a, ptr, size)
+
+/**
+ * @brief The allocator_t for `a`, to pass a memory source on to code that
+ * only knows it at runtime.
+ */
+#define ccms__allocator(a)                                                    \
+  _allocator__select(a, _allocator__from_malloc, allocator__heap,            \
+                     allocator__st_arena, allocator__pg_arena,               \
+                     allocator__dyn_arena, allocator__vm_arena,              \
+                     _allocator__from_allocator)(a)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __CCMS__ALLOCATOR__H
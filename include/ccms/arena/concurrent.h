@@ -0,0 +1,228 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+#ifndef __CCMS__ARENAS__CONCURRENT__H
+#define __CCMS__ARENAS__CONCURRENT__H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef __CCMS__SUPPRESS_WARNINGS
+#include <stdio.h>
+#endif
+
+#include "ccms/_defs.h"
+#include "ccms/_macros.h"
+
+#ifndef __CCMS__HAS_ATOMICS
+#error "ccms/arena/concurrent.h requires C11 atomics"
+#endif
+
+#include <stdatomic.h>
+
+#ifdef __CCMS__ARENA_STATS
+#include "ccms/arena/stats.h"
+#endif
+
+// Concurrent variant of st_arena_t: one pre-sized region that any number of
+// threads can allocate from at the same time without a lock. The bump position
+// is an atomic offset into the region.
+//
+// Allocation only hands out disjoint chunks; making the written data visible
+// to other threads is up to the caller. cst_arena__reset must not race with
+// allocations.
+
+typedef struct cst_arena_t cst_arena_t;
+
+struct cst_arena_t {
+  _Atomic size_t offset;
+  size_t size;
+#ifdef __CCMS__ARENA_STATS
+  // Only what allocations update is atomic. The bump position never moves back
+  // between resets, so the peak only has to be taken at reset (and query) time.
+  _Atomic size_t allocs, requested, padding;
+  size_t resets, peak;
+#endif
+};
+
+#define _CST_ARENA_HEADER_SIZE _M_align_up(sizeof(cst_arena_t), _M_MAX_ALIGN)
+
+__CCMS__INLINE
+cst_arena_t* cst_arena__new(const size_t size) {
+  cst_arena_t* self =
+      _M_cast(cst_arena_t*, _M_alloc(_CST_ARENA_HEADER_SIZE + size));
+
+  atomic_init(&self->offset, 0);
+  self->size = size;
+#ifdef __CCMS__ARENA_STATS
+  atomic_init(&self->allocs, 0);
+  atomic_init(&self->requested, 0);
+  atomic_init(&self->padding, 0);
+  self->resets = self->peak = 0;
+#endif
+
+  return self;
+}
+
+__CCMS__INLINE
+void cst_arena__free(cst_arena_t* self) {
+  _M_free(self);
+}
+
+__CCMS__INLINE
+uint8_t* _cst_arena__data(const cst_arena_t* self) {
+  return _M_cast(uint8_t*, self) + _CST_ARENA_HEADER_SIZE;
+}
+
+// Free memory left in the arena. Only a snapshot while other threads allocate.
+__CCMS__INLINE
+size_t cst_arena__cap(cst_arena_t* self) {
+  const size_t offset =
+      atomic_load_explicit(&self->offset, memory_order_relaxed);
+
+  return offset < self->size ? self->size - offset : 0;
+}
+
+__CCMS__INLINE
+void cst_arena__reset(cst_arena_t* self) {
+#ifdef __CCMS__ARENA_STATS
+  const size_t in_use = self->size - cst_arena__cap(self);
+
+  if (in_use > self->peak) self->peak = in_use;
+  self->resets++;
+#endif
+  atomic_store_explicit(&self->offset, 0, memory_order_relaxed);
+}
+
+__CCMS__INLINE
+uint8_t* cst_arena__alloc_aligned(cst_arena_t* self,
+                                  const size_t size,
+                                  const size_t align) {
+  if (!_M_is_pow2(align)) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+    fprintf(stderr,
+            "warning: tried to allocate a chunk of memory with alignment %ld "
+            "(not a power of two) from an arena (concurrent), returned NULL\n",
+            align);
+#endif
+    return NULL;
+  }
+
+  uint8_t* data = _cst_arena__data(self);
+  size_t offset = atomic_load_explicit(&self->offset, memory_order_relaxed);
+  size_t pad;
+
+  // The padding depends on the offset, so the bump has to be a CAS loop
+  do {
+    pad = _M_align_pad(_M_cast(uintptr_t, data + offset),
+                       _M_cast(uintptr_t, align));
+
+    if (offset > self->size || self->size - offset < pad ||
+        self->size - offset - pad < size) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+      fprintf(stderr,
+              "warning: tried to allocate a chunk of memory of size %ld "
+              "(alignment %ld) from an arena (concurrent) with only %ld free "
+              "memory, returned NULL\n",
+              size, align, cst_arena__cap(self));
+#endif
+      return NULL;
+    }
+  } while (!atomic_compare_exchange_weak_explicit(
+      &self->offset, &offset, offset + pad + size, memory_order_relaxed,
+      memory_order_relaxed));
+
+#ifdef __CCMS__ARENA_STATS
+  atomic_fetch_add_explicit(&self->allocs, 1, memory_order_relaxed);
+  atomic_fetch_add_explicit(&self->requested, size, memory_order_relaxed);
+  atomic_fetch_add_explicit(&self->padding, pad, memory_order_relaxed);
+#endif
+  return data + offset + pad;
+}
+
+__CCMS__INLINE
+uint8_t* cst_arena__alloc(cst_arena_t* self, const size_t size) {
+#if __CCMS__DEFAULT_ALIGN > 1
+  return cst_arena__alloc_aligned(self, size, __CCMS__DEFAULT_ALIGN);
+#else
+  // Cheap check up front, so that a full arena is not pushed any further past
+  // its end by threads that are bound to fail anyway
+  size_t offset = atomic_load_explicit(&self->offset, memory_order_relaxed);
+
+  if (offset <= self->size && self->size - offset >= size) {
+    offset =
+        atomic_fetch_add_explicit(&self->offset, size, memory_order_relaxed);
+
+    if (offset <= self->size && self->size - offset >= size) {
+#ifdef __CCMS__ARENA_STATS
+      atomic_fetch_add_explicit(&self->allocs, 1, memory_order_relaxed);
+      atomic_fetch_add_explicit(&self->requested, size, memory_order_relaxed);
+#endif
+      return _cst_arena__data(self) + offset;
+    }
+
+    // Lost the race for the last bytes: roll the offset back, which only
+    // succeeds if no other thread bumped it after us. Otherwise the offset
+    // stays past the end and the arena counts as full.
+    size_t expected = offset + size;
+    atomic_compare_exchange_strong_explicit(&self->offset, &expected, offset,
+                                            memory_order_relaxed,
+                                            memory_order_relaxed);
+  }
+
+#ifndef __CCMS__SUPPRESS_WARNINGS
+  fprintf(stderr,
+          "warning: tried to allocate a chunk of memory of size %ld from an "
+          "arena (concurrent) with only %ld free memory, returned NULL\n",
+          size, cst_arena__cap(self));
+#endif
+  return NULL;
+#endif
+}
+
+#ifdef __CCMS__ARENA_STATS
+// Only a snapshot while other threads allocate: the counters are read one after
+// another, not all at once.
+__CCMS__INLINE
+arena_stats_t cst_arena__stats(cst_arena_t* self) {
+  arena_stats_t stats = {0};
+
+  stats.allocs = atomic_load_explicit(&self->allocs, memory_order_relaxed);
+  stats.resets = self->resets;
+  stats.requested =
+      atomic_load_explicit(&self->requested, memory_order_relaxed);
+  stats.padding = atomic_load_explicit(&self->padding, memory_order_relaxed);
+  stats.in_use = self->size - cst_arena__cap(self);
+  stats.peak = stats.in_use > self->peak ? stats.in_use : self->peak;
+  stats.reserved = _CST_ARENA_HEADER_SIZE + self->size;
+  stats.blocks = 1;
+
+  return stats;
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __CCMS__ARENAS__CONCURRENT__H
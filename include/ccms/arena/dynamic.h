@@ -28,9 +28,17 @@ extern "C" {
 #include <stdint.h>
 #include <string.h>
 
+#ifndef __CCMS__SUPPRESS_WARNINGS
+#include <stdio.h>
+#endif
+
 #include "ccms/_defs.h"
 #include "ccms/_macros.h"
 
+#ifdef __CCMS__ARENA_STATS
+#include "ccms/arena/stats.h"
+#endif
+
 typedef struct _dyn_arena_block_t _dyn_arena_block_t;
 
 struct _dyn_arena_block_t {
@@ -38,11 +46,16 @@ struct _dyn_arena_block_t {
   size_t size;
 };
 
+// Block data starts right after the header, which is padded to max_align_t so
+// that the data of every block is as aligned as malloc itself.
+#define _DYN_ARENA_BLOCK_HEADER_SIZE \
+  _M_align_up(sizeof(_dyn_arena_block_t), _M_MAX_ALIGN)
+
 __CCMS__INLINE
 _dyn_arena_block_t* _dyn_arena_block__new(const size_t size,
                                           _dyn_arena_block_t* next) {
-  _dyn_arena_block_t* self =
-      _M_cast(_dyn_arena_block_t*, _M_alloc(sizeof(_dyn_arena_block_t) + size));
+  _dyn_arena_block_t* self = _M_cast(
+      _dyn_arena_block_t*, _M_alloc(_DYN_ARENA_BLOCK_HEADER_SIZE + size));
 
   self->next = next;
   self->size = size;
@@ -57,38 +70,141 @@ void _dyn_arena_block__free(_dyn_arena_block_t* self) {
 
 __CCMS__INLINE
 _dyn_arena_block_t* _dyn_arena_block__clone(const _dyn_arena_block_t* self) {
-  _dyn_arena_block_t* other = _M_cast(
-      _dyn_arena_block_t*, _M_alloc(sizeof(_dyn_arena_block_t) + self->size));
-  memcpy(other, self, sizeof(_dyn_arena_block_t) + self->size);
+  _dyn_arena_block_t* other =
+      _M_cast(_dyn_arena_block_t*,
+              _M_alloc(_DYN_ARENA_BLOCK_HEADER_SIZE + self->size));
+  memcpy(other, self, _DYN_ARENA_BLOCK_HEADER_SIZE + self->size);
 
   return other;
 }
 
+// Chunks that small requests are carved from
+typedef struct _dyn_arena_chunk_t _dyn_arena_chunk_t;
+
+struct _dyn_arena_chunk_t {
+  _dyn_arena_chunk_t* next;
+  size_t pos;
+  size_t size;
+};
+
+#define _DYN_ARENA_CHUNK_HEADER_SIZE \
+  _M_align_up(sizeof(_dyn_arena_chunk_t), _M_MAX_ALIGN)
+
+__CCMS__INLINE
+_dyn_arena_chunk_t* _dyn_arena_chunk__new(const size_t size) {
+  _dyn_arena_chunk_t* self = _M_cast(
+      _dyn_arena_chunk_t*, _M_alloc(_DYN_ARENA_CHUNK_HEADER_SIZE + size));
+
+  self->next = NULL;
+  self->pos = 0;
+  self->size = size;
+
+  return self;
+}
+
+__CCMS__INLINE
+uint8_t* _dyn_arena_chunk__data(_dyn_arena_chunk_t* self) {
+  return _M_cast(uint8_t*, self) + _DYN_ARENA_CHUNK_HEADER_SIZE;
+}
+
+// Default size of the chunks small requests are carved from
+#ifndef __CCMS__DYN_ARENA_CHUNK_SIZE
+#define __CCMS__DYN_ARENA_CHUNK_SIZE 65536
+#endif
+
+// Default size above which requests get a block of their own
+#ifndef __CCMS__DYN_ARENA_THRESHOLD
+#define __CCMS__DYN_ARENA_THRESHOLD (__CCMS__DYN_ARENA_CHUNK_SIZE / 4)
+#endif
+
 typedef struct dyn_arena_t dyn_arena_t;
 
 struct dyn_arena_t {
+  // Blocks of requests above the threshold, one per request
   _dyn_arena_block_t *head, *tail;
+  // All chunks and the one currently allocated from
+  _dyn_arena_chunk_t *chunks, *chunk;
+  size_t chunk_size;
+  size_t threshold;
+#ifdef __CCMS__ARENA_STATS
+  arena_stats_t stats;
+#endif
 };
 
+// Creates an arena that carves requests of up to `threshold` bytes from shared
+// chunks of `chunk_size` bytes and gives every larger request a block of its
+// own. A threshold of 0 gives every request its own block.
 __CCMS__INLINE
-dyn_arena_t* dyn_arena__new() {
+dyn_arena_t* dyn_arena__new_chunked(const size_t chunk_size,
+                                    const size_t threshold) {
   dyn_arena_t* self = _M_new(dyn_arena_t);
 
   self->head = self->tail = NULL;
+  self->chunks = self->chunk = NULL;
+  self->chunk_size = chunk_size;
+  self->threshold = threshold < chunk_size ? threshold : chunk_size;
+#ifdef __CCMS__ARENA_STATS
+  self->stats = (arena_stats_t){0};
+#endif
 
   return self;
 }
 
 __CCMS__INLINE
-void dyn_arena__reset(dyn_arena_t* self) {
+dyn_arena_t* dyn_arena__new() {
+  return dyn_arena__new_chunked(__CCMS__DYN_ARENA_CHUNK_SIZE,
+                                __CCMS__DYN_ARENA_THRESHOLD);
+}
+
+__CCMS__INLINE
+void _dyn_arena__free_blocks(dyn_arena_t* self) {
   for (_dyn_arena_block_t *itr = self->head, *tmp; itr != NULL; itr = tmp) {
     tmp = itr->next;
+#ifdef __CCMS__ARENA_STATS
+    _arena_stats__block_free(&self->stats,
+                             _DYN_ARENA_BLOCK_HEADER_SIZE + itr->size);
+#endif
     _dyn_arena_block__free(itr);
   }
 
   self->head = self->tail = NULL;
 }
 
+// Frees all memory of the arena, including the chunks small requests are
+// carved from. See dyn_arena__soft_reset for keeping the chunks for reuse.
+__CCMS__INLINE
+void dyn_arena__reset(dyn_arena_t* self) {
+  _dyn_arena__free_blocks(self);
+
+  for (_dyn_arena_chunk_t *itr = self->chunks, *tmp; itr != NULL; itr = tmp) {
+    tmp = itr->next;
+#ifdef __CCMS__ARENA_STATS
+    _arena_stats__block_free(&self->stats,
+                             _DYN_ARENA_CHUNK_HEADER_SIZE + itr->size);
+#endif
+    _M_free(itr);
+  }
+
+  self->chunks = self->chunk = NULL;
+#ifdef __CCMS__ARENA_STATS
+  _arena_stats__reset(&self->stats);
+#endif
+}
+
+// Frees the blocks of all large requests and makes the chunks available again,
+// without freeing them (unlike dyn_arena__reset). Like with pg_arena__reset
+// only the first chunk is reset here, all others once allocation reaches them.
+__CCMS__INLINE
+void dyn_arena__soft_reset(dyn_arena_t* self) {
+  _dyn_arena__free_blocks(self);
+
+  self->chunk = self->chunks;
+  if (self->chunk != NULL) self->chunk->pos = 0;
+#ifdef __CCMS__ARENA_STATS
+  _arena_stats__reset(&self->stats);
+#endif
+}
+
 __CCMS__INLINE
 void dyn_arena__free(dyn_arena_t* self) {
   dyn_arena__reset(self);
@@ -96,8 +212,13 @@ void dyn_arena__free(dyn_arena_t* self) {
 }
 
 __CCMS__INLINE
-uint8_t* dyn_arena__alloc(dyn_arena_t* self, const size_t size) {
-  _dyn_arena_block_t* new_block = _dyn_arena_block__new(size, NULL);
+uint8_t* _dyn_arena__alloc_block(dyn_arena_t* self,
+                                 const size_t size,
+                                 const size_t align) {
+  // Block data is already aligned to max_align_t, anything stricter needs some
+  // extra room to move the chunk forward within its block
+  const size_t extra = align > _M_MAX_ALIGN ? align - 1 : 0;
+  _dyn_arena_block_t* new_block = _dyn_arena_block__new(size + extra, NULL);
 
   if (self->tail != NULL)
     self->tail->next = new_block;
@@ -105,9 +226,102 @@ uint8_t* dyn_arena__alloc(dyn_arena_t* self, const size_t size) {
     self->head = new_block;
   self->tail = new_block;
 
-  return _M_cast(uint8_t*, new_block) + sizeof(_dyn_arena_block_t);
+  uint8_t* data = _M_cast(uint8_t*, new_block) + _DYN_ARENA_BLOCK_HEADER_SIZE;
+  const size_t pad =
+      _M_align_pad(_M_cast(uintptr_t, data), _M_cast(uintptr_t, align));
+#ifdef __CCMS__ARENA_STATS
+  _arena_stats__block_new(&self->stats,
+                          _DYN_ARENA_BLOCK_HEADER_SIZE + size + extra);
+  _arena_stats__alloc(&self->stats, size, pad);
+#endif
+
+  return data + pad;
 }
 
+__CCMS__INLINE
+uint8_t* dyn_arena__alloc_aligned(dyn_arena_t* self,
+                                  const size_t size,
+                                  const size_t align) {
+  if (!_M_is_pow2(align)) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+    fprintf(stderr,
+            "warning: tried allocating a chunk with alignment %ld (not a power "
+            "of two) from an arena (dynamic), returned NULL\n",
+            align);
+#endif
+    return NULL;
+  }
+
+  // Chunk data is aligned to max_align_t, so this is the most padding a request
+  // can need at the start of a fresh chunk
+  const size_t max_pad = align > _M_MAX_ALIGN ? align - _M_MAX_ALIGN : 0;
+
+  if (size > self->threshold || self->chunk_size - size < max_pad)
+    return _dyn_arena__alloc_block(self, size, align);
+
+  _dyn_arena_chunk_t* chunk = self->chunk;
+  size_t pad = 0;
+
+  if (chunk != NULL)
+    pad = _M_align_pad(
+        _M_cast(uintptr_t, _dyn_arena_chunk__data(chunk) + chunk->pos),
+        _M_cast(uintptr_t, align));
+
+  if (chunk == NULL || chunk->size - chunk->pos < size ||
+      chunk->size - chunk->pos - size < pad) {
+    _dyn_arena_chunk_t* next = chunk != NULL ? chunk->next : self->chunks;
+
+    if (next == NULL) {
+      // Append a new chunk to the end of the list
+      next = _dyn_arena_chunk__new(self->chunk_size);
+      if (chunk != NULL)
+        chunk->next = next;
+      else
+        self->chunks = next;
+#ifdef __CCMS__ARENA_STATS
+      _arena_stats__block_new(&self->stats,
+                              _DYN_ARENA_CHUNK_HEADER_SIZE + self->chunk_size);
+#endif
+    }
+
+#ifdef __CCMS__ARENA_STATS
+    if (chunk != NULL)
+      _arena_stats__waste(&self->stats, chunk->size - chunk->pos);
+#endif
+
+    // Move on to the next chunk, which may still hold the position from before
+    // the last reset
+    chunk = self->chunk = next;
+    chunk->pos = 0;
+    pad = _M_align_pad(_M_cast(uintptr_t, _dyn_arena_chunk__data(chunk)),
+                       _M_cast(uintptr_t, align));
+
+    // Only possible if _M_alloc returned less aligned memory than malloc would
+    if (chunk->size - size < pad)
+      return _dyn_arena__alloc_block(self, size, align);
+  }
+
+  uint8_t* result = _dyn_arena_chunk__data(chunk) + chunk->pos + pad;
+  chunk->pos += pad + size;
+#ifdef __CCMS__ARENA_STATS
+  _arena_stats__alloc(&self->stats, size, pad);
+#endif
+
+  return result;
+}
+
+__CCMS__INLINE
+uint8_t* dyn_arena__alloc(dyn_arena_t* self, const size_t size) {
+  return dyn_arena__alloc_aligned(self, size, __CCMS__DEFAULT_ALIGN);
+}
+
+#ifdef __CCMS__ARENA_STATS
+__CCMS__INLINE
+arena_stats_t dyn_arena__stats(const dyn_arena_t* self) {
+  return self->stats;
+}
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,177 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+#ifndef __CCMS__ARENAS__PAGE_POOL__H
+#define __CCMS__ARENAS__PAGE_POOL__H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ccms/_defs.h"
+#include "ccms/_macros.h"
+
+#ifndef __CCMS__HAS_ATOMICS
+#error "ccms/arena/page_pool.h requires C11 atomics"
+#endif
+
+#include <stdatomic.h>
+
+// A process-wide pool of fixed-size blocks that can be shared by any number of
+// threads without taking a lock. Free blocks are kept on a Treiber stack.
+// Blocks are addressed by a 32-bit index so that the stack head can carry a
+// 32-bit ABA tag next to it in a single 64-bit word.
+//
+// At most `capacity` blocks are tracked by the pool. Once these are all handed
+// out, further blocks come straight from _M_alloc and go back to _M_free on
+// release, so the pool never fails as long as _M_alloc does not.
+
+#define _PG_POOL_NIL UINT32_MAX
+
+typedef struct _pg_pool_block_t _pg_pool_block_t;
+
+struct _pg_pool_block_t {
+  uint32_t index;
+};
+
+#define _PG_POOL_BLOCK_HEADER_SIZE \
+  _M_align_up(sizeof(_pg_pool_block_t), _M_MAX_ALIGN)
+
+typedef struct pg_pool_t pg_pool_t;
+
+struct pg_pool_t {
+  // (tag << 32) | index of the top of the free stack
+  _Atomic uint64_t head;
+  uint8_t _pad0[64 - sizeof(uint64_t)];
+  // number of tracked blocks handed out so far (may overshoot capacity)
+  _Atomic uint32_t count;
+  uint8_t _pad1[64 - sizeof(uint32_t)];
+  size_t block_size;
+  uint32_t capacity;
+  _Atomic uint32_t* next;
+  _pg_pool_block_t** blocks;
+};
+
+__CCMS__INLINE
+pg_pool_t* pg_pool__new(const size_t block_size, const uint32_t capacity) {
+  pg_pool_t* self = _M_new(pg_pool_t);
+
+  atomic_init(&self->head, _M_cast(uint64_t, _PG_POOL_NIL));
+  atomic_init(&self->count, 0);
+  self->block_size = block_size;
+  self->capacity = capacity < _PG_POOL_NIL ? capacity : _PG_POOL_NIL - 1;
+  self->next = _M_new_arr(_Atomic uint32_t, self->capacity);
+  self->blocks = _M_new_arr(_pg_pool_block_t*, self->capacity);
+
+  return self;
+}
+
+// Frees every block tracked by the pool, including blocks that are still
+// acquired. All users of the pool have to be done with it at this point.
+__CCMS__INLINE
+void pg_pool__free(pg_pool_t* self) {
+  uint32_t count = atomic_load(&self->count);
+
+  if (count > self->capacity) count = self->capacity;
+  for (uint32_t i = 0; i < count; i++)
+    _M_free(self->blocks[i]);
+
+  _M_free(self->next);
+  _M_free(self->blocks);
+  _M_free(self);
+}
+
+__CCMS__INLINE
+uint8_t* _pg_pool_block__data(_pg_pool_block_t* self) {
+  return _M_cast(uint8_t*, self) + _PG_POOL_BLOCK_HEADER_SIZE;
+}
+
+__CCMS__INLINE
+_pg_pool_block_t* _pg_pool__grow(pg_pool_t* self) {
+  _pg_pool_block_t* block =
+      _M_cast(_pg_pool_block_t*,
+              _M_alloc(_PG_POOL_BLOCK_HEADER_SIZE + self->block_size));
+  uint32_t index = _PG_POOL_NIL;
+
+  // Only claim a slot while there are some left, so that count can overshoot
+  // capacity by at most the number of concurrently growing threads
+  if (atomic_load_explicit(&self->count, memory_order_relaxed) <
+      self->capacity) {
+    index = atomic_fetch_add_explicit(&self->count, 1, memory_order_relaxed);
+    if (index >= self->capacity)
+      index = _PG_POOL_NIL;
+    else
+      self->blocks[index] = block;
+  }
+
+  block->index = index;
+  return block;
+}
+
+__CCMS__INLINE
+uint8_t* pg_pool__acquire(pg_pool_t* self) {
+  uint64_t head = atomic_load_explicit(&self->head, memory_order_acquire);
+
+  while (_M_cast(uint32_t, head) != _PG_POOL_NIL) {
+    const uint32_t index = _M_cast(uint32_t, head);
+    const uint32_t next =
+        atomic_load_explicit(&self->next[index], memory_order_relaxed);
+    // A stale `next` (the block was popped and pushed again in between) is
+    // caught by the tag, which is bumped on every successful exchange
+    const uint64_t new_head = (((head >> 32) + 1) << 32) | next;
+
+    if (atomic_compare_exchange_weak_explicit(&self->head, &head, new_head,
+                                              memory_order_acquire,
+                                              memory_order_acquire))
+      return _pg_pool_block__data(self->blocks[index]);
+  }
+
+  return _pg_pool_block__data(_pg_pool__grow(self));
+}
+
+__CCMS__INLINE
+void pg_pool__release(pg_pool_t* self, uint8_t* ptr) {
+  _pg_pool_block_t* block =
+      _M_cast(_pg_pool_block_t*, ptr - _PG_POOL_BLOCK_HEADER_SIZE);
+  const uint32_t index = block->index;
+
+  if (index == _PG_POOL_NIL) {
+    _M_free(block);
+    return;
+  }
+
+  uint64_t head = atomic_load_explicit(&self->head, memory_order_relaxed);
+  uint64_t new_head;
+  do {
+    atomic_store_explicit(&self->next[index], _M_cast(uint32_t, head),
+                          memory_order_relaxed);
+    new_head = (((head >> 32) + 1) << 32) | index;
+  } while (!atomic_compare_exchange_weak_explicit(&self->head, &head, new_head,
+                                                  memory_order_release,
+                                                  memory_order_relaxed));
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __CCMS__ARENAS__PAGE_POOL__H
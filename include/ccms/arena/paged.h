@@ -26,6 +26,7 @@ extern "C" {
 
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #ifndef __CCMS__SUPPRESS_WARNINGS
 #include <stdio.h>
@@ -33,28 +34,54 @@ extern "C" {
 
 #include "ccms/_defs.h"
 #include "ccms/_macros.h"
+#include "ccms/_os.h"
+
+#ifdef __CCMS__ARENA_STATS
+#include "ccms/arena/stats.h"
+#endif
+
+#ifdef __CCMS__HAS_ATOMICS
+#include "ccms/arena/page_pool.h"
+#endif
 
 typedef struct _pg_arena_page_t _pg_arena_page_t;
 
 struct _pg_arena_page_t {
   _pg_arena_page_t* next;
   size_t pos;
+  size_t size;
+  // Whether the page was mapped by _os__alloc_huge instead of _M_alloc
+  int huge;
 };
 
+// Page data starts right after the header, which is padded to max_align_t so
+// that the data of every page is as aligned as malloc itself.
+#define _PG_ARENA_PAGE_HEADER_SIZE \
+  _M_align_up(sizeof(_pg_arena_page_t), _M_MAX_ALIGN)
+
 __CCMS__INLINE
 _pg_arena_page_t* _pg_arena_page__new(const size_t size,
                                       _pg_arena_page_t* next) {
-  _pg_arena_page_t* self =
-      _M_cast(_pg_arena_page_t*, _M_alloc(sizeof(_pg_arena_page_t) + size));
+  _pg_arena_page_t* self = _M_cast(
+      _pg_arena_page_t*, _M_alloc(_PG_ARENA_PAGE_HEADER_SIZE + size));
 
   self->pos = 0;
+  self->size = size;
   self->next = next;
+  self->huge = 0;
 
   return self;
 }
 
 __CCMS__INLINE
 void _pg_arena_page__free(_pg_arena_page_t* self) {
+#ifdef __CCMS__HAS_VMEM
+  if (self->huge) {
+    _os__release(_M_cast(uint8_t*, self),
+                 _PG_ARENA_PAGE_HEADER_SIZE + self->size);
+    return;
+  }
+#endif
   _M_free(self);
 }
 
@@ -63,38 +90,466 @@ void _pg_arena_page__reset(_pg_arena_page_t* self) {
   self->pos = 0;
 }
 
+__CCMS__INLINE
+uint8_t* _pg_arena_page__data(_pg_arena_page_t* self) {
+  return _M_cast(uint8_t*, self) + _PG_ARENA_PAGE_HEADER_SIZE;
+}
+
+// Number of padding bytes needed so that the next chunk allocated from the page
+// is aligned to align.
+__CCMS__INLINE
+size_t _pg_arena_page__pad(_pg_arena_page_t* self, const size_t align) {
+  const uintptr_t addr =
+      _M_cast(uintptr_t, _pg_arena_page__data(self) + self->pos);
+
+  return _M_align_pad(addr, _M_cast(uintptr_t, align));
+}
+
+#ifdef __CCMS__HAS_VMEM
+// Gives the memory of the page data back to the operating system, as far as it
+// covers whole OS pages, see pg_arena__set_retention. The header is kept.
+__CCMS__INLINE
+void _pg_arena_page__purge(_pg_arena_page_t* self) {
+  const uintptr_t os_page = _M_cast(uintptr_t, _os__page_size());
+  const uintptr_t data = _M_cast(uintptr_t, _pg_arena_page__data(self));
+  const uintptr_t start = _M_align_up(data, os_page);
+  const uintptr_t end = (data + self->size) & ~(os_page - 1);
+
+  if (start < end)
+    _os__advise(_M_cast(uint8_t*, start), end - start, _OS_ADVICE_DONTNEED);
+}
+#endif
+
+typedef struct _pg_arena_large_t _pg_arena_large_t;
+
+// A block of its own for a chunk that is larger than a page
+struct _pg_arena_large_t {
+  _pg_arena_large_t* next;
+  size_t size;
+};
+
+#define _PG_ARENA_LARGE_HEADER_SIZE \
+  _M_align_up(sizeof(_pg_arena_large_t), _M_MAX_ALIGN)
+
+__CCMS__INLINE
+_pg_arena_large_t* _pg_arena_large__new(const size_t size,
+                                        _pg_arena_large_t* next) {
+  _pg_arena_large_t* self = _M_cast(
+      _pg_arena_large_t*, _M_alloc(_PG_ARENA_LARGE_HEADER_SIZE + size));
+
+  self->next = next;
+  self->size = size;
+
+  return self;
+}
+
+__CCMS__INLINE
+void _pg_arena_large__free_all(_pg_arena_large_t* self) {
+  for (_pg_arena_large_t *itr = self, *tmp; itr != NULL; itr = tmp) {
+    tmp = itr->next;
+    _M_free(itr);
+  }
+}
+
+// How the size of newly allocated pages develops, see pg_arena__set_growth
+typedef enum pg_arena_growth_t {
+  PG_ARENA_GROWTH_FIXED,
+  PG_ARENA_GROWTH_DOUBLE,
+  PG_ARENA_GROWTH_CUSTOM,
+} pg_arena_growth_t;
+
+// Returns the size of the next page, given the number of pages the arena has
+// so far and the size of the last of them
+typedef size_t (*pg_arena_grow_fn)(void* ctx,
+                                   size_t npages,
+                                   size_t last_page_size);
+
+// What pg_arena__reset does with the pages beyond the ones it retains, see
+// pg_arena__set_retention
+typedef enum pg_arena_trim_t {
+  // Free them (or return them to the pool)
+  PG_ARENA_TRIM_FREE,
+  // Keep them, but give their memory back to the operating system
+  // (madvise(MADV_DONTNEED)), so that they are backed again once reused
+  PG_ARENA_TRIM_PURGE,
+} pg_arena_trim_t;
+
 typedef struct pg_arena_t pg_arena_t;
 
 struct pg_arena_t {
   _pg_arena_page_t *head, *tail;
+  // Size of the first page and lower bound for the size of all other pages
   size_t page_size;
+  size_t npages;
+  pg_arena_growth_t growth;
+  size_t max_page_size;
+  pg_arena_grow_fn grow_fn;
+  void* grow_ctx;
+  // If set, pages are taken from and returned to this (shared) pool instead of
+  // _M_alloc/_M_free
+  struct pg_pool_t* pool;
+  // Chunks that do not fit into a page (in use / kept for reuse)
+  _pg_arena_large_t *large, *large_free;
+  // Whether pg_arena__reset keeps the large blocks for reuse
+  int keep_large;
+  // Whether pages live in huge pages, see pg_arena__new_huge
+  int huge;
+  // Number of pages from head up to and including tail
+  size_t nused;
+  // Retention policy, see pg_arena__set_retention (a decay of 0 keeps all)
+  size_t retain_decay, retain_min;
+  pg_arena_trim_t trim;
+  // High-water mark of nused, decayed at every reset, in 1/256 pages
+  size_t hwm;
+  // Pages from this index on hold no memory (PG_ARENA_TRIM_PURGE)
+  size_t nkept;
+#ifdef __CCMS__ARENA_STATS
+  arena_stats_t stats;
+#endif
 };
 
+// Size of the page to append after the current last page (the tail)
 __CCMS__INLINE
-pg_arena_t* pg_arena__new(const size_t page_size) {
+size_t _pg_arena__next_page_size(const pg_arena_t* self) {
+  size_t size = self->page_size;
+
+  switch (self->growth) {
+    case PG_ARENA_GROWTH_FIXED:
+      break;
+    case PG_ARENA_GROWTH_DOUBLE:
+      size = self->tail->size <= self->max_page_size / 2
+                 ? self->tail->size * 2
+                 : self->max_page_size;
+      break;
+    case PG_ARENA_GROWTH_CUSTOM:
+      size = self->grow_fn(self->grow_ctx, self->npages, self->tail->size);
+      break;
+  }
+
+  // Every chunk that is not served as a large block has to fit into any page
+  return size < self->page_size ? self->page_size : size;
+}
+
+// Takes a page of (at least) `size` bytes from the pool, huge pages or _M_alloc
+__CCMS__INLINE
+_pg_arena_page_t* _pg_arena__page_get(pg_arena_t* self, const size_t size) {
+#ifdef __CCMS__HAS_ATOMICS
+  // Pooled pages all have the same size, growth policies do not apply
+  if (self->pool != NULL) {
+    _pg_arena_page_t* page =
+        _M_cast(_pg_arena_page_t*, pg_pool__acquire(self->pool));
+
+    page->pos = 0;
+    page->size = self->page_size;
+    page->next = NULL;
+    page->huge = 0;
+
+    return page;
+  }
+#endif
+
+#ifdef __CCMS__HAS_VMEM
+  if (self->huge) {
+    size_t total = _PG_ARENA_PAGE_HEADER_SIZE + size;
+    _pg_arena_page_t* page =
+        _M_cast(_pg_arena_page_t*, _os__alloc_huge(&total));
+
+    // Falls back to a regular page if the memory can not be mapped
+    if (page != NULL) {
+      page->pos = 0;
+      page->size = total - _PG_ARENA_PAGE_HEADER_SIZE;
+      page->next = NULL;
+      page->huge = 1;
+      return page;
+    }
+  }
+#endif
+
+  return _pg_arena_page__new(size, NULL);
+}
+
+__CCMS__INLINE
+_pg_arena_page_t* _pg_arena__page_new(pg_arena_t* self, const size_t size) {
+  _pg_arena_page_t* page = _pg_arena__page_get(self, size);
+
+  self->npages++;
+#ifdef __CCMS__ARENA_STATS
+  _arena_stats__block_new(&self->stats,
+                          _PG_ARENA_PAGE_HEADER_SIZE + page->size);
+#endif
+
+  return page;
+}
+
+__CCMS__INLINE
+void _pg_arena__page_free(pg_arena_t* self, _pg_arena_page_t* page) {
+  self->npages--;
+#ifdef __CCMS__ARENA_STATS
+  _arena_stats__block_free(&self->stats,
+                           _PG_ARENA_PAGE_HEADER_SIZE + page->size);
+#endif
+
+#ifdef __CCMS__HAS_ATOMICS
+  if (self->pool != NULL) {
+    pg_pool__release(self->pool, _M_cast(uint8_t*, page));
+    return;
+  }
+#endif
+
+  _pg_arena_page__free(page);
+}
+
+__CCMS__INLINE
+pg_arena_t* _pg_arena__new(const size_t page_size,
+                           struct pg_pool_t* pool,
+                           const int huge) {
   pg_arena_t* self = _M_new(pg_arena_t);
 
   self->page_size = page_size;
-  self->head = self->tail = _pg_arena_page__new(page_size, NULL);
+  self->npages = 0;
+  self->growth = PG_ARENA_GROWTH_FIXED;
+  self->max_page_size = page_size;
+  self->grow_fn = NULL;
+  self->grow_ctx = NULL;
+  self->pool = pool;
+  self->large = self->large_free = NULL;
+  self->keep_large = 0;
+  self->huge = huge;
+  self->nused = 1;
+  self->retain_decay = self->retain_min = 0;
+  self->trim = PG_ARENA_TRIM_FREE;
+  self->hwm = 0;
+  self->nkept = 1;
+#ifdef __CCMS__ARENA_STATS
+  self->stats = (arena_stats_t){0};
+#endif
+  self->head = self->tail = _pg_arena__page_new(self, page_size);
 
   return self;
 }
 
+__CCMS__INLINE
+pg_arena_t* pg_arena__new(const size_t page_size) {
+  return _pg_arena__new(page_size, NULL, 0);
+}
+
+#ifdef __CCMS__HAS_VMEM
+// Creates an arena whose pages are aligned to __CCMS__HUGE_PAGE_SIZE and backed
+// by huge pages where possible (see _os__alloc_huge), falling back to _M_alloc
+// for a page that can not be mapped. Here `page_size` is the size of a whole
+// page including its header, rounded up to a multiple of
+// __CCMS__HUGE_PAGE_SIZE, so that pages fill their huge pages exactly. Chunks
+// larger than a page still use _M_alloc.
+__CCMS__INLINE
+pg_arena_t* pg_arena__new_huge(const size_t page_size) {
+  const size_t size = _M_align_up(page_size > _PG_ARENA_PAGE_HEADER_SIZE
+                                      ? page_size
+                                      : _PG_ARENA_PAGE_HEADER_SIZE + 1,
+                                  _M_cast(size_t, __CCMS__HUGE_PAGE_SIZE));
+
+  return _pg_arena__new(size - _PG_ARENA_PAGE_HEADER_SIZE, NULL, 1);
+}
+#endif
+
+#ifdef __CCMS__HAS_ATOMICS
+// Creates a pool whose blocks can back the pages of pg_arena_t's with the given
+// page size. At most `capacity` pages are recycled through the pool.
+__CCMS__INLINE
+pg_pool_t* pg_arena__new_pool(const size_t page_size, const uint32_t capacity) {
+  return pg_pool__new(_PG_ARENA_PAGE_HEADER_SIZE + page_size, capacity);
+}
+
+// Creates an arena that takes its pages from (and returns them to) the given
+// pool, see pg_arena__new_pool. The arena itself is not thread-safe; the idea
+// is for every thread to own one arena while all of them share one pool. The
+// arenas have to be freed before the pool.
+__CCMS__INLINE
+pg_arena_t* pg_arena__new_pooled(pg_pool_t* pool) {
+  return _pg_arena__new(pool->block_size - _PG_ARENA_PAGE_HEADER_SIZE, pool,
+                        0);
+}
+#endif
+
 __CCMS__INLINE
 void pg_arena__free(pg_arena_t* self) {
   for (_pg_arena_page_t *itr = self->head, *tmp; itr != NULL; itr = tmp) {
     tmp = itr->next;
-    _pg_arena_page__free(itr);
+    _pg_arena__page_free(self, itr);
   }
+  _pg_arena_large__free_all(self->large);
+  _pg_arena_large__free_all(self->large_free);
   _M_free(self);
 }
 
+// Frees a list of large blocks that belonged to the arena
+__CCMS__INLINE
+void _pg_arena__free_large(pg_arena_t* self, _pg_arena_large_t* list) {
+#ifdef __CCMS__ARENA_STATS
+  for (_pg_arena_large_t* itr = list; itr != NULL; itr = itr->next)
+    _arena_stats__block_free(&self->stats,
+                             _PG_ARENA_LARGE_HEADER_SIZE + itr->size);
+#else
+  (void)self;
+#endif
+  _pg_arena_large__free_all(list);
+}
+
+// Sets how the arena sizes pages it allocates beyond the first one:
+// PG_ARENA_GROWTH_FIXED keeps using page_size, PG_ARENA_GROWTH_DOUBLE doubles
+// the size of the last page up to max_page_size. No page is ever smaller than
+// page_size. Has no effect on pooled arenas. PG_ARENA_GROWTH_CUSTOM is only
+// accepted once a grow function is set, see pg_arena__set_grow_fn.
+__CCMS__INLINE
+void pg_arena__set_growth(pg_arena_t* self,
+                          const pg_arena_growth_t growth,
+                          const size_t max_page_size) {
+  if (growth == PG_ARENA_GROWTH_CUSTOM && self->grow_fn == NULL) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+    fprintf(stderr,
+            "warning: tried setting custom growth on an arena (page allocated) "
+            "without a grow function, ignored\n");
+#endif
+    return;
+  }
+
+  self->growth = growth;
+  self->max_page_size = max_page_size;
+}
+
+// Lets fn decide the size of the pages the arena allocates beyond the first
+// one (PG_ARENA_GROWTH_CUSTOM). No page is ever smaller than page_size.
+__CCMS__INLINE
+void pg_arena__set_grow_fn(pg_arena_t* self, pg_arena_grow_fn fn, void* ctx) {
+  if (fn == NULL) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+    fprintf(stderr,
+            "warning: tried setting a NULL grow function on an arena (page "
+            "allocated), ignored\n");
+#endif
+    return;
+  }
+
+  self->growth = PG_ARENA_GROWTH_CUSTOM;
+  self->grow_fn = fn;
+  self->grow_ctx = ctx;
+}
+
+// Sets whether pg_arena__reset keeps the blocks of chunks larger than a page
+// around to serve later large chunks, instead of freeing them. Either way they
+// are freed by pg_arena__hard_reset and pg_arena__free.
+__CCMS__INLINE
+void pg_arena__set_keep_large(pg_arena_t* self, const int keep) {
+  self->keep_large = keep;
+}
+
+// Sets how many pages pg_arena__reset keeps around for the next cycle. By
+// default (a decay of 0) it keeps every page forever, so that one unusually
+// large cycle pins its memory for the lifetime of the arena.
+//
+// With a decay of N > 0 the arena tracks a high-water mark of the pages in use
+// at a reset. It rises to a larger count right away and otherwise moves 1/N of
+// the way down towards the current count at every reset; after a spike, the
+// mark is back within 1% of the usual count after about 4.6 * N resets. The
+// arena keeps (at least `min_pages` and) as many pages as the mark says, and
+// frees or purges the rest depending on `trim`. In a steady state, no page is
+// allocated or freed at all.
+//
+// PG_ARENA_TRIM_PURGE falls back to PG_ARENA_TRIM_FREE where virtual memory
+// is not available. Large blocks kept by pg_arena__set_keep_large are not
+// affected.
+__CCMS__INLINE
+void pg_arena__set_retention(pg_arena_t* self,
+                             const size_t decay,
+                             const size_t min_pages,
+                             const pg_arena_trim_t trim) {
+  self->retain_decay = decay;
+  self->retain_min = min_pages;
+#ifdef __CCMS__HAS_VMEM
+  self->trim = trim;
+#else
+  self->trim = PG_ARENA_TRIM_FREE;
+  (void)trim;
+#endif
+  self->hwm = self->nused << 8;
+  self->nkept = self->npages;
+}
+
+// Applies the retention policy at a reset, see pg_arena__set_retention. Only
+// walks the pages if some have to be trimmed.
+__CCMS__INLINE
+void _pg_arena__retain(pg_arena_t* self) {
+  const size_t used = self->nused << 8;
+
+  if (used >= self->hwm)
+    self->hwm = used;
+  else
+    self->hwm -=
+        (self->hwm - used + self->retain_decay - 1) / self->retain_decay;
+
+  size_t keep = (self->hwm + 255) >> 8;
+  if (keep < self->retain_min) keep = self->retain_min;
+  if (keep < 1) keep = 1;
+
+  // Pages from this index on hold no memory already
+  size_t end = self->npages;
+  if (self->trim == PG_ARENA_TRIM_PURGE)
+    end = self->nused > self->nkept ? self->nused : self->nkept;
+
+  if (keep >= end) {
+    self->nkept = end;
+    return;
+  }
+
+  _pg_arena_page_t* last = self->head;
+  for (size_t i = 1; i < keep; i++)
+    last = last->next;
+
+  if (self->trim == PG_ARENA_TRIM_FREE) {
+    for (_pg_arena_page_t *itr = last->next, *tmp; itr != NULL; itr = tmp) {
+      tmp = itr->next;
+      _pg_arena__page_free(self, itr);
+    }
+    last->next = NULL;
+  }
+#ifdef __CCMS__HAS_VMEM
+  else {
+    _pg_arena_page_t* itr = last->next;
+    for (size_t i = keep; i < end; i++, itr = itr->next)
+      _pg_arena_page__purge(itr);
+  }
+#endif
+
+  self->nkept = keep;
+}
+
+// Makes all pages available again in O(1): only the first page is reset here,
+// every following page is reset once the tail moves onto it. With a retention
+// policy, pages beyond the ones retained are freed or purged (see
+// pg_arena__set_retention).
 __CCMS__INLINE
 void pg_arena__reset(pg_arena_t* self) {
-  for (_pg_arena_page_t* itr = self->head; itr != NULL; itr = itr->next)
-    _pg_arena_page__reset(itr);
+  if (self->retain_decay > 0) _pg_arena__retain(self);
 
+  _pg_arena_page__reset(self->head);
   self->tail = self->head;
+  self->nused = 1;
+#ifdef __CCMS__ARENA_STATS
+  _arena_stats__reset(&self->stats);
+#endif
+
+  if (self->large != NULL) {
+    if (self->keep_large) {
+      _pg_arena_large_t* last = self->large;
+      while (last->next != NULL)
+        last = last->next;
+
+      last->next = self->large_free;
+      self->large_free = self->large;
+    } else {
+      _pg_arena__free_large(self, self->large);
+    }
+    self->large = NULL;
+  }
 }
 
 __CCMS__INLINE
@@ -103,61 +558,284 @@ void pg_arena__hard_reset(pg_arena_t* self) {
     for (_pg_arena_page_t *itr = self->head->next, *tmp; itr != NULL;
          itr = tmp) {
       tmp = itr->next;
-      _pg_arena_page__free(itr);
+      _pg_arena__page_free(self, itr);
     }
 
   _pg_arena_page__reset(self->head);
   self->head->next = NULL;
   self->tail = self->head;
+  self->nused = self->nkept = 1;
+  // The pages the retention policy went by are gone, start over
+  self->hwm = 0;
+#ifdef __CCMS__ARENA_STATS
+  _arena_stats__reset(&self->stats);
+#endif
+
+  _pg_arena__free_large(self, self->large);
+  _pg_arena__free_large(self, self->large_free);
+  self->large = self->large_free = NULL;
 }
 
+// Serves a chunk that does not fit into a page from a block of its own, reusing
+// a block kept by pg_arena__reset if one is large enough.
 __CCMS__INLINE
-uint8_t* pg_arena__alloc(pg_arena_t* self, const size_t size) {
-  // If the requested size is larger than the page size of the pg_arena_t
-  if (size > self->page_size) {
+uint8_t* _pg_arena__alloc_large(pg_arena_t* self,
+                                const size_t size,
+                                const size_t align) {
+  // Block data is already aligned to max_align_t, anything stricter needs some
+  // extra room to move the chunk forward within its block
+  const size_t need = size + (align > _M_MAX_ALIGN ? align - 1 : 0);
+  _pg_arena_large_t* block = NULL;
+
+  for (_pg_arena_large_t** itr = &self->large_free; *itr != NULL;
+       itr = &(*itr)->next)
+    if ((*itr)->size >= need) {
+      block = *itr;
+      *itr = block->next;
+      break;
+    }
+
+  if (block == NULL) {
+    block = _pg_arena_large__new(need, NULL);
+#ifdef __CCMS__ARENA_STATS
+    _arena_stats__block_new(&self->stats, _PG_ARENA_LARGE_HEADER_SIZE + need);
+#endif
+  }
+
+  block->next = self->large;
+  self->large = block;
+
+  uint8_t* data = _M_cast(uint8_t*, block) + _PG_ARENA_LARGE_HEADER_SIZE;
+  const size_t pad =
+      _M_align_pad(_M_cast(uintptr_t, data), _M_cast(uintptr_t, align));
+#ifdef __CCMS__ARENA_STATS
+  _arena_stats__alloc(&self->stats, size, pad);
+#endif
+
+  return data + pad;
+}
+
+__CCMS__INLINE
+uint8_t* pg_arena__alloc_aligned(pg_arena_t* self,
+                                 const size_t size,
+                                 const size_t align) {
+  if (!_M_is_pow2(align)) {
 #ifndef __CCMS__SUPPRESS_WARNINGS
-    // Print a warning message
     fprintf(stderr,
-            "warning: tried allocating a chunk of size %ld from an arena (page "
-            "allocated) with page size %ld, returned NULL\n",
-            size, self->page_size);
+            "warning: tried allocating a chunk with alignment %ld (not a power "
+            "of two) from an arena (page allocated), returned NULL\n",
+            align);
 #endif
-    // Return NULL as we cannot allocate a chunk larger than the page size
     return NULL;
   }
 
+  // Page data is aligned to max_align_t, so this is the most padding a chunk
+  // can need at the start of a fresh page
+  const size_t max_pad = align > _M_MAX_ALIGN ? align - _M_MAX_ALIGN : 0;
+
+  // If the requested chunk would not even fit into an empty page, it gets a
+  // block of its own
+  if (size > self->page_size || self->page_size - size < max_pad)
+    return _pg_arena__alloc_large(self, size, align);
+
+  size_t pad = _pg_arena_page__pad(self->tail, align);
+
   // If the remaining space in the current page is less than the requested size
-  if (self->page_size - self->tail->pos < size) {
+  // (including the padding needed for alignment)
+  if (self->tail->size - self->tail->pos < size ||
+      self->tail->size - self->tail->pos - size < pad) {
     if (self->tail->next == NULL)
       // Allocate a new page and set it as the next page
-      self->tail->next = _pg_arena_page__new(self->page_size, NULL);
+      self->tail->next =
+          _pg_arena__page_new(self, _pg_arena__next_page_size(self));
+
+#ifdef __CCMS__ARENA_STATS
+    _arena_stats__waste(&self->stats, self->tail->size - self->tail->pos);
+#endif
 
-    // Move tail to the next page
+    // Move tail to the next page, which may still hold the position from before
+    // the last reset
     self->tail = self->tail->next;
+    self->nused++;
+    _pg_arena_page__reset(self->tail);
+    pad = _pg_arena_page__pad(self->tail, align);
+
+    // Only possible if _M_alloc returned less aligned memory than malloc would
+    if (self->tail->size - size < pad)
+      return _pg_arena__alloc_large(self, size, align);
   }
 
-  // Calculate the address of the new chunk by adding the size of the
-  // _pg_arena_page_t struct and the current position to the address of the
-  // current page
-  uint8_t* result = _M_cast(uint8_t*, self->tail) + sizeof(_pg_arena_page_t) +
-                    self->tail->pos;
+  // Calculate the address of the new chunk by adding the current position and
+  // the alignment padding to the start of the current page's data
+  uint8_t* result = _pg_arena_page__data(self->tail) + self->tail->pos + pad;
   // Update the position in the current page
-  self->tail->pos += size;
+  self->tail->pos += pad + size;
+#ifdef __CCMS__ARENA_STATS
+  _arena_stats__alloc(&self->stats, size, pad);
+#endif
 
   // Return the address of the new chunk
   return result;
 }
 
+__CCMS__INLINE
+uint8_t* pg_arena__alloc(pg_arena_t* self, const size_t size) {
+  return pg_arena__alloc_aligned(self, size, __CCMS__DEFAULT_ALIGN);
+}
+
+// Whether the chunk [ptr, ptr + size) is the last one allocated from the
+// current page
+__CCMS__INLINE
+int _pg_arena__is_last(const pg_arena_t* self,
+                       const uint8_t* ptr,
+                       const size_t size) {
+  return ptr + size == _pg_arena_page__data(self->tail) + self->tail->pos;
+}
+
+// Gives back the end of the chunk at `ptr` if it is the last one allocated,
+// otherwise the chunk just keeps its old size. The chunk never moves.
+__CCMS__INLINE
+void pg_arena__shrink(pg_arena_t* self,
+                      uint8_t* ptr,
+                      const size_t old_size,
+                      const size_t new_size) {
+  if (new_size < old_size && _pg_arena__is_last(self, ptr, old_size)) {
+    self->tail->pos -= old_size - new_size;
+#ifdef __CCMS__ARENA_STATS
+    self->stats.in_use -= old_size - new_size;
+#endif
+  }
+}
+
+// Resizes the chunk at `ptr` from `old_size` to `new_size` bytes. The last
+// chunk allocated grows in place as long as the current page has room for it,
+// otherwise a growing chunk is moved to a new chunk aligned to `align`.
+// Returns NULL if that allocation fails, `ptr` stays valid in that case.
+__CCMS__INLINE
+uint8_t* pg_arena__realloc_aligned(pg_arena_t* self,
+                                   uint8_t* ptr,
+                                   const size_t old_size,
+                                   const size_t new_size,
+                                   const size_t align) {
+  if (ptr == NULL) return pg_arena__alloc_aligned(self, new_size, align);
+
+  if (new_size <= old_size) {
+    pg_arena__shrink(self, ptr, old_size, new_size);
+    return ptr;
+  }
+
+  if (_pg_arena__is_last(self, ptr, old_size) &&
+      self->tail->size - self->tail->pos >= new_size - old_size) {
+    self->tail->pos += new_size - old_size;
+#ifdef __CCMS__ARENA_STATS
+    _arena_stats__grow(&self->stats, new_size - old_size);
+#endif
+    return ptr;
+  }
+
+  uint8_t* result = pg_arena__alloc_aligned(self, new_size, align);
+  if (result != NULL) memcpy(result, ptr, old_size);
+
+  return result;
+}
+
+__CCMS__INLINE
+uint8_t* pg_arena__realloc(pg_arena_t* self,
+                           uint8_t* ptr,
+                           const size_t old_size,
+                           const size_t new_size) {
+  return pg_arena__realloc_aligned(self, ptr, old_size, new_size,
+                                   __CCMS__DEFAULT_ALIGN);
+}
+
+// A position in an arena that it can later be rewound to
+typedef struct pg_arena_mark_t pg_arena_mark_t;
+
+struct pg_arena_mark_t {
+  _pg_arena_page_t* page;
+  size_t pos;
+  size_t nused;
+  _pg_arena_large_t* large;
+#ifdef __CCMS__ARENA_STATS
+  size_t in_use;
+#endif
+};
+
+__CCMS__INLINE
+pg_arena_mark_t pg_arena__mark(const pg_arena_t* self) {
+  return (pg_arena_mark_t){
+      .page = self->tail,
+      .pos = self->tail->pos,
+      .nused = self->nused,
+      .large = self->large,
+#ifdef __CCMS__ARENA_STATS
+      .in_use = self->stats.in_use,
+#endif
+  };
+}
+
+// Frees everything allocated since the mark was taken: the pages behind it
+// become available again (they are reset lazily, like on pg_arena__reset) and
+// large blocks are freed or kept, depending on pg_arena__set_keep_large. The
+// mark becomes invalid if the arena is reset in between.
+__CCMS__INLINE
+void pg_arena__rewind(pg_arena_t* self, const pg_arena_mark_t mark) {
+  self->tail = mark.page;
+  self->tail->pos = mark.pos;
+  self->nused = mark.nused;
+#ifdef __CCMS__ARENA_STATS
+  self->stats.in_use = mark.in_use;
+#endif
+
+  // Large blocks are pushed to the front, so the ones allocated after the mark
+  // are exactly the ones in front of mark.large
+  while (self->large != mark.large) {
+    _pg_arena_large_t* block = self->large;
+    self->large = block->next;
+
+    if (self->keep_large) {
+      block->next = self->large_free;
+      self->large_free = block;
+    } else {
+#ifdef __CCMS__ARENA_STATS
+      _arena_stats__block_free(&self->stats,
+                               _PG_ARENA_LARGE_HEADER_SIZE + block->size);
+#endif
+      _M_free(block);
+    }
+  }
+}
+
+// Runs the following statement/block as a scratch scope: everything allocated
+// from the arena inside of it is freed when the block is left normally (not by
+// break, goto or return). Scopes can be nested.
+#define pg_arena__scope(self)                                           \
+  for (pg_arena_mark_t __ccms_scope_mark = pg_arena__mark(self),        \
+                       *__ccms_scope_once = &__ccms_scope_mark;         \
+       __ccms_scope_once != NULL;                                       \
+       pg_arena__rewind(self, __ccms_scope_mark), __ccms_scope_once = NULL)
+
+// Walks all pages in use, see pg_arena__stats for numbers that are cheap to
+// poll
 __CCMS__INLINE
 float pg_arena__avg_util(const pg_arena_t* self) {
   float sum = 0.f;
-  size_t len = 0;
 
-  for (_pg_arena_page_t* itr = self->head; itr != NULL; itr = itr->next, len++)
-    sum += _M_cast(float, itr->pos) / self->page_size;
+  // Pages behind the tail are unused, whatever their (stale) position says
+  for (_pg_arena_page_t* itr = self->head; itr != NULL; itr = itr->next) {
+    sum += _M_cast(float, itr->pos) / itr->size;
+    if (itr == self->tail) break;
+  }
+
+  return sum / self->npages;
+}
 
-  return sum / len;
+#ifdef __CCMS__ARENA_STATS
+__CCMS__INLINE
+arena_stats_t pg_arena__stats(const pg_arena_t* self) {
+  return self->stats;
 }
+#endif
 
 #ifdef __cplusplus
 }
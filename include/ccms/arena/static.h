@@ -26,34 +26,88 @@ extern "C" {
 
 #include <stddef.h>
 #include <stdint.h>
-#include <string.h>
-
-#ifndef __CCMS__SUPPRESS_WARNINGS
 #include <stdio.h>
-#endif
+#include <string.h>
 
 #include "ccms/_defs.h"
 #include "ccms/_macros.h"
+#include "ccms/_os.h"
+
+#ifdef __CCMS__ARENA_STATS
+#include "ccms/arena/stats.h"
+#endif
 
 typedef struct st_arena_t st_arena_t;
 
 struct st_arena_t {
   uint8_t* writehead;
   size_t size;
+  // Whether the arena lives in huge pages, see st_arena__new_huge
+  int huge;
+#ifdef __CCMS__ARENA_STATS
+  arena_stats_t stats;
+#endif
 };
 
+// The data region starts right after the header, which is padded to
+// max_align_t so that the first allocation is as aligned as malloc itself.
+#define _ST_ARENA_HEADER_SIZE _M_align_up(sizeof(st_arena_t), _M_MAX_ALIGN)
+
 __CCMS__INLINE
 st_arena_t* st_arena__new(const size_t size) {
-  st_arena_t* self = _M_cast(st_arena_t*, _M_alloc(sizeof(st_arena_t) + size));
+  st_arena_t* self =
+      _M_cast(st_arena_t*, _M_alloc(_ST_ARENA_HEADER_SIZE + size));
 
-  self->writehead = _M_cast(uint8_t*, self) + sizeof(st_arena_t);
+  self->writehead = _M_cast(uint8_t*, self) + _ST_ARENA_HEADER_SIZE;
   self->size = size;
+  self->huge = 0;
+#ifdef __CCMS__ARENA_STATS
+  self->stats = (arena_stats_t){0};
+#endif
+
+  return self;
+}
+
+#ifdef __CCMS__HAS_VMEM
+// Creates an arena of at least `size` bytes in memory aligned to
+// __CCMS__HUGE_PAGE_SIZE, backed by huge pages where possible (see
+// _os__alloc_huge), so that random access over a large arena needs far fewer
+// TLB entries. The size is rounded up to fill the last huge page. Returns NULL
+// if the memory can not be mapped.
+__CCMS__INLINE
+st_arena_t* st_arena__new_huge(const size_t size) {
+  size_t total = _ST_ARENA_HEADER_SIZE + size;
+  st_arena_t* self = _M_cast(st_arena_t*, _os__alloc_huge(&total));
+
+  if (self == NULL) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+    fprintf(stderr,
+            "warning: failed to map %ld bytes for an arena (static), returned "
+            "NULL\n",
+            total);
+#endif
+    return NULL;
+  }
+
+  self->writehead = _M_cast(uint8_t*, self) + _ST_ARENA_HEADER_SIZE;
+  self->size = total - _ST_ARENA_HEADER_SIZE;
+  self->huge = 1;
+#ifdef __CCMS__ARENA_STATS
+  self->stats = (arena_stats_t){0};
+#endif
 
   return self;
 }
+#endif
 
 __CCMS__INLINE
 void st_arena__free(st_arena_t* self) {
+#ifdef __CCMS__HAS_VMEM
+  if (self->huge) {
+    _os__release(_M_cast(uint8_t*, self), _ST_ARENA_HEADER_SIZE + self->size);
+    return;
+  }
+#endif
   _M_free(self);
 }
 
@@ -62,41 +116,249 @@ st_arena_t* st_arena__clone(const st_arena_t* self) {
   st_arena_t* other = st_arena__new(self->size);
   size_t wh_offset = _M_cast(size_t, self->writehead - _M_cast(uint8_t*, self));
 
-  memcpy(other, self, self->size + sizeof(st_arena_t));
+  memcpy(other, self, self->size + _ST_ARENA_HEADER_SIZE);
   other->writehead = _M_cast(uint8_t*, other) + wh_offset;
+  // The clone always lives in regular memory
+  other->huge = 0;
 
   return other;
 }
 
 __CCMS__INLINE
 size_t st_arena__cap(const st_arena_t* self) {
-  return (self->size + sizeof(st_arena_t)) -
+  return (self->size + _ST_ARENA_HEADER_SIZE) -
          _M_cast(size_t, self->writehead - _M_cast(uint8_t*, self));
 }
 
 __CCMS__INLINE
 void st_arena__reset(st_arena_t* self) {
-  self->writehead = _M_cast(uint8_t*, self) + sizeof(st_arena_t);
+  self->writehead = _M_cast(uint8_t*, self) + _ST_ARENA_HEADER_SIZE;
+#ifdef __CCMS__ARENA_STATS
+  _arena_stats__reset(&self->stats);
+#endif
 }
 
+// Start of the data region, the first chunk allocated (with an alignment of
+// at most max_align_t) starts here
 __CCMS__INLINE
-uint8_t* st_arena__alloc(st_arena_t* self, const size_t size) {
-  if (st_arena__cap(self) < size) {
+uint8_t* st_arena__data(const st_arena_t* self) {
+  return _M_cast(uint8_t*, self) + _ST_ARENA_HEADER_SIZE;
+}
+
+// Writes the used part of the data region to the file at `path`, so that it
+// can be loaded again with st_arena__load or vm_arena__load. Pointers into the
+// arena are only valid after loading if they are relative (see relptr_t).
+// Returns 0 on success.
+__CCMS__INLINE
+int st_arena__save(const st_arena_t* self, const char* path) {
+  const size_t used = _M_cast(size_t, self->writehead - st_arena__data(self));
+  FILE* file = fopen(path, "wb");
+  int result = -1;
+
+  if (file != NULL) {
+    result = fwrite(st_arena__data(self), 1, used, file) == used ? 0 : -1;
+    if (fclose(file) != 0) result = -1;
+  }
+
+#ifndef __CCMS__SUPPRESS_WARNINGS
+  if (result != 0)
+    fprintf(stderr, "warning: failed to save an arena (static) to '%s'\n",
+            path);
+#endif
+  return result;
+}
+
+// Creates an arena with `size` bytes of data and reads a file written by
+// st_arena__save or vm_arena__save into it, as if its contents had just been
+// allocated. Chunks keep their offsets from st_arena__data, so alignments
+// beyond max_align_t are not preserved. Returns NULL if the file can not be
+// read or is larger than `size`. See vm_arena__load for mapping the file
+// instead of reading it.
+__CCMS__INLINE
+st_arena_t* st_arena__load(const char* path, const size_t size) {
+  FILE* file = fopen(path, "rb");
+  st_arena_t* self = NULL;
+
+  if (file != NULL) {
+    self = st_arena__new(size);
+
+    const size_t used = fread(st_arena__data(self), 1, size, file);
+    // The file has to end within the arena
+    if (ferror(file) || (used == size && fgetc(file) != EOF)) {
+      st_arena__free(self);
+      self = NULL;
+    } else {
+      self->writehead = st_arena__data(self) + used;
+#ifdef __CCMS__ARENA_STATS
+      _arena_stats__alloc(&self->stats, used, 0);
+#endif
+    }
+    fclose(file);
+  }
+
+#ifndef __CCMS__SUPPRESS_WARNINGS
+  if (self == NULL)
+    fprintf(stderr,
+            "warning: failed to load '%s' into an arena (static) of size %ld, "
+            "returned NULL\n",
+            path, size);
+#endif
+  return self;
+}
+
+// A position in an arena that it can later be rewound to
+typedef struct st_arena_mark_t st_arena_mark_t;
+
+struct st_arena_mark_t {
+  uint8_t* writehead;
+};
+
+__CCMS__INLINE
+st_arena_mark_t st_arena__mark(const st_arena_t* self) {
+  return (st_arena_mark_t){.writehead = self->writehead};
+}
+
+// Frees everything allocated since the mark was taken. The mark becomes
+// invalid if the arena is reset in between.
+__CCMS__INLINE
+void st_arena__rewind(st_arena_t* self, const st_arena_mark_t mark) {
+  self->writehead = mark.writehead;
+#ifdef __CCMS__ARENA_STATS
+  self->stats.in_use = _M_cast(size_t, mark.writehead - st_arena__data(self));
+#endif
+}
+
+// Runs the following statement/block as a scratch scope: everything allocated
+// from the arena inside of it is freed when the block is left normally (not by
+// break, goto or return). Scopes can be nested.
+#define st_arena__scope(self)                                           \
+  for (st_arena_mark_t __ccms_scope_mark = st_arena__mark(self),        \
+                       *__ccms_scope_once = &__ccms_scope_mark;         \
+       __ccms_scope_once != NULL;                                       \
+       st_arena__rewind(self, __ccms_scope_mark), __ccms_scope_once = NULL)
+
+__CCMS__INLINE
+uint8_t* st_arena__alloc_aligned(st_arena_t* self,
+                                 const size_t size,
+                                 const size_t align) {
+  if (!_M_is_pow2(align)) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+    fprintf(stderr,
+            "warning: tried to allocate a chunk of memory with alignment %ld "
+            "(not a power of two) from an arena (static), returned NULL\n",
+            align);
+#endif
+    return NULL;
+  }
+
+  // Number of bytes needed to move the writehead to the next multiple of align
+  const size_t pad = _M_align_pad(_M_cast(uintptr_t, self->writehead),
+                                  _M_cast(uintptr_t, align));
+  const size_t cap = st_arena__cap(self);
+
+  if (cap < pad || cap - pad < size) {
 #ifndef __CCMS__SUPPRESS_WARNINGS
     fprintf(stderr,
-            "warning: tried to allocate a chunk of memory of size %ld from an "
-            "arena (static) with only %ld free memory, returned NULL\n",
-            size, st_arena__cap(self));
+            "warning: tried to allocate a chunk of memory of size %ld "
+            "(alignment %ld) from an arena (static) with only %ld free memory, "
+            "returned NULL\n",
+            size, align, cap);
 #endif
     return NULL;
   }
 
-  uint8_t* result = self->writehead;
-  self->writehead += size;
+  uint8_t* result = self->writehead + pad;
+  self->writehead = result + size;
+#ifdef __CCMS__ARENA_STATS
+  _arena_stats__alloc(&self->stats, size, pad);
+#endif
+
+  return result;
+}
+
+__CCMS__INLINE
+uint8_t* st_arena__alloc(st_arena_t* self, const size_t size) {
+  return st_arena__alloc_aligned(self, size, __CCMS__DEFAULT_ALIGN);
+}
+
+// Gives back the end of the chunk at `ptr` if it is the last one allocated,
+// otherwise the chunk just keeps its old size. The chunk never moves.
+__CCMS__INLINE
+void st_arena__shrink(st_arena_t* self,
+                      uint8_t* ptr,
+                      const size_t old_size,
+                      const size_t new_size) {
+  if (new_size < old_size && ptr + old_size == self->writehead) {
+    self->writehead = ptr + new_size;
+#ifdef __CCMS__ARENA_STATS
+    self->stats.in_use -= old_size - new_size;
+#endif
+  }
+}
+
+// Resizes the chunk at `ptr` from `old_size` to `new_size` bytes. The last
+// chunk allocated is resized in place by moving the writehead, any other chunk
+// is only moved (to a new chunk aligned to `align`) when it grows.
+// Returns NULL if the arena has no room left, `ptr` stays valid in that case.
+__CCMS__INLINE
+uint8_t* st_arena__realloc_aligned(st_arena_t* self,
+                                   uint8_t* ptr,
+                                   const size_t old_size,
+                                   const size_t new_size,
+                                   const size_t align) {
+  if (ptr == NULL) return st_arena__alloc_aligned(self, new_size, align);
+
+  if (new_size <= old_size) {
+    st_arena__shrink(self, ptr, old_size, new_size);
+    return ptr;
+  }
+
+  if (ptr + old_size == self->writehead) {
+    if (st_arena__cap(self) < new_size - old_size) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+      fprintf(stderr,
+              "warning: tried to grow a chunk of memory from size %ld to %ld "
+              "in an arena (static) with only %ld free memory, returned "
+              "NULL\n",
+              old_size, new_size, st_arena__cap(self));
+#endif
+      return NULL;
+    }
+
+    self->writehead = ptr + new_size;
+#ifdef __CCMS__ARENA_STATS
+    _arena_stats__grow(&self->stats, new_size - old_size);
+#endif
+    return ptr;
+  }
+
+  uint8_t* result = st_arena__alloc_aligned(self, new_size, align);
+  if (result != NULL) memcpy(result, ptr, old_size);
 
   return result;
 }
 
+__CCMS__INLINE
+uint8_t* st_arena__realloc(st_arena_t* self,
+                           uint8_t* ptr,
+                           const size_t old_size,
+                           const size_t new_size) {
+  return st_arena__realloc_aligned(self, ptr, old_size, new_size,
+                                   __CCMS__DEFAULT_ALIGN);
+}
+
+#ifdef __CCMS__ARENA_STATS
+__CCMS__INLINE
+arena_stats_t st_arena__stats(const st_arena_t* self) {
+  arena_stats_t stats = self->stats;
+
+  stats.reserved = _ST_ARENA_HEADER_SIZE + self->size;
+  stats.blocks = 1;
+
+  return stats;
+}
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,111 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+#ifndef __CCMS__ARENAS__STATS__H
+#define __CCMS__ARENAS__STATS__H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#include "ccms/_defs.h"
+
+// Allocation statistics of an arena, as returned by the `*_stats` functions
+// that every arena provides when compiled with __CCMS__ARENA_STATS. They are
+// updated incrementally by the allocating and resetting functions, so a query
+// is O(1) and cheap enough to poll.
+//
+// Counters only ever grow over the lifetime of the arena; the other fields
+// describe the arena at the time of the query.
+typedef struct arena_stats_t {
+  // Successful allocations, including reallocs that had to move the chunk
+  size_t allocs;
+  // Resets of any kind (reset, hard reset)
+  size_t resets;
+  // Bytes requested by callers, including in-place growth of chunks
+  size_t requested;
+  // Bytes skipped to align chunks
+  size_t padding;
+  // Bytes left unused at the end of a page or chunk when moving on to the next
+  size_t wasted;
+  // Bytes taken up since the last reset: chunks plus their padding and waste
+  size_t in_use;
+  // Highest value in_use has reached
+  size_t peak;
+  // Bytes of memory currently held by the arena, including headers (committed
+  // memory for vm_arena_t)
+  size_t reserved;
+  // Pages, chunks and blocks currently held by the arena (1 for arenas made of
+  // a single region)
+  size_t blocks;
+} arena_stats_t;
+
+__CCMS__INLINE
+void _arena_stats__alloc(arena_stats_t* self,
+                         const size_t size,
+                         const size_t pad) {
+  self->allocs++;
+  self->requested += size;
+  self->padding += pad;
+  self->in_use += pad + size;
+  if (self->in_use > self->peak) self->peak = self->in_use;
+}
+
+// The last chunk grew in place by `size` bytes
+__CCMS__INLINE
+void _arena_stats__grow(arena_stats_t* self, const size_t size) {
+  self->requested += size;
+  self->in_use += size;
+  if (self->in_use > self->peak) self->peak = self->in_use;
+}
+
+// The rest of a page or chunk is skipped
+__CCMS__INLINE
+void _arena_stats__waste(arena_stats_t* self, const size_t size) {
+  self->wasted += size;
+  self->in_use += size;
+  if (self->in_use > self->peak) self->peak = self->in_use;
+}
+
+__CCMS__INLINE
+void _arena_stats__reset(arena_stats_t* self) {
+  self->resets++;
+  self->in_use = 0;
+}
+
+// A block of `size` bytes (including its header) was taken from the system
+__CCMS__INLINE
+void _arena_stats__block_new(arena_stats_t* self, const size_t size) {
+  self->blocks++;
+  self->reserved += size;
+}
+
+__CCMS__INLINE
+void _arena_stats__block_free(arena_stats_t* self, const size_t size) {
+  self->blocks--;
+  self->reserved -= size;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __CCMS__ARENAS__STATS__H
@@ -0,0 +1,371 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+#ifndef __CCMS__ARENAS__VIRTUAL__H
+#define __CCMS__ARENAS__VIRTUAL__H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ccms/_defs.h"
+#include "ccms/_macros.h"
+#include "ccms/_os.h"
+
+#ifdef __CCMS__ARENA_STATS
+#include "ccms/arena/stats.h"
+#endif
+
+#ifndef __CCMS__HAS_VMEM
+// On POSIX systems, mmap needs _GNU_SOURCE or _DEFAULT_SOURCE with -std=c11
+#error "ccms/arena/virtual.h requires mmap or VirtualAlloc"
+#endif
+
+// Memory is committed in steps of (at least) this many bytes as the arena
+// grows, so that not every allocation that crosses a page needs a syscall.
+#ifndef __CCMS__VM_ARENA_COMMIT_SIZE
+#define __CCMS__VM_ARENA_COMMIT_SIZE 65536
+#endif
+
+// An arena backed by one contiguous range of reserved address space. Only the
+// part in use is committed (backed by memory), so the reservation can be many
+// gigabytes large while the arena grows in place: there are no page chains and
+// chunks of any size up to the reservation can be allocated.
+
+typedef struct vm_arena_t vm_arena_t;
+
+struct vm_arena_t {
+  uint8_t* base;
+  size_t pos;
+  size_t committed;
+  size_t reserved;
+  size_t commit_size;
+#ifdef __CCMS__ARENA_STATS
+  arena_stats_t stats;
+#endif
+};
+
+__CCMS__INLINE
+vm_arena_t* vm_arena__new(const size_t reserve) {
+  vm_arena_t* self = _M_new(vm_arena_t);
+  const size_t page_size = _os__page_size();
+
+  self->commit_size = _M_align_up(__CCMS__VM_ARENA_COMMIT_SIZE, page_size);
+  self->reserved = _M_align_up(reserve, page_size);
+  self->pos = self->committed = 0;
+#ifdef __CCMS__ARENA_STATS
+  self->stats = (arena_stats_t){0};
+#endif
+  self->base = _os__reserve(self->reserved);
+
+  if (self->base == NULL) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+    fprintf(stderr,
+            "warning: failed to reserve %ld bytes of address space for an "
+            "arena (virtual), returned NULL\n",
+            self->reserved);
+#endif
+    _M_free(self);
+    return NULL;
+  }
+
+  return self;
+}
+
+// Creates an arena like vm_arena__new whose reservation is aligned to
+// __CCMS__HUGE_PAGE_SIZE and marked for transparent huge pages (where the
+// system supports them), and which commits memory in whole huge pages, so that
+// the kernel can back it with huge pages as it is touched.
+__CCMS__INLINE
+vm_arena_t* vm_arena__new_huge(const size_t reserve) {
+  const size_t huge = __CCMS__HUGE_PAGE_SIZE;
+  vm_arena_t* self = _M_new(vm_arena_t);
+
+  self->commit_size = _M_align_up(__CCMS__VM_ARENA_COMMIT_SIZE, huge);
+  self->reserved = _M_align_up(reserve, huge);
+  self->pos = self->committed = 0;
+#ifdef __CCMS__ARENA_STATS
+  self->stats = (arena_stats_t){0};
+#endif
+  self->base = _os__reserve_aligned(self->reserved, huge);
+
+  if (self->base == NULL) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+    fprintf(stderr,
+            "warning: failed to reserve %ld bytes of address space for an "
+            "arena (virtual), returned NULL\n",
+            self->reserved);
+#endif
+    _M_free(self);
+    return NULL;
+  }
+
+  // Only a hint, regular pages are fine as well
+  _os__advise(self->base, self->reserved, _OS_ADVICE_HUGEPAGE);
+  return self;
+}
+
+__CCMS__INLINE
+void vm_arena__free(vm_arena_t* self) {
+  _os__release(self->base, self->reserved);
+  _M_free(self);
+}
+
+// Reserves `reserve` bytes (at least the size of the file) and places a file
+// written by vm_arena__save or st_arena__save at the start of the arena, as if
+// its contents had just been allocated. The file is mapped copy-on-write, so
+// nothing is read up front and untouched pages are shared with the page cache
+// (on Windows it is read into the arena instead). Data containing only
+// relative pointers (see relptr_t) is usable right away and the arena can keep
+// growing behind it. Returns NULL if the file can not be loaded.
+__CCMS__INLINE
+vm_arena_t* vm_arena__load(const char* path, const size_t reserve) {
+  vm_arena_t* self = vm_arena__new(reserve);
+  size_t size = 0;
+
+  if (self != NULL &&
+      _os__load_file(path, self->base, self->reserved, &size) != 0) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+    fprintf(stderr,
+            "warning: failed to load '%s' into an arena (virtual) reserving "
+            "%ld bytes, returned NULL\n",
+            path, self->reserved);
+#endif
+    vm_arena__free(self);
+    return NULL;
+  }
+
+  if (self != NULL) {
+    self->pos = size;
+    self->committed = _M_align_up(size, _os__page_size());
+#ifdef __CCMS__ARENA_STATS
+    _arena_stats__alloc(&self->stats, size, 0);
+#endif
+  }
+
+  return self;
+}
+
+// Writes the used part of the arena to the file at `path`, see
+// vm_arena__load. Returns 0 on success.
+__CCMS__INLINE
+int vm_arena__save(const vm_arena_t* self, const char* path) {
+  FILE* file = fopen(path, "wb");
+  int result = -1;
+
+  if (file != NULL) {
+    result = fwrite(self->base, 1, self->pos, file) == self->pos ? 0 : -1;
+    if (fclose(file) != 0) result = -1;
+  }
+
+#ifndef __CCMS__SUPPRESS_WARNINGS
+  if (result != 0)
+    fprintf(stderr, "warning: failed to save an arena (virtual) to '%s'\n",
+            path);
+#endif
+  return result;
+}
+
+__CCMS__INLINE
+size_t vm_arena__cap(const vm_arena_t* self) {
+  return self->reserved - self->pos;
+}
+
+// Rewinds the arena to its start. The committed memory is kept for reuse, see
+// vm_arena__decommit for returning it to the operating system.
+__CCMS__INLINE
+void vm_arena__reset(vm_arena_t* self) {
+  self->pos = 0;
+#ifdef __CCMS__ARENA_STATS
+  _arena_stats__reset(&self->stats);
+#endif
+}
+
+// Returns all committed memory that lies beyond the current position to the
+// operating system (madvise(MADV_DONTNEED) / MEM_DECOMMIT).
+__CCMS__INLINE
+void vm_arena__decommit(vm_arena_t* self) {
+  const size_t keep = _M_align_up(self->pos, self->commit_size);
+
+  if (keep < self->committed) {
+    _os__decommit(self->base + keep, self->committed - keep);
+    self->committed = keep;
+  }
+}
+
+// Commits memory so that at least the first `end` bytes are usable.
+__CCMS__INLINE
+int _vm_arena__commit(vm_arena_t* self, const size_t end) {
+  size_t target = _M_align_up(end, self->commit_size);
+
+  if (target > self->reserved) target = self->reserved;
+  if (_os__commit(self->base + self->committed, target - self->committed) != 0)
+    return -1;
+
+  self->committed = target;
+  return 0;
+}
+
+__CCMS__INLINE
+uint8_t* vm_arena__alloc_aligned(vm_arena_t* self,
+                                 const size_t size,
+                                 const size_t align) {
+  if (!_M_is_pow2(align)) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+    fprintf(stderr,
+            "warning: tried to allocate a chunk of memory with alignment %ld "
+            "(not a power of two) from an arena (virtual), returned NULL\n",
+            align);
+#endif
+    return NULL;
+  }
+
+  const size_t pad = _M_align_pad(_M_cast(uintptr_t, self->base + self->pos),
+                                  _M_cast(uintptr_t, align));
+  const size_t cap = vm_arena__cap(self);
+
+  if (cap < pad || cap - pad < size) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+    fprintf(stderr,
+            "warning: tried to allocate a chunk of memory of size %ld "
+            "(alignment %ld) from an arena (virtual) with only %ld reserved "
+            "memory left, returned NULL\n",
+            size, align, cap);
+#endif
+    return NULL;
+  }
+
+  const size_t end = self->pos + pad + size;
+
+  if (end > self->committed && _vm_arena__commit(self, end) != 0) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+    fprintf(stderr,
+            "warning: failed to commit memory for a chunk of size %ld in an "
+            "arena (virtual), returned NULL\n",
+            size);
+#endif
+    return NULL;
+  }
+
+  uint8_t* result = self->base + self->pos + pad;
+  self->pos = end;
+#ifdef __CCMS__ARENA_STATS
+  _arena_stats__alloc(&self->stats, size, pad);
+#endif
+
+  return result;
+}
+
+__CCMS__INLINE
+uint8_t* vm_arena__alloc(vm_arena_t* self, const size_t size) {
+  return vm_arena__alloc_aligned(self, size, __CCMS__DEFAULT_ALIGN);
+}
+
+// Gives back the end of the chunk at `ptr` if it is the last one allocated,
+// otherwise the chunk just keeps its old size. The chunk never moves and no
+// memory is decommitted, see vm_arena__decommit for that.
+__CCMS__INLINE
+void vm_arena__shrink(vm_arena_t* self,
+                      uint8_t* ptr,
+                      const size_t old_size,
+                      const size_t new_size) {
+  if (new_size < old_size && ptr + old_size == self->base + self->pos) {
+    self->pos -= old_size - new_size;
+#ifdef __CCMS__ARENA_STATS
+    self->stats.in_use -= old_size - new_size;
+#endif
+  }
+}
+
+// Resizes the chunk at `ptr` from `old_size` to `new_size` bytes. The last
+// chunk allocated is resized in place (committing memory as needed), any other
+// chunk is only moved (to a new chunk aligned to `align`) when it grows.
+// Returns NULL if the reservation is exhausted or committing fails, `ptr`
+// stays valid in that case.
+__CCMS__INLINE
+uint8_t* vm_arena__realloc_aligned(vm_arena_t* self,
+                                   uint8_t* ptr,
+                                   const size_t old_size,
+                                   const size_t new_size,
+                                   const size_t align) {
+  if (ptr == NULL) return vm_arena__alloc_aligned(self, new_size, align);
+
+  if (new_size <= old_size) {
+    vm_arena__shrink(self, ptr, old_size, new_size);
+    return ptr;
+  }
+
+  if (ptr + old_size == self->base + self->pos) {
+    const size_t end = self->pos + (new_size - old_size);
+
+    if (vm_arena__cap(self) < new_size - old_size ||
+        (end > self->committed && _vm_arena__commit(self, end) != 0)) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+      fprintf(stderr,
+              "warning: failed to grow a chunk of memory from size %ld to %ld "
+              "in an arena (virtual), returned NULL\n",
+              old_size, new_size);
+#endif
+      return NULL;
+    }
+
+    self->pos = end;
+#ifdef __CCMS__ARENA_STATS
+    _arena_stats__grow(&self->stats, new_size - old_size);
+#endif
+    return ptr;
+  }
+
+  uint8_t* result = vm_arena__alloc_aligned(self, new_size, align);
+  if (result != NULL) memcpy(result, ptr, old_size);
+
+  return result;
+}
+
+__CCMS__INLINE
+uint8_t* vm_arena__realloc(vm_arena_t* self,
+                           uint8_t* ptr,
+                           const size_t old_size,
+                           const size_t new_size) {
+  return vm_arena__realloc_aligned(self, ptr, old_size, new_size,
+                                   __CCMS__DEFAULT_ALIGN);
+}
+
+#ifdef __CCMS__ARENA_STATS
+__CCMS__INLINE
+arena_stats_t vm_arena__stats(const vm_arena_t* self) {
+  arena_stats_t stats = self->stats;
+
+  stats.reserved = self->committed;
+  stats.blocks = 1;
+
+  return stats;
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __CCMS__ARENAS__VIRTUAL__H
@@ -26,8 +26,16 @@ extern "C" {
 
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "ccms/_defs.h"
+#include "ccms/_macros.h"
+
+#if defined(__CCMS__HAS_AVX2)
+#include <immintrin.h>
+#elif defined(__CCMS__HAS_SSE2)
+#include <emmintrin.h>
+#endif
 
 /**
  * @typedef box_t
@@ -85,6 +93,454 @@ box_t box__clone(const box_t* other) {
   return (box_t){.ptr = other->ptr, .size = other->size};
 }
 
+//
+//
+// ------------------ comparison ------------------
+//
+//
+
+// Reads are little-endian on every host, so that hashes are the same
+// everywhere and the lowest set bit of a xor is the first differing byte
+__CCMS__INLINE
+uint64_t _box__read64(const uint8_t* ptr) {
+  uint64_t word;
+  memcpy(&word, ptr, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  word = __builtin_bswap64(word);
+#endif
+  return word;
+}
+
+__CCMS__INLINE
+uint64_t _box__read32(const uint8_t* ptr) {
+  uint32_t word;
+  memcpy(&word, ptr, 4);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  word = __builtin_bswap32(word);
+#endif
+  return word;
+}
+
+__CCMS__INLINE
+size_t _box__ctz64(const uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+  return _M_cast(size_t, __builtin_ctzll(word));
+#else
+  size_t n = 0;
+  while (!(word & (_M_cast(uint64_t, 1) << n)))
+    n++;
+  return n;
+#endif
+}
+
+#if defined(__CCMS__HAS_AVX2)
+__CCMS__INLINE
+__m256i _box__xor256(const uint8_t* a, const uint8_t* b) {
+  return _mm256_xor_si256(_mm256_loadu_si256(_M_cast(const __m256i*, a)),
+                          _mm256_loadu_si256(_M_cast(const __m256i*, b)));
+}
+
+// Non-zero if any of the 128 bytes at `a` and `b` differ
+__CCMS__INLINE
+__m256i _box__xor256x4(const uint8_t* a, const uint8_t* b) {
+  return _mm256_or_si256(
+      _mm256_or_si256(_box__xor256(a, b), _box__xor256(a + 32, b + 32)),
+      _mm256_or_si256(_box__xor256(a + 64, b + 64),
+                      _box__xor256(a + 96, b + 96)));
+}
+#endif
+
+#if defined(__CCMS__HAS_SSE2)
+__CCMS__INLINE
+__m128i _box__xor128(const uint8_t* a, const uint8_t* b) {
+  return _mm_xor_si128(_mm_loadu_si128(_M_cast(const __m128i*, a)),
+                       _mm_loadu_si128(_M_cast(const __m128i*, b)));
+}
+
+// Non-zero if any of the 64 bytes at `a` and `b` differ
+__CCMS__INLINE
+__m128i _box__xor128x4(const uint8_t* a, const uint8_t* b) {
+  return _mm_or_si128(
+      _mm_or_si128(_box__xor128(a, b), _box__xor128(a + 16, b + 16)),
+      _mm_or_si128(_box__xor128(a + 32, b + 32), _box__xor128(a + 48, b + 48)));
+}
+
+__CCMS__INLINE
+int _box__is_zero128(const __m128i x) {
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_setzero_si128())) == 0xFFFF;
+}
+#endif
+
+// Index of the first byte in which `a` and `b` differ, `n` if they are equal
+__CCMS__INLINE
+size_t _box__mismatch(const uint8_t* a, const uint8_t* b, const size_t n) {
+  size_t i = 0;
+
+#if defined(__CCMS__HAS_AVX2)
+  // Skips equal 128 byte blocks with a single branch each, the loops below
+  // then locate the difference
+  for (; i + 128 <= n; i += 128) {
+    const __m256i diff = _box__xor256x4(a + i, b + i);
+    if (!_mm256_testz_si256(diff, diff)) break;
+  }
+  for (; i + 32 <= n; i += 32) {
+    const uint32_t mask = _M_cast(
+        uint32_t, _mm256_movemask_epi8(_mm256_cmpeq_epi8(
+                      _mm256_loadu_si256(_M_cast(const __m256i*, a + i)),
+                      _mm256_loadu_si256(_M_cast(const __m256i*, b + i)))));
+    if (mask != 0xFFFFFFFFu) return i + _box__ctz64(~mask);
+  }
+#elif defined(__CCMS__HAS_SSE2)
+  for (; i + 64 <= n; i += 64)
+    if (!_box__is_zero128(_box__xor128x4(a + i, b + i))) break;
+#endif
+#if defined(__CCMS__HAS_SSE2)
+  for (; i + 16 <= n; i += 16) {
+    const uint32_t mask = _M_cast(
+        uint32_t,
+        _mm_movemask_epi8(_mm_cmpeq_epi8(
+            _mm_loadu_si128(_M_cast(const __m128i*, a + i)),
+            _mm_loadu_si128(_M_cast(const __m128i*, b + i)))));
+    if (mask != 0xFFFFu) return i + _box__ctz64(~mask);
+  }
+#endif
+  for (; i + 8 <= n; i += 8) {
+    const uint64_t diff = _box__read64(a + i) ^ _box__read64(b + i);
+    if (diff != 0) return i + _box__ctz64(diff) / 8;
+  }
+  for (; i < n; i++)
+    if (a[i] != b[i]) return i;
+
+  return n;
+}
+
+// 1 if the first `n` bytes of `a` and `b` are equal. Cheaper than
+// _box__mismatch as the difference does not have to be located: short inputs
+// are covered by two overlapping loads, longer ones are xor-ed block by block.
+__CCMS__INLINE
+int _box__equal(const uint8_t* a, const uint8_t* b, const size_t n) {
+  if (n < 4)
+    return n == 0 || (a[0] == b[0] && a[n >> 1] == b[n >> 1] &&
+                      a[n - 1] == b[n - 1]);
+  if (n < 8)
+    return ((_box__read32(a) ^ _box__read32(b)) |
+            (_box__read32(a + n - 4) ^ _box__read32(b + n - 4))) == 0;
+  if (n <= 16)
+    return ((_box__read64(a) ^ _box__read64(b)) |
+            (_box__read64(a + n - 8) ^ _box__read64(b + n - 8))) == 0;
+
+  size_t i = 0;
+
+#if defined(__CCMS__HAS_AVX2)
+  for (; i + 128 <= n; i += 128) {
+    const __m256i diff = _box__xor256x4(a + i, b + i);
+    if (!_mm256_testz_si256(diff, diff)) return 0;
+  }
+#endif
+#if defined(__CCMS__HAS_SSE2)
+  for (; i + 64 <= n; i += 64)
+    if (!_box__is_zero128(_box__xor128x4(a + i, b + i))) return 0;
+
+  // The rest in 16 byte steps, the last load ends at `n`
+  __m128i diff = _box__xor128(a + n - 16, b + n - 16);
+  for (; i + 16 < n; i += 16)
+    diff = _mm_or_si128(diff, _box__xor128(a + i, b + i));
+  return _box__is_zero128(diff);
+#else
+  for (; i + 32 <= n; i += 32)
+    if (((_box__read64(a + i) ^ _box__read64(b + i)) |
+         (_box__read64(a + i + 8) ^ _box__read64(b + i + 8)) |
+         (_box__read64(a + i + 16) ^ _box__read64(b + i + 16)) |
+         (_box__read64(a + i + 24) ^ _box__read64(b + i + 24))) != 0)
+      return 0;
+
+  uint64_t diff = _box__read64(a + n - 8) ^ _box__read64(b + n - 8);
+  for (; i + 8 < n; i += 8)
+    diff |= _box__read64(a + i) ^ _box__read64(b + i);
+  return diff == 0;
+#endif
+}
+
+/**
+ * @brief Checks whether two boxes hold the same bytes.
+ *
+ * @return 1 if `a` and `b` have the same size and contents, 0 otherwise.
+ */
+__CCMS__INLINE
+int box__eq(const box_t a, const box_t b) {
+  return a.size == b.size &&
+         (a.ptr == b.ptr || _box__equal(a.ptr, b.ptr, a.size));
+}
+
+/**
+ * @brief Compares two boxes lexicographically by their bytes (as unsigned
+ * values), a box that is a prefix of the other one orders first.
+ *
+ * @return A negative value if `a` orders before `b`, 0 if they are equal and
+ * a positive value if `a` orders after `b`.
+ */
+__CCMS__INLINE
+int box__cmp(const box_t a, const box_t b) {
+  const size_t n = a.size < b.size ? a.size : b.size;
+  const size_t i = a.ptr == b.ptr ? n : _box__mismatch(a.ptr, b.ptr, n);
+
+  if (i < n) return _M_cast(int, a.ptr[i]) - _M_cast(int, b.ptr[i]);
+  return (a.size > b.size) - (a.size < b.size);
+}
+
+/**
+ * @brief Checks whether `self` starts with the bytes of `prefix`.
+ *
+ * @return 1 if `prefix` is a prefix of `self` (or empty), 0 otherwise.
+ */
+__CCMS__INLINE
+int box__starts_with(const box_t self, const box_t prefix) {
+  return self.size >= prefix.size &&
+         _box__equal(self.ptr, prefix.ptr, prefix.size);
+}
+
+//
+//
+// ------------------ hashing ------------------
+//
+//
+
+// Inputs of up to _BOX_HASH_SHORT bytes are hashed like wyhash, longer ones
+// like XXH3: 64 byte stripes are accumulated into 8 lanes (with SSE2/AVX2
+// where available) and the lanes are scrambled after every block of
+// _BOX_HASH_BLOCK stripes. Both paths give the same hashes on every platform.
+
+#define _BOX_HASH_SHORT 256
+#define _BOX_HASH_STRIPE 64
+#define _BOX_HASH_BLOCK 16
+
+#define _BOX_HASH_P0 0xA0761D6478BD642Full
+#define _BOX_HASH_P1 0xE7037ED1A0B428DBull
+#define _BOX_HASH_P2 0x8EBC6AF09C88C6E3ull
+#define _BOX_HASH_P3 0x589965CC75374CC3ull
+#define _BOX_HASH_P32 0x9E3779B1u
+
+// Stripe s of a block is mixed with the words s to s + 7, the scramble after
+// a block uses the words 16 to 23
+static const uint64_t _box__hash_key[_BOX_HASH_BLOCK + 8] = {
+    0x2CB0F69F4ABEA221ull, 0x9417034723148989ull, 0xDD555950609DFE03ull,
+    0xDBAFB150DEB12800ull, 0x7E789B2E6C442CB6ull, 0xF41E5636C7E4F8C4ull,
+    0x0959D150F8FBA7E4ull, 0xA97316F13CDB9EEAull, 0x74CD8258F9520068ull,
+    0x55C74A62E116868Bull, 0xD2F4C799A2023CBDull, 0xDF98CB79A37B51B9ull,
+    0x396F5885524F3905ull, 0xAF1D56386CA3B276ull, 0xA9FFBE6B5104E85Aull,
+    0x6BD0C51B9FD533B3ull, 0x980CE91C50AB4B56ull, 0x28AC395780FE62C5ull,
+    0x768912E3A6BCEDC7ull, 0x50B3E8C9332C7C88ull, 0xCE3BBFE520BD47DAull,
+    0xCBA6C8E8E0BB7C4Full, 0xBF194DB8434A346Dull, 0x7D8F2A7B60416D7Full,
+};
+
+// Replaces `a` and `b` with the low and high half of their 128 bit product
+__CCMS__INLINE
+void _box__mum(uint64_t* a, uint64_t* b) {
+#if defined(__SIZEOF_INT128__)
+  const __uint128_t r = _M_cast(__uint128_t, *a) * *b;
+  *a = _M_cast(uint64_t, r);
+  *b = _M_cast(uint64_t, r >> 64);
+#else
+  const uint64_t ha = *a >> 32, hb = *b >> 32;
+  const uint64_t la = *a & 0xFFFFFFFFull, lb = *b & 0xFFFFFFFFull;
+  const uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  const uint64_t t = rl + (rm0 << 32);
+  *a = t + (rm1 << 32);
+  *b = rh + (rm0 >> 32) + (rm1 >> 32) + (t < rl) + (*a < t);
+#endif
+}
+
+// Folds the 128 bit product of `a` and `b` into 64 bits
+__CCMS__INLINE
+uint64_t _box__mix(uint64_t a, uint64_t b) {
+  _box__mum(&a, &b);
+  return a ^ b;
+}
+
+__CCMS__INLINE
+uint64_t _box__hash_short(const uint8_t* ptr,
+                          const size_t size,
+                          uint64_t seed) {
+  uint64_t a, b;
+
+  seed ^= _box__mix(seed ^ _BOX_HASH_P0, _BOX_HASH_P1);
+  if (size <= 16) {
+    if (size >= 4) {
+      const size_t mid = (size >> 3) << 2;
+      a = (_box__read32(ptr) << 32) | _box__read32(ptr + mid);
+      b = (_box__read32(ptr + size - 4) << 32) |
+          _box__read32(ptr + size - 4 - mid);
+    } else if (size > 0) {
+      a = (_M_cast(uint64_t, ptr[0]) << 16) |
+          (_M_cast(uint64_t, ptr[size >> 1]) << 8) | ptr[size - 1];
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    size_t i = size;
+
+    if (i > 48) {
+      uint64_t see1 = seed, see2 = seed;
+      do {
+        seed = _box__mix(_box__read64(ptr) ^ _BOX_HASH_P1,
+                         _box__read64(ptr + 8) ^ seed);
+        see1 = _box__mix(_box__read64(ptr + 16) ^ _BOX_HASH_P2,
+                         _box__read64(ptr + 24) ^ see1);
+        see2 = _box__mix(_box__read64(ptr + 32) ^ _BOX_HASH_P3,
+                         _box__read64(ptr + 40) ^ see2);
+        ptr += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= see1 ^ see2;
+    }
+    for (; i > 16; ptr += 16, i -= 16)
+      seed = _box__mix(_box__read64(ptr) ^ _BOX_HASH_P1,
+                       _box__read64(ptr + 8) ^ seed);
+
+    // The last 16 bytes, overlapping with the ones already mixed in
+    a = _box__read64(ptr + i - 16);
+    b = _box__read64(ptr + i - 8);
+  }
+
+  a ^= _BOX_HASH_P1;
+  b ^= seed;
+  _box__mum(&a, &b);
+  return _box__mix(a ^ _BOX_HASH_P0 ^ size, b ^ _BOX_HASH_P1);
+}
+
+// acc[i ^ 1] += word i, acc[i] += low * high half of (word i ^ key i)
+__CCMS__INLINE
+void _box__hash_stripe(uint64_t* acc, const uint8_t* ptr, const uint64_t* key) {
+#if defined(__CCMS__HAS_AVX2)
+  for (size_t i = 0; i < 8; i += 4) {
+    __m256i* lane = _M_cast(__m256i*, acc + i);
+    const __m256i data =
+        _mm256_loadu_si256(_M_cast(const __m256i*, ptr + i * 8));
+    const __m256i mixed = _mm256_xor_si256(
+        data, _mm256_loadu_si256(_M_cast(const __m256i*, key + i)));
+    const __m256i product =
+        _mm256_mul_epu32(mixed, _mm256_shuffle_epi32(mixed, 0x31));
+    const __m256i swapped = _mm256_shuffle_epi32(data, 0x4E);
+    _mm256_storeu_si256(
+        lane, _mm256_add_epi64(_mm256_loadu_si256(lane),
+                               _mm256_add_epi64(product, swapped)));
+  }
+#elif defined(__CCMS__HAS_SSE2)
+  for (size_t i = 0; i < 8; i += 2) {
+    __m128i* lane = _M_cast(__m128i*, acc + i);
+    const __m128i data = _mm_loadu_si128(_M_cast(const __m128i*, ptr + i * 8));
+    const __m128i mixed = _mm_xor_si128(
+        data, _mm_loadu_si128(_M_cast(const __m128i*, key + i)));
+    const __m128i product =
+        _mm_mul_epu32(mixed, _mm_shuffle_epi32(mixed, 0x31));
+    const __m128i swapped = _mm_shuffle_epi32(data, 0x4E);
+    _mm_storeu_si128(lane, _mm_add_epi64(_mm_loadu_si128(lane),
+                                         _mm_add_epi64(product, swapped)));
+  }
+#else
+  for (size_t i = 0; i < 8; i++) {
+    const uint64_t data = _box__read64(ptr + i * 8);
+    const uint64_t mixed = data ^ key[i];
+    acc[i ^ 1] += data;
+    acc[i] += (mixed & 0xFFFFFFFFull) * (mixed >> 32);
+  }
+#endif
+}
+
+// acc[i] = (acc[i] ^ (acc[i] >> 47) ^ key i) * _BOX_HASH_P32
+__CCMS__INLINE
+void _box__hash_scramble(uint64_t* acc, const uint64_t* key) {
+#if defined(__CCMS__HAS_AVX2)
+  const __m256i prime = _mm256_set1_epi32(_M_cast(int, _BOX_HASH_P32));
+  for (size_t i = 0; i < 8; i += 4) {
+    __m256i* lane = _M_cast(__m256i*, acc + i);
+    __m256i x = _mm256_loadu_si256(lane);
+    x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 47));
+    x = _mm256_xor_si256(
+        x, _mm256_loadu_si256(_M_cast(const __m256i*, key + i)));
+    const __m256i lo = _mm256_mul_epu32(x, prime);
+    const __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), prime);
+    _mm256_storeu_si256(lane,
+                        _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32)));
+  }
+#elif defined(__CCMS__HAS_SSE2)
+  const __m128i prime = _mm_set1_epi32(_M_cast(int, _BOX_HASH_P32));
+  for (size_t i = 0; i < 8; i += 2) {
+    __m128i* lane = _M_cast(__m128i*, acc + i);
+    __m128i x = _mm_loadu_si128(lane);
+    x = _mm_xor_si128(x, _mm_srli_epi64(x, 47));
+    x = _mm_xor_si128(x, _mm_loadu_si128(_M_cast(const __m128i*, key + i)));
+    const __m128i lo = _mm_mul_epu32(x, prime);
+    const __m128i hi = _mm_mul_epu32(_mm_srli_epi64(x, 32), prime);
+    _mm_storeu_si128(lane, _mm_add_epi64(lo, _mm_slli_epi64(hi, 32)));
+  }
+#else
+  for (size_t i = 0; i < 8; i++) {
+    acc[i] ^= (acc[i] >> 47) ^ key[i];
+    acc[i] *= _BOX_HASH_P32;
+  }
+#endif
+}
+
+__CCMS__INLINE
+uint64_t _box__hash_long(const uint8_t* ptr,
+                         const size_t size,
+                         const uint64_t seed) {
+  const uint64_t* key = _box__hash_key;
+  const size_t block_size = _BOX_HASH_STRIPE * _BOX_HASH_BLOCK;
+  const size_t nblocks = (size - 1) / block_size;
+  const size_t nstripes = ((size - 1) % block_size) / _BOX_HASH_STRIPE;
+  uint64_t acc[8] = {_BOX_HASH_P32 ^ seed, _BOX_HASH_P0 ^ seed,
+                     _BOX_HASH_P1 ^ seed,  _BOX_HASH_P2 ^ seed,
+                     _BOX_HASH_P3 ^ seed,  _BOX_HASH_P32 ^ ~seed,
+                     _BOX_HASH_P0 ^ ~seed, _BOX_HASH_P1 ^ ~seed};
+
+  for (size_t n = 0; n < nblocks; n++, ptr += block_size) {
+    for (size_t s = 0; s < _BOX_HASH_BLOCK; s++)
+      _box__hash_stripe(acc, ptr + s * _BOX_HASH_STRIPE, key + s);
+    _box__hash_scramble(acc, key + _BOX_HASH_BLOCK);
+  }
+  for (size_t s = 0; s < nstripes; s++)
+    _box__hash_stripe(acc, ptr + s * _BOX_HASH_STRIPE, key + s);
+
+  // The last stripe ends at the end of the input, it may overlap with the
+  // stripes before it
+  _box__hash_stripe(acc, ptr + (size - 1) % block_size + 1 - _BOX_HASH_STRIPE,
+                    key + 9);
+
+  uint64_t hash = size * _BOX_HASH_P0 ^ seed;
+  for (size_t i = 0; i < 8; i += 2)
+    hash += _box__mix(acc[i] ^ key[11 + i], acc[i + 1] ^ key[12 + i]);
+
+  hash ^= hash >> 37;
+  hash *= 0x165667919E3779F9ull;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+/**
+ * @brief Hashes the bytes of a box with `seed`.
+ *
+ * A fast non-cryptographic 64 bit hash, the same on every platform and with
+ * or without SIMD. Use a random seed for keys that may be chosen by an
+ * attacker.
+ */
+__CCMS__INLINE
+uint64_t box__hash_seeded(const box_t self, const uint64_t seed) {
+  if (self.size <= _BOX_HASH_SHORT)
+    return _box__hash_short(self.ptr, self.size, seed);
+  return _box__hash_long(self.ptr, self.size, seed);
+}
+
+/**
+ * @brief Hashes the bytes of a box, same as box__hash_seeded(self, 0).
+ */
+__CCMS__INLINE
+uint64_t box__hash(const box_t self) {
+  return box__hash_seeded(self, 0);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,454 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+#ifndef __CCMS__BOX_MAP__H
+#define __CCMS__BOX_MAP__H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef __CCMS__SUPPRESS_WARNINGS
+#include <stdio.h>
+#endif
+
+#include "ccms/_defs.h"
+#include "ccms/_macros.h"
+#include "ccms/allocator.h"
+#include "ccms/box.h"
+
+#if defined(__CCMS__HAS_AVX2)
+#include <immintrin.h>
+#elif defined(__CCMS__HAS_SSE2)
+#include <emmintrin.h>
+#endif
+
+// An open addressing hash map from byte strings (box_t) to uint64_t values,
+// laid out like a Swiss table: next to the array of slots there is one control
+// byte per slot, holding 7 bits of the hash of its key (or marking the slot as
+// empty or deleted). Lookups probe a whole group of control bytes at once,
+// with SSE2/AVX2 where available, and only compare keys whose bits match.
+//
+// All memory of the map (its header, the arrays and copies of the keys) comes
+// from an allocator_t, so a map on an arena is dropped together with the
+// arena. Keys are copied into the arena, or into a pg_arena_t owned by the map
+// for _M_alloc/heap_t, so that no entry needs an allocation of its own.
+
+#if defined(__CCMS__HAS_AVX2)
+#define _BOX_MAP_GROUP 32
+#elif defined(__CCMS__HAS_SSE2)
+#define _BOX_MAP_GROUP 16
+#else
+#define _BOX_MAP_GROUP 8
+#endif
+
+#define _BOX_MAP_EMPTY 0x80
+#define _BOX_MAP_DELETED 0xFE
+
+// Page size of the arena holding key copies for _M_alloc/heap_t maps
+#ifndef __CCMS__BOX_MAP_KEY_PAGE_SIZE
+#define __CCMS__BOX_MAP_KEY_PAGE_SIZE 65536
+#endif
+
+/**
+ * @typedef box_map_t
+ * @brief Typedef for struct box_map_t
+ */
+typedef struct box_map_t box_map_t;
+
+typedef struct _box_map_slot_t _box_map_slot_t;
+
+struct _box_map_slot_t {
+  box_t key;
+  uint64_t value;
+};
+
+/**
+ * @struct box_map_t
+ * @brief A hash map from box_t keys to uint64_t values.
+ *
+ * @var box_map_t::len
+ * The number of entries in the map.
+ */
+struct box_map_t {
+  uint8_t* ctrl;
+  _box_map_slot_t* slots;
+  // Number of slots, a power of two and a multiple of _BOX_MAP_GROUP (or 0)
+  size_t cap;
+  size_t len;
+  // Inserts left until the map has to grow, deleted slots count as used
+  size_t growth_left;
+  allocator_t alloc;
+  // Holds the key copies, NULL if they come from `alloc`
+  pg_arena_t* keys;
+};
+
+__CCMS__INLINE
+uint32_t _box_map__ctz(const uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+  return _M_cast(uint32_t, __builtin_ctz(mask));
+#else
+  uint32_t n = 0;
+  while (!(mask & (_M_cast(uint32_t, 1) << n)))
+    n++;
+  return n;
+#endif
+}
+
+// Bit i of the result is set if control byte i of the group at `ctrl` equals
+// `byte`
+__CCMS__INLINE
+uint32_t _box_map__match(const uint8_t* ctrl, const uint8_t byte) {
+#if defined(__CCMS__HAS_AVX2)
+  const __m256i group = _mm256_loadu_si256(_M_cast(const __m256i*, ctrl));
+  return _M_cast(uint32_t,
+                 _mm256_movemask_epi8(_mm256_cmpeq_epi8(
+                     group, _mm256_set1_epi8(_M_cast(char, byte)))));
+#elif defined(__CCMS__HAS_SSE2)
+  const __m128i group = _mm_loadu_si128(_M_cast(const __m128i*, ctrl));
+  return _M_cast(uint32_t, _mm_movemask_epi8(_mm_cmpeq_epi8(
+                               group, _mm_set1_epi8(_M_cast(char, byte)))));
+#else
+  uint32_t mask = 0;
+  for (uint32_t i = 0; i < _BOX_MAP_GROUP; i++)
+    mask |= _M_cast(uint32_t, ctrl[i] == byte) << i;
+  return mask;
+#endif
+}
+
+// Bit i of the result is set if slot i of the group at `ctrl` is empty or
+// deleted, which are the only control bytes with the highest bit set
+__CCMS__INLINE
+uint32_t _box_map__match_free(const uint8_t* ctrl) {
+#if defined(__CCMS__HAS_AVX2)
+  return _M_cast(uint32_t, _mm256_movemask_epi8(_mm256_loadu_si256(
+                               _M_cast(const __m256i*, ctrl))));
+#elif defined(__CCMS__HAS_SSE2)
+  return _M_cast(uint32_t,
+                 _mm_movemask_epi8(_mm_loadu_si128(
+                     _M_cast(const __m128i*, ctrl))));
+#else
+  uint32_t mask = 0;
+  for (uint32_t i = 0; i < _BOX_MAP_GROUP; i++)
+    mask |= _M_cast(uint32_t, ctrl[i] >> 7) << i;
+  return mask;
+#endif
+}
+
+/**
+ * @brief Creates an empty map that takes all its memory from `alloc`.
+ *
+ * @return The new map, or NULL if `alloc` fails.
+ */
+__CCMS__INLINE
+box_map_t* box_map__new(allocator_t alloc) {
+  box_map_t* self = _M_cast(
+      box_map_t*,
+      allocator__alloc(&alloc, sizeof(box_map_t), _M_alignof(box_map_t)));
+  if (self == NULL) return NULL;
+
+  self->ctrl = NULL;
+  self->slots = NULL;
+  self->cap = self->len = self->growth_left = 0;
+  self->alloc = alloc;
+  self->keys = alloc.kind == ALLOCATOR_MALLOC || alloc.kind == ALLOCATOR_HEAP
+                   ? pg_arena__new(__CCMS__BOX_MAP_KEY_PAGE_SIZE)
+                   : NULL;
+
+  return self;
+}
+
+/**
+ * @brief Frees the map with all of its key copies.
+ *
+ * For a map on an arena, this only gives back what the arena can take back,
+ * resetting the arena frees the map as well.
+ */
+__CCMS__INLINE
+void box_map__free(box_map_t* self) {
+  allocator_t alloc = self->alloc;
+
+  if (self->keys != NULL) pg_arena__free(self->keys);
+  allocator__dealloc(&alloc, _M_cast(uint8_t*, self->slots),
+                     self->cap * sizeof(_box_map_slot_t));
+  allocator__dealloc(&alloc, self->ctrl, self->cap);
+  allocator__dealloc(&alloc, _M_cast(uint8_t*, self), sizeof(box_map_t));
+}
+
+/**
+ * @brief Removes all entries, keeping the capacity of the map.
+ */
+__CCMS__INLINE
+void box_map__clear(box_map_t* self) {
+  if (self->cap > 0) memset(self->ctrl, _BOX_MAP_EMPTY, self->cap);
+  self->len = 0;
+  self->growth_left = self->cap - self->cap / 8;
+  if (self->keys != NULL) pg_arena__reset(self->keys);
+}
+
+// First free slot on the probe sequence of `hash`
+__CCMS__INLINE
+size_t _box_map__find_free(const box_map_t* self, const uint64_t hash) {
+  const size_t mask = self->cap - 1;
+  size_t pos = (hash >> 7) & mask & ~_M_cast(size_t, _BOX_MAP_GROUP - 1);
+
+  // Visits every group once, as the number of groups is a power of two
+  for (size_t step = _BOX_MAP_GROUP;; step += _BOX_MAP_GROUP) {
+    const uint32_t free = _box_map__match_free(self->ctrl + pos);
+    if (free != 0) return pos + _box_map__ctz(free);
+    pos = (pos + step) & mask;
+  }
+}
+
+// Slot of `key`, or SIZE_MAX if the map does not contain it
+__CCMS__INLINE
+size_t _box_map__find(const box_map_t* self,
+                      const box_t key,
+                      const uint64_t hash) {
+  if (self->cap == 0) return SIZE_MAX;
+
+  const size_t mask = self->cap - 1;
+  const uint8_t h2 = _M_cast(uint8_t, hash & 0x7F);
+  size_t pos = (hash >> 7) & mask & ~_M_cast(size_t, _BOX_MAP_GROUP - 1);
+
+  for (size_t step = _BOX_MAP_GROUP;; step += _BOX_MAP_GROUP) {
+    for (uint32_t match = _box_map__match(self->ctrl + pos, h2); match != 0;
+         match &= match - 1) {
+      const size_t i = pos + _box_map__ctz(match);
+      const box_t other = self->slots[i].key;
+
+      if (box__eq(other, key)) return i;
+    }
+
+    // A probe sequence ends at the first group that has an empty slot
+    if (_box_map__match(self->ctrl + pos, _BOX_MAP_EMPTY) != 0)
+      return SIZE_MAX;
+    if (step >= self->cap) return SIZE_MAX;
+    pos = (pos + step) & mask;
+  }
+}
+
+// Moves all entries into new arrays of `cap` slots
+__CCMS__INLINE
+int _box_map__rehash(box_map_t* self, const size_t cap) {
+  uint8_t* ctrl = allocator__alloc(&self->alloc, cap, 1);
+  _box_map_slot_t* slots = _M_cast(
+      _box_map_slot_t*,
+      allocator__alloc(&self->alloc, cap * sizeof(_box_map_slot_t),
+                       _M_alignof(_box_map_slot_t)));
+
+  if (ctrl == NULL || slots == NULL) {
+    allocator__dealloc(&self->alloc, _M_cast(uint8_t*, slots),
+                       cap * sizeof(_box_map_slot_t));
+    allocator__dealloc(&self->alloc, ctrl, cap);
+#ifndef __CCMS__SUPPRESS_WARNINGS
+    fprintf(stderr,
+            "warning: failed to grow a map (box) to %ld slots, returned "
+            "NULL\n",
+            cap);
+#endif
+    return -1;
+  }
+
+  uint8_t* old_ctrl = self->ctrl;
+  _box_map_slot_t* old_slots = self->slots;
+  const size_t old_cap = self->cap;
+
+  memset(ctrl, _BOX_MAP_EMPTY, cap);
+  self->ctrl = ctrl;
+  self->slots = slots;
+  self->cap = cap;
+  self->growth_left = cap - cap / 8 - self->len;
+
+  for (size_t i = 0; i < old_cap; i++) {
+    if (old_ctrl[i] & 0x80) continue;
+
+    const box_t key = old_slots[i].key;
+    const uint64_t hash = box__hash(key);
+    const size_t j = _box_map__find_free(self, hash);
+
+    ctrl[j] = _M_cast(uint8_t, hash & 0x7F);
+    slots[j] = old_slots[i];
+  }
+
+  allocator__dealloc(&self->alloc, _M_cast(uint8_t*, old_slots),
+                     old_cap * sizeof(_box_map_slot_t));
+  allocator__dealloc(&self->alloc, old_ctrl, old_cap);
+
+  return 0;
+}
+
+/**
+ * @brief Makes room for at least `len` entries without growing again.
+ *
+ * @return 0 on success, -1 if the allocator fails.
+ */
+__CCMS__INLINE
+int box_map__reserve(box_map_t* self, const size_t len) {
+  size_t cap = _BOX_MAP_GROUP;
+
+  while (cap - cap / 8 < len)
+    cap *= 2;
+  if (cap <= self->cap) return 0;
+
+  return _box_map__rehash(self, cap);
+}
+
+/**
+ * @brief Returns a pointer to the value of `key`, or NULL if there is none.
+ */
+__CCMS__INLINE
+uint64_t* box_map__get(const box_map_t* self, const box_t key) {
+  const size_t i = _box_map__find(self, key, box__hash(key));
+
+  return i == SIZE_MAX ? NULL : &self->slots[i].value;
+}
+
+/**
+ * @brief Returns a pointer to the value of `key`, inserting `key` with the
+ * value 0 if the map does not contain it yet.
+ *
+ * The key is copied into the map. `inserted` (if not NULL) is set to whether
+ * the key was inserted. The pointer stays valid until the map grows.
+ *
+ * @return A pointer to the value, or NULL if the allocator fails.
+ */
+__CCMS__INLINE
+uint64_t* box_map__entry(box_map_t* self, const box_t key, int* inserted) {
+  const uint64_t hash = box__hash(key);
+  size_t i = _box_map__find(self, key, hash);
+
+  if (inserted != NULL) *inserted = i == SIZE_MAX;
+  if (i != SIZE_MAX) return &self->slots[i].value;
+
+  // Grows unless there are enough deleted slots to reclaim by rehashing
+  if (self->growth_left == 0 &&
+      _box_map__rehash(self, self->len * 2 < self->cap - self->cap / 8
+                                 ? self->cap
+                                 : (self->cap ? self->cap * 2
+                                              : _BOX_MAP_GROUP)) != 0)
+    return NULL;
+
+  box_t copy = box__ctor(NULL, key.size);
+  if (key.size > 0) {
+    copy.ptr = self->keys != NULL
+                   ? pg_arena__alloc(self->keys, key.size)
+                   : allocator__alloc(&self->alloc, key.size, 1);
+    if (copy.ptr == NULL) return NULL;
+    memcpy(copy.ptr, key.ptr, key.size);
+  }
+
+  i = _box_map__find_free(self, hash);
+  if (self->ctrl[i] == _BOX_MAP_EMPTY) self->growth_left--;
+  self->ctrl[i] = _M_cast(uint8_t, hash & 0x7F);
+  self->slots[i].key = copy;
+  self->slots[i].value = 0;
+  self->len++;
+
+  return &self->slots[i].value;
+}
+
+/**
+ * @brief Returns the copy of the key that the value at `value` (as returned by
+ * box_map__get or box_map__entry) belongs to.
+ *
+ * The copy lives as long as the map (or its arena) and does not move when the
+ * map grows.
+ */
+__CCMS__INLINE
+box_t box_map__key_of(const uint64_t* value) {
+  return _M_cast(const _box_map_slot_t*,
+                 _M_cast(const void*,
+                         _M_cast(const uint8_t*, value) -
+                             offsetof(_box_map_slot_t, value)))
+      ->key;
+}
+
+/**
+ * @brief Sets the value of `key`, inserting it if needed.
+ *
+ * @return A pointer to the value, or NULL if the allocator fails.
+ */
+__CCMS__INLINE
+uint64_t* box_map__insert(box_map_t* self,
+                          const box_t key,
+                          const uint64_t value) {
+  uint64_t* slot = box_map__entry(self, key, NULL);
+
+  if (slot != NULL) *slot = value;
+  return slot;
+}
+
+/**
+ * @brief Removes `key` from the map. The copy of the key is only freed
+ * together with the map.
+ *
+ * @return 1 if the key was removed, 0 if the map does not contain it.
+ */
+__CCMS__INLINE
+int box_map__remove(box_map_t* self, const box_t key) {
+  const size_t i = _box_map__find(self, key, box__hash(key));
+  if (i == SIZE_MAX) return 0;
+
+  // If the group still has an empty slot, every probe sequence through it ends
+  // here anyway and the slot can become empty again
+  if (_box_map__match(self->ctrl + (i & ~_M_cast(size_t, _BOX_MAP_GROUP - 1)),
+                      _BOX_MAP_EMPTY) != 0) {
+    self->ctrl[i] = _BOX_MAP_EMPTY;
+    self->growth_left++;
+  } else {
+    self->ctrl[i] = _BOX_MAP_DELETED;
+  }
+  self->len--;
+
+  return 1;
+}
+
+/**
+ * @brief Iterates over the entries of the map in no particular order.
+ *
+ * Start with `*itr` set to 0. Every call stores the next entry in `key` and
+ * `value` and returns 1, or returns 0 once all entries were visited.
+ */
+__CCMS__INLINE
+int box_map__next(const box_map_t* self,
+                  size_t* itr,
+                  box_t* key,
+                  uint64_t** value) {
+  for (; *itr < self->cap; (*itr)++) {
+    if (self->ctrl[*itr] & 0x80) continue;
+
+    *key = self->slots[*itr].key;
+    *value = &self->slots[*itr].value;
+    (*itr)++;
+    return 1;
+  }
+
+  return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __CCMS__BOX_MAP__H
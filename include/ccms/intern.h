@@ -0,0 +1,163 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+#ifndef __CCMS__INTERN__H
+#define __CCMS__INTERN__H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ccms/_defs.h"
+#include "ccms/_macros.h"
+#include "ccms/allocator.h"
+#include "ccms/box.h"
+#include "ccms/box_map.h"
+#include "ccms/vec.h"
+
+/**
+ * @brief The id returned for strings that are not (or could not be) interned.
+ */
+#define INTERN_NONE UINT32_MAX
+
+vec__define(_intern_vec, box_t)
+
+/**
+ * @typedef intern_t
+ * @brief Typedef for struct intern_t
+ */
+typedef struct intern_t intern_t;
+
+/**
+ * @struct intern_t
+ * @brief A pool of unique byte strings.
+ *
+ * Every distinct string is stored once, in the pg_arena_t that holds the keys
+ * of a box_map_t, and gets a small integer id in the order strings were first
+ * seen. Interned strings never move, so two interned boxes are equal exactly
+ * if their pointers are, and two ids exactly if the numbers are.
+ *
+ * @var intern_t::map
+ * Maps every interned string to its id.
+ *
+ * @var intern_t::strs
+ * The interned strings, indexed by id.
+ */
+struct intern_t {
+  box_map_t* map;
+  _intern_vec_t strs;
+};
+
+/**
+ * @brief Creates an empty intern pool.
+ */
+__CCMS__INLINE
+intern_t* intern__new(void) {
+  intern_t* self = _M_new(intern_t);
+
+  self->map = box_map__new(allocator__malloc());
+  self->strs = _intern_vec__ctor(allocator__malloc());
+
+  return self;
+}
+
+/**
+ * @brief Frees the pool together with all interned strings.
+ */
+__CCMS__INLINE
+void intern__free(intern_t* self) {
+  box_map__free(self->map);
+  _intern_vec__free(&self->strs);
+  _M_free(self);
+}
+
+/**
+ * @brief Returns the number of interned strings.
+ */
+__CCMS__INLINE
+size_t intern__len(const intern_t* self) {
+  return self->strs.len;
+}
+
+/**
+ * @brief Returns the id of `str`, interning it first if needed.
+ *
+ * @return The id, or INTERN_NONE if the allocator fails.
+ */
+__CCMS__INLINE
+uint32_t intern__id(intern_t* self, const box_t str) {
+  int inserted;
+  uint64_t* id = box_map__entry(self->map, str, &inserted);
+
+  if (id == NULL) return INTERN_NONE;
+  if (!inserted) return _M_cast(uint32_t, *id);
+
+  if (self->strs.len >= INTERN_NONE ||
+      _intern_vec__push(&self->strs, box_map__key_of(id)) == NULL) {
+    box_map__remove(self->map, str);
+    return INTERN_NONE;
+  }
+
+  *id = self->strs.len - 1;
+  return _M_cast(uint32_t, *id);
+}
+
+/**
+ * @brief Returns the id of `str` without interning it.
+ *
+ * @return The id, or INTERN_NONE if `str` is not interned.
+ */
+__CCMS__INLINE
+uint32_t intern__find(const intern_t* self, const box_t str) {
+  const uint64_t* id = box_map__get(self->map, str);
+
+  return id == NULL ? INTERN_NONE : _M_cast(uint32_t, *id);
+}
+
+/**
+ * @brief Returns the interned string with the given id.
+ *
+ * `id` has to be an id returned by this pool.
+ */
+__CCMS__INLINE
+box_t intern__get(const intern_t* self, const uint32_t id) {
+  return self->strs.data[id];
+}
+
+/**
+ * @brief Interns `str` and returns the interned copy.
+ *
+ * @return The interned string, or a box with a NULL pointer and size 0 if the
+ * allocator fails.
+ */
+__CCMS__INLINE
+box_t intern__box(intern_t* self, const box_t str) {
+  const uint32_t id = intern__id(self, str);
+
+  return id == INTERN_NONE ? box__ctor(NULL, 0) : intern__get(self, id);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __CCMS__INTERN__H
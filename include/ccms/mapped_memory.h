@@ -0,0 +1,168 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+#ifndef __CCMS__MAPPED_MEM__H
+#define __CCMS__MAPPED_MEM__H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef __CCMS__SUPPRESS_WARNINGS
+#include <stdio.h>
+#endif
+
+#include "ccms/_defs.h"
+#include "ccms/_macros.h"
+#include "ccms/_os.h"
+#include "ccms/box.h"
+
+#ifndef __CCMS__HAS_VMEM
+#error "ccms/mapped_memory.h requires mmap or VirtualAlloc"
+#endif
+
+/**
+ * @brief How a file is mapped by mapped_mem__new.
+ */
+typedef enum mapped_mem_mode_t {
+  // Read-only, the pages are shared with the page cache and with every other
+  // process that maps the file
+  MAPPED_MEM_READ,
+  // Readable and writable, written pages are copied on first write and the
+  // file itself is never changed
+  MAPPED_MEM_PRIVATE,
+} mapped_mem_mode_t;
+
+/**
+ * @brief Access pattern hints for mapped_mem__advise.
+ */
+typedef enum mapped_mem_advice_t {
+  MAPPED_MEM_NORMAL = _OS_ADVICE_NORMAL,
+  // Read ahead aggressively, pages behind the reader can be dropped early
+  MAPPED_MEM_SEQUENTIAL = _OS_ADVICE_SEQUENTIAL,
+  // Do not read ahead
+  MAPPED_MEM_RANDOM = _OS_ADVICE_RANDOM,
+  // Start reading the whole file in now
+  MAPPED_MEM_WILLNEED = _OS_ADVICE_WILLNEED,
+  // Back the mapping with transparent huge pages where the kernel supports it
+  // for files (Linux only)
+  MAPPED_MEM_HUGEPAGE = _OS_ADVICE_HUGEPAGE,
+} mapped_mem_advice_t;
+
+/**
+ * @typedef mapped_mem_t
+ * @brief Typedef for struct mapped_mem_t
+ */
+typedef struct mapped_mem_t mapped_mem_t;
+
+/**
+ * @struct mapped_mem_t
+ * @brief The contents of a file, mapped into memory.
+ *
+ * Unlike reading a file into a sized_mem_t, mapping it does not copy anything:
+ * pages are loaded from the page cache when they are first touched, and a
+ * read-only mapping of the same file is shared by all processes.
+ *
+ * @var mapped_mem_t::ptr
+ * The first byte of the file, NULL for an empty file.
+ *
+ * @var mapped_mem_t::size
+ * The size of the file in bytes.
+ */
+struct mapped_mem_t {
+  uint8_t* ptr;
+  size_t size;
+  mapped_mem_mode_t mode;
+};
+
+/**
+ * @brief Maps the file at `path` into memory.
+ *
+ * The mapping stays valid after the file is deleted (where the operating
+ * system allows deleting a mapped file). Changes made to the file by others
+ * are visible through a MAPPED_MEM_READ mapping, and the mapping must not be
+ * accessed beyond a point the file was truncated to.
+ *
+ * @param path The path of the file.
+ * @param mode MAPPED_MEM_READ or MAPPED_MEM_PRIVATE.
+ *
+ * @return A pointer to the new mapped_mem_t object, or NULL if the file could
+ * not be opened or mapped.
+ */
+__CCMS__INLINE
+mapped_mem_t* mapped_mem__new(const char* path, const mapped_mem_mode_t mode) {
+  uint8_t* ptr;
+  size_t size;
+
+  if (_os__map_file(path, mode == MAPPED_MEM_PRIVATE, &ptr, &size) != 0) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+    fprintf(stderr, "warning: could not map file '%s', returned NULL\n", path);
+#endif
+    return NULL;
+  }
+
+  mapped_mem_t* self = _M_new(mapped_mem_t);
+  self->ptr = ptr;
+  self->size = size;
+  self->mode = mode;
+
+  return self;
+}
+
+/**
+ * @brief Unmaps the file and frees the mapped_mem_t object.
+ *
+ * Boxes taken from the object must not be used afterwards. Changes to a
+ * MAPPED_MEM_PRIVATE mapping are lost.
+ */
+__CCMS__INLINE
+void mapped_mem__free(mapped_mem_t* self) {
+  _os__unmap_file(self->ptr, self->size);
+  _M_free(self);
+}
+
+/**
+ * @brief Returns a box_t object representing the mapped file.
+ */
+__CCMS__INLINE
+box_t mapped_mem__as_box(const mapped_mem_t* self) {
+  return box__ctor(self->ptr, self->size);
+}
+
+/**
+ * @brief Tells the operating system how the mapping is going to be used.
+ *
+ * Hints never change the contents of the mapping, so a failed hint can be
+ * ignored.
+ *
+ * @return 0 on success, -1 if the hint is not supported here.
+ */
+__CCMS__INLINE
+int mapped_mem__advise(mapped_mem_t* self, const mapped_mem_advice_t advice) {
+  return _os__advise(self->ptr, self->size, _M_cast(_os_advice_t, advice));
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __CCMS__MAPPED_MEM__H
@@ -0,0 +1,328 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+#ifndef __CCMS__MPMC_QUEUE__H
+#define __CCMS__MPMC_QUEUE__H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef __CCMS__SUPPRESS_WARNINGS
+#include <stdio.h>
+#endif
+
+#include "ccms/_defs.h"
+#include "ccms/_macros.h"
+#include "ccms/arena/static.h"
+
+#ifndef __CCMS__HAS_ATOMICS
+#error "ccms/mpmc_queue.h requires C11 atomics"
+#endif
+
+#include <stdatomic.h>
+
+typedef struct _mpmc_queue_cell_t _mpmc_queue_cell_t;
+
+// Cell i can be written by the enqueue at position p once seq == p, and read
+// by the dequeue at position p once seq == p + 1. Reading it sets seq to
+// p + capacity, the position of the next enqueue that maps to the same cell.
+struct _mpmc_queue_cell_t {
+  _Atomic size_t seq;
+  void* item;
+};
+
+/**
+ * @typedef mpmc_queue_t
+ * @brief Typedef for struct mpmc_queue_t
+ */
+typedef struct mpmc_queue_t mpmc_queue_t;
+
+/**
+ * @struct mpmc_queue_t
+ * @brief A bounded lock-free queue of pointers for any number of producers
+ * and consumers (after Dmitry Vyukov).
+ *
+ * Producers and consumers each claim a position with a single CAS on their own
+ * cache line and then only touch the cell at that position, whose sequence
+ * number tells whether it is free, filled or still in use by the other side.
+ * The cells live in a caller provided buffer (or a st_arena_t), so neither
+ * enqueue nor dequeue ever allocates.
+ */
+struct mpmc_queue_t {
+  _Atomic size_t enq;
+  uint8_t _pad0[64 - sizeof(size_t)];
+  _Atomic size_t deq;
+  uint8_t _pad1[64 - sizeof(size_t)];
+  _mpmc_queue_cell_t* cells;
+  size_t mask;
+};
+
+/**
+ * @brief Returns the size in bytes of the cell buffer for `cap` items, `cap`
+ * has to be a power of two.
+ */
+__CCMS__INLINE
+size_t mpmc_queue__buffer_size(const size_t cap) {
+  return cap * sizeof(_mpmc_queue_cell_t);
+}
+
+__CCMS__INLINE
+int _mpmc_queue__check_cap(const size_t cap) {
+  if (_M_is_pow2(cap) && cap >= 2) return 1;
+#ifndef __CCMS__SUPPRESS_WARNINGS
+  fprintf(stderr,
+          "warning: tried creating a queue (mpmc) with capacity %ld (not a "
+          "power of two >= 2), ignored\n",
+          cap);
+#endif
+  return 0;
+}
+
+/**
+ * @brief Initializes a queue for `cap` items (a power of two >= 2) in `buffer`.
+ *
+ * `buffer` has to hold mpmc_queue__buffer_size(cap) bytes aligned to at least
+ * pointer size, and has to outlive the queue.
+ *
+ * @return 0 on success, -1 if `cap` is not a power of two.
+ */
+__CCMS__INLINE
+int mpmc_queue__init(mpmc_queue_t* self, void* buffer, const size_t cap) {
+  if (!_mpmc_queue__check_cap(cap)) return -1;
+
+  self->cells = _M_cast(_mpmc_queue_cell_t*, buffer);
+  self->mask = cap - 1;
+  for (size_t i = 0; i < cap; i++) {
+    atomic_init(&self->cells[i].seq, i);
+    self->cells[i].item = NULL;
+  }
+  atomic_init(&self->enq, 0);
+  atomic_init(&self->deq, 0);
+
+  return 0;
+}
+
+/**
+ * @brief Allocates a queue for `cap` items (a power of two >= 2) together
+ * with its cells from `arena`.
+ *
+ * @return The queue, or NULL if `cap` is not a power of two or the arena is
+ * too small.
+ */
+__CCMS__INLINE
+mpmc_queue_t* mpmc_queue__new(st_arena_t* arena, const size_t cap) {
+  if (!_mpmc_queue__check_cap(cap)) return NULL;
+
+  const st_arena_mark_t mark = st_arena__mark(arena);
+  mpmc_queue_t* self = _M_cast(
+      mpmc_queue_t*, st_arena__alloc_aligned(arena, sizeof(mpmc_queue_t), 64));
+  uint8_t* cells =
+      self == NULL
+          ? NULL
+          : st_arena__alloc_aligned(arena, mpmc_queue__buffer_size(cap), 64);
+
+  if (cells == NULL) {
+    st_arena__rewind(arena, mark);
+    return NULL;
+  }
+
+  mpmc_queue__init(self, cells, cap);
+  return self;
+}
+
+/**
+ * @brief Returns the capacity of the queue.
+ */
+__CCMS__INLINE
+size_t mpmc_queue__cap(const mpmc_queue_t* self) {
+  return self->mask + 1;
+}
+
+/**
+ * @brief Appends `item` to the queue unless it is full.
+ *
+ * @return 1 if `item` was enqueued, 0 if the queue is full.
+ */
+__CCMS__INLINE
+int mpmc_queue__try_enqueue(mpmc_queue_t* self, void* item) {
+  size_t pos = atomic_load_explicit(&self->enq, memory_order_relaxed);
+  _mpmc_queue_cell_t* cell;
+
+  for (;;) {
+    cell = &self->cells[pos & self->mask];
+    const size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+    const intptr_t diff = _M_cast(intptr_t, seq) - _M_cast(intptr_t, pos);
+
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak_explicit(&self->enq, &pos, pos + 1,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      // The cell still holds the item from one round earlier
+      return 0;
+    } else {
+      pos = atomic_load_explicit(&self->enq, memory_order_relaxed);
+    }
+  }
+
+  cell->item = item;
+  atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+  return 1;
+}
+
+/**
+ * @brief Takes the oldest item from the queue unless it is empty.
+ *
+ * @return 1 if an item was stored in `item`, 0 if the queue is empty.
+ */
+__CCMS__INLINE
+int mpmc_queue__try_dequeue(mpmc_queue_t* self, void** item) {
+  size_t pos = atomic_load_explicit(&self->deq, memory_order_relaxed);
+  _mpmc_queue_cell_t* cell;
+
+  for (;;) {
+    cell = &self->cells[pos & self->mask];
+    const size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+    const intptr_t diff = _M_cast(intptr_t, seq) - _M_cast(intptr_t, pos + 1);
+
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak_explicit(&self->deq, &pos, pos + 1,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      // The cell was not filled yet
+      return 0;
+    } else {
+      pos = atomic_load_explicit(&self->deq, memory_order_relaxed);
+    }
+  }
+
+  *item = cell->item;
+  atomic_store_explicit(&cell->seq, pos + self->mask + 1,
+                        memory_order_release);
+  return 1;
+}
+
+/**
+ * @brief Appends as many of the `n` items as there is room for, in order.
+ *
+ * All of them are claimed with a single CAS.
+ *
+ * @return The number of items enqueued, 0 if the queue is full.
+ */
+__CCMS__INLINE
+size_t mpmc_queue__try_enqueue_batch(mpmc_queue_t* self,
+                                     void* const* items,
+                                     const size_t n) {
+  if (n == 0) return 0;
+
+  size_t pos = atomic_load_explicit(&self->enq, memory_order_relaxed);
+  size_t count;
+
+  for (;;) {
+    // Count the free cells from pos on, a cell that is free now stays free
+    // until a producer claims it, which the CAS below rules out
+    for (count = 0; count < n; count++) {
+      const size_t seq = atomic_load_explicit(
+          &self->cells[(pos + count) & self->mask].seq, memory_order_acquire);
+      if (seq != pos + count) break;
+    }
+
+    if (count == 0) {
+      // Either full or another producer moved on, which the first cell shows
+      const size_t seq = atomic_load_explicit(
+          &self->cells[pos & self->mask].seq, memory_order_acquire);
+      if (_M_cast(intptr_t, seq) - _M_cast(intptr_t, pos) < 0) return 0;
+      pos = atomic_load_explicit(&self->enq, memory_order_relaxed);
+      continue;
+    }
+
+    if (atomic_compare_exchange_weak_explicit(&self->enq, &pos, pos + count,
+                                              memory_order_relaxed,
+                                              memory_order_relaxed))
+      break;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    _mpmc_queue_cell_t* cell = &self->cells[(pos + i) & self->mask];
+    cell->item = items[i];
+    atomic_store_explicit(&cell->seq, pos + i + 1, memory_order_release);
+  }
+
+  return count;
+}
+
+/**
+ * @brief Takes up to `n` of the oldest items from the queue, in order.
+ *
+ * All of them are claimed with a single CAS.
+ *
+ * @return The number of items stored in `items`, 0 if the queue is empty.
+ */
+__CCMS__INLINE
+size_t mpmc_queue__try_dequeue_batch(mpmc_queue_t* self,
+                                     void** items,
+                                     const size_t n) {
+  if (n == 0) return 0;
+
+  size_t pos = atomic_load_explicit(&self->deq, memory_order_relaxed);
+  size_t count;
+
+  for (;;) {
+    for (count = 0; count < n; count++) {
+      const size_t seq = atomic_load_explicit(
+          &self->cells[(pos + count) & self->mask].seq, memory_order_acquire);
+      if (seq != pos + count + 1) break;
+    }
+
+    if (count == 0) {
+      const size_t seq = atomic_load_explicit(
+          &self->cells[pos & self->mask].seq, memory_order_acquire);
+      if (_M_cast(intptr_t, seq) - _M_cast(intptr_t, pos + 1) < 0) return 0;
+      pos = atomic_load_explicit(&self->deq, memory_order_relaxed);
+      continue;
+    }
+
+    if (atomic_compare_exchange_weak_explicit(&self->deq, &pos, pos + count,
+                                              memory_order_relaxed,
+                                              memory_order_relaxed))
+      break;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    _mpmc_queue_cell_t* cell = &self->cells[(pos + i) & self->mask];
+    items[i] = cell->item;
+    atomic_store_explicit(&cell->seq, pos + i + self->mask + 1,
+                          memory_order_release);
+  }
+
+  return count;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __CCMS__MPMC_QUEUE__H
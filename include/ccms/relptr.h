@@ -0,0 +1,94 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+#ifndef __CCMS__RELPTR__H
+#define __CCMS__RELPTR__H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ccms/_defs.h"
+#include "ccms/_macros.h"
+
+/**
+ * @typedef relptr_t
+ * @brief Typedef for struct relptr_t
+ */
+typedef struct relptr_t relptr_t;
+
+/**
+ * @struct relptr_t
+ * @brief A self-relative pointer: the distance in bytes from the relptr_t
+ * itself to its target.
+ *
+ * A structure that only points into itself through relptr_t fields stays valid
+ * when it is copied or mapped to another address as a whole, e.g. an arena
+ * cloned with st_arena__clone or loaded with st_arena__load/vm_arena__load.
+ * The relptr_t and its target have to be moved together.
+ *
+ * @var relptr_t::off
+ * The offset of the target from the relptr_t, 0 for NULL (a relptr_t can not
+ * point to itself).
+ */
+struct relptr_t {
+  intptr_t off;
+};
+
+/**
+ * @brief Points `self` at `target` (which may be NULL).
+ */
+__CCMS__INLINE
+void relptr__set(relptr_t* self, const void* target) {
+  self->off = target == NULL ? 0
+                             : _M_cast(intptr_t, target) -
+                                   _M_cast(intptr_t, self);
+}
+
+/**
+ * @brief Returns the target of `self`, NULL if it has none.
+ */
+__CCMS__INLINE
+void* relptr__get(const relptr_t* self) {
+  return self->off == 0
+             ? NULL
+             : _M_cast(void*, _M_cast(intptr_t, self) + self->off);
+}
+
+/**
+ * @brief Checks whether `self` has no target.
+ */
+__CCMS__INLINE
+int relptr__is_null(const relptr_t* self) {
+  return self->off == 0;
+}
+
+/**
+ * @brief Returns the target of `self` as a `T*`.
+ */
+#define relptr__deref(T, self) _M_cast(T*, relptr__get(self))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __CCMS__RELPTR__H
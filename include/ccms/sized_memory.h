@@ -150,6 +150,40 @@ sized_mem_t* sized_mem__from_box(const box_t box) {
   return self;
 }
 
+/**
+ * @brief Checks whether two sized_mem_t objects hold the same bytes, see
+ * box__eq.
+ */
+__CCMS__INLINE
+int sized_mem__eq(const sized_mem_t* a, const sized_mem_t* b) {
+  return box__eq(sized_mem__as_box(a), sized_mem__as_box(b));
+}
+
+/**
+ * @brief Compares two sized_mem_t objects lexicographically, see box__cmp.
+ */
+__CCMS__INLINE
+int sized_mem__cmp(const sized_mem_t* a, const sized_mem_t* b) {
+  return box__cmp(sized_mem__as_box(a), sized_mem__as_box(b));
+}
+
+/**
+ * @brief Checks whether a sized_mem_t object starts with the bytes of
+ * `prefix`, see box__starts_with.
+ */
+__CCMS__INLINE
+int sized_mem__starts_with(const sized_mem_t* self, const box_t prefix) {
+  return box__starts_with(sized_mem__as_box(self), prefix);
+}
+
+/**
+ * @brief Hashes the contained memory of a sized_mem_t object, see box__hash.
+ */
+__CCMS__INLINE
+uint64_t sized_mem__hash(const sized_mem_t* self) {
+  return box__hash(sized_mem__as_box(self));
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,213 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+#ifndef __CCMS__SPSC_RING__H
+#define __CCMS__SPSC_RING__H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef __CCMS__SUPPRESS_WARNINGS
+#include <stdio.h>
+#endif
+
+#include "ccms/_defs.h"
+#include "ccms/_macros.h"
+#include "ccms/_os.h"
+#include "ccms/box.h"
+
+#ifndef __CCMS__HAS_ATOMICS
+#error "ccms/spsc_ring.h requires C11 atomics"
+#endif
+
+#ifndef __CCMS__HAS_VMEM
+#error "ccms/spsc_ring.h requires mmap or VirtualAlloc"
+#endif
+
+#include <stdatomic.h>
+
+// Smallest (and granularity of the) capacity of a ring
+#define _SPSC_RING_MIN_SIZE 65536
+
+/**
+ * @typedef spsc_ring_t
+ * @brief Typedef for struct spsc_ring_t
+ */
+typedef struct spsc_ring_t spsc_ring_t;
+
+/**
+ * @struct spsc_ring_t
+ * @brief A lock-free byte ring buffer for one producer and one consumer.
+ *
+ * The buffer is mapped twice, back to back, so every readable or writable
+ * range is contiguous in memory even where it wraps around the end of the
+ * buffer: the producer writes straight into the box from spsc_ring__reserve,
+ * the consumer reads straight from the box from spsc_ring__peek.
+ *
+ * `head` and `tail` count the bytes written and read so far. Each is written
+ * by one side only and published with release/acquire ordering. Both sides
+ * cache the last value they saw of the other side's counter on their own cache
+ * line, so they only touch the other line when the cached value runs out.
+ */
+struct spsc_ring_t {
+  // Producer side
+  _Atomic size_t head;
+  size_t cached_tail;
+  uint8_t _pad0[64 - 2 * sizeof(size_t)];
+  // Consumer side
+  _Atomic size_t tail;
+  size_t cached_head;
+  uint8_t _pad1[64 - 2 * sizeof(size_t)];
+  uint8_t* data;
+  size_t size;
+};
+
+/**
+ * @brief Creates a ring holding at least `size` bytes.
+ *
+ * The capacity is rounded up to a power of two of at least 64 KiB.
+ *
+ * @return The new ring, or NULL if the memory could not be mapped.
+ */
+__CCMS__INLINE
+spsc_ring_t* spsc_ring__new(const size_t size) {
+  size_t cap = _SPSC_RING_MIN_SIZE;
+  while (cap < size)
+    cap *= 2;
+
+  uint8_t* data = _os__map_mirrored(cap);
+  if (data == NULL) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+    fprintf(stderr,
+            "warning: failed to map a mirrored buffer of size %ld for a ring "
+            "(spsc), returned NULL\n",
+            cap);
+#endif
+    return NULL;
+  }
+
+  spsc_ring_t* self = _M_new(spsc_ring_t);
+
+  atomic_init(&self->head, 0);
+  atomic_init(&self->tail, 0);
+  self->cached_tail = self->cached_head = 0;
+  self->data = data;
+  self->size = cap;
+
+  return self;
+}
+
+__CCMS__INLINE
+void spsc_ring__free(spsc_ring_t* self) {
+  _os__unmap_mirrored(self->data, self->size);
+  _M_free(self);
+}
+
+/**
+ * @brief Returns the capacity of the ring in bytes.
+ */
+__CCMS__INLINE
+size_t spsc_ring__cap(const spsc_ring_t* self) {
+  return self->size;
+}
+
+/**
+ * @brief Producer: returns all free space of the ring as one contiguous box,
+ * if there are at least `min` bytes of it.
+ *
+ * Bytes written into the box become visible to the consumer with
+ * spsc_ring__commit.
+ *
+ * @return The free space, or a box with a NULL pointer if less than `min`
+ * bytes are free.
+ */
+__CCMS__INLINE
+box_t spsc_ring__reserve(spsc_ring_t* self, const size_t min) {
+  const size_t head = atomic_load_explicit(&self->head, memory_order_relaxed);
+  size_t free = self->size - (head - self->cached_tail);
+
+  if (free < min || free == 0) {
+    // Pairs with the release in spsc_ring__release: the consumer is done with
+    // the bytes before they are handed out again
+    self->cached_tail =
+        atomic_load_explicit(&self->tail, memory_order_acquire);
+    free = self->size - (head - self->cached_tail);
+
+    if (free < min || free == 0) return box__ctor(NULL, 0);
+  }
+
+  return box__ctor(self->data + (head & (self->size - 1)), free);
+}
+
+/**
+ * @brief Producer: publishes the first `n` bytes of the last reserved box.
+ */
+__CCMS__INLINE
+void spsc_ring__commit(spsc_ring_t* self, const size_t n) {
+  const size_t head = atomic_load_explicit(&self->head, memory_order_relaxed);
+
+  atomic_store_explicit(&self->head, head + n, memory_order_release);
+}
+
+/**
+ * @brief Consumer: returns all readable bytes as one contiguous box.
+ *
+ * The bytes stay in the ring until they are given back with
+ * spsc_ring__release.
+ *
+ * @return The readable bytes, or a box with a NULL pointer if there are none.
+ */
+__CCMS__INLINE
+box_t spsc_ring__peek(spsc_ring_t* self) {
+  const size_t tail = atomic_load_explicit(&self->tail, memory_order_relaxed);
+  size_t avail = self->cached_head - tail;
+
+  if (avail == 0) {
+    // Pairs with the release in spsc_ring__commit: the bytes are written
+    // before they are read
+    self->cached_head =
+        atomic_load_explicit(&self->head, memory_order_acquire);
+    avail = self->cached_head - tail;
+
+    if (avail == 0) return box__ctor(NULL, 0);
+  }
+
+  return box__ctor(self->data + (tail & (self->size - 1)), avail);
+}
+
+/**
+ * @brief Consumer: gives the first `n` bytes of the last peeked box back to
+ * the producer.
+ */
+__CCMS__INLINE
+void spsc_ring__release(spsc_ring_t* self, const size_t n) {
+  const size_t tail = atomic_load_explicit(&self->tail, memory_order_relaxed);
+
+  atomic_store_explicit(&self->tail, tail + n, memory_order_release);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __CCMS__SPSC_RING__H
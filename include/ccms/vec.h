@@ -0,0 +1,184 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+#ifndef __CCMS__VEC__H
+#define __CCMS__VEC__H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef __CCMS__SUPPRESS_WARNINGS
+#include <stdio.h>
+#endif
+
+#include "ccms/_defs.h"
+#include "ccms/_macros.h"
+#include "ccms/allocator.h"
+#include "ccms/box.h"
+
+// Smallest capacity a vector grows to on its first push
+#ifndef __CCMS__VEC_MIN_CAP
+#define __CCMS__VEC_MIN_CAP 8
+#endif
+
+// Preprocessor conditionals cannot go into vec__define itself
+__CCMS__INLINE
+void _vec__warn_append(const size_t size, const size_t elem_size) {
+#ifndef __CCMS__SUPPRESS_WARNINGS
+  fprintf(stderr,
+          "warning: tried appending a box of size %ld to a vector of elements "
+          "of size %ld, ignored\n",
+          size, elem_size);
+#else
+  _M_cast(void, size);
+  _M_cast(void, elem_size);
+#endif
+}
+
+/**
+ * @brief Defines a growable vector type `name##_t` of elements of type `T`.
+ *
+ * The vector takes its storage from an allocator_t and grows geometrically.
+ * Growth goes through allocator__realloc, so a vector that owns the tail of
+ * an arena grows in place there instead of copying itself. Defines:
+ *
+ * - `name##_t name##__ctor(allocator_t alloc)`: an empty vector.
+ * - `void name##__free(name##_t* self)`: releases the storage.
+ * - `int name##__reserve(name##_t* self, size_t cap)`: makes room for at
+ *   least `cap` elements, returns 0 on success and -1 on failure.
+ * - `T* name##__push(name##_t* self, T value)`: appends `value`, returns a
+ *   pointer to the new element or NULL on failure.
+ * - `int name##__append(name##_t* self, box_t box)`: appends the elements
+ *   stored in `box`, whose size has to be a multiple of `sizeof(T)`.
+ * - `T name##__pop(name##_t* self)`: removes the last element.
+ * - `T name##__swap_remove(name##_t* self, size_t i)`: removes element `i`
+ *   in O(1) by moving the last element into its place.
+ * - `void name##__clear(name##_t* self)`: removes all elements.
+ * - `box_t name##__as_box(const name##_t* self)`: the elements as bytes.
+ *
+ * Elements are accessed directly through `data[0 .. len)`.
+ */
+#define vec__define(name, T)                                                  \
+  typedef struct name##_t name##_t;                                           \
+                                                                              \
+  struct name##_t {                                                           \
+    T* data;                                                                  \
+    size_t len;                                                               \
+    size_t cap;                                                               \
+    allocator_t alloc;                                                        \
+  };                                                                          \
+                                                                              \
+  __CCMS__INLINE                                                              \
+  name##_t name##__ctor(allocator_t alloc) {                                  \
+    name##_t self = {NULL, 0, 0, alloc};                                      \
+    return self;                                                              \
+  }                                                                           \
+                                                                              \
+  __CCMS__INLINE                                                              \
+  void name##__free(name##_t* self) {                                         \
+    allocator__dealloc(&self->alloc, _M_cast(uint8_t*, self->data),           \
+                       self->cap * sizeof(T));                                \
+    self->data = NULL;                                                        \
+    self->len = self->cap = 0;                                                \
+  }                                                                           \
+                                                                              \
+  __CCMS__INLINE                                                              \
+  int name##__reserve(name##_t* self, const size_t cap) {                     \
+    if (cap <= self->cap) return 0;                                           \
+                                                                              \
+    T* data = _M_cast(                                                        \
+        T*, allocator__realloc(&self->alloc, _M_cast(uint8_t*, self->data),   \
+                               self->cap * sizeof(T), cap * sizeof(T),        \
+                               _M_alignof(T)));                               \
+    if (data == NULL) return -1;                                              \
+                                                                              \
+    self->data = data;                                                        \
+    self->cap = cap;                                                          \
+    return 0;                                                                 \
+  }                                                                           \
+                                                                              \
+  /* Grows the capacity geometrically to hold at least `len` elements */      \
+  __CCMS__INLINE                                                              \
+  int _##name##__grow(name##_t* self, const size_t len) {                     \
+    size_t cap = self->cap * 2;                                               \
+                                                                              \
+    if (cap < __CCMS__VEC_MIN_CAP) cap = __CCMS__VEC_MIN_CAP;                 \
+    if (cap < len) cap = len;                                                 \
+    return name##__reserve(self, cap);                                        \
+  }                                                                           \
+                                                                              \
+  __CCMS__INLINE                                                              \
+  T* name##__push(name##_t* self, T value) {                                  \
+    if (self->len == self->cap && _##name##__grow(self, self->len + 1) != 0)  \
+      return NULL;                                                            \
+                                                                              \
+    T* slot = &self->data[self->len++];                                       \
+    *slot = value;                                                            \
+    return slot;                                                              \
+  }                                                                           \
+                                                                              \
+  __CCMS__INLINE                                                              \
+  int name##__append(name##_t* self, const box_t box) {                       \
+    if (box.size % sizeof(T) != 0) {                                          \
+      _vec__warn_append(box.size, sizeof(T));                                 \
+      return -1;                                                              \
+    }                                                                         \
+                                                                              \
+    const size_t n = box.size / sizeof(T);                                    \
+    if (self->len + n > self->cap &&                                          \
+        _##name##__grow(self, self->len + n) != 0)                            \
+      return -1;                                                              \
+                                                                              \
+    if (n > 0) memcpy(self->data + self->len, box.ptr, box.size);             \
+    self->len += n;                                                           \
+    return 0;                                                                 \
+  }                                                                           \
+                                                                              \
+  __CCMS__INLINE                                                              \
+  T name##__pop(name##_t* self) {                                             \
+    return self->data[--self->len];                                           \
+  }                                                                           \
+                                                                              \
+  __CCMS__INLINE                                                              \
+  T name##__swap_remove(name##_t* self, const size_t i) {                     \
+    T removed = self->data[i];                                                \
+    self->data[i] = self->data[--self->len];                                  \
+    return removed;                                                           \
+  }                                                                           \
+                                                                              \
+  __CCMS__INLINE                                                              \
+  void name##__clear(name##_t* self) {                                        \
+    self->len = 0;                                                            \
+  }                                                                           \
+                                                                              \
+  __CCMS__INLINE                                                              \
+  box_t name##__as_box(const name##_t* self) {                                \
+    return box__ctor(_M_cast(uint8_t*, self->data), self->len * sizeof(T));   \
+  }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __CCMS__VEC__H
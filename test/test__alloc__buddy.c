@@ -0,0 +1,210 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// do not move or delete this #undef, otherwise the test will always pass, as
+// assert is only defined in debug mode. This #undef forces assert to be defined
+#undef NDEBUG
+#include <assert.h>
+#include <string.h>
+
+// Include the header file to test
+#include "ccms/alloc/buddy.h"
+
+//
+//
+// ------------------ buddy_t ------------------
+//
+//
+
+void test__buddy__new_and_free() {
+  // -- TEST
+  buddy_t* buddy = buddy__new(KiB(64), 64);
+  assert(buddy != NULL);
+  assert(buddy->size == KiB(64));
+  assert(buddy->min_order == 6);
+  assert(buddy->max_order == 16);
+  assert(buddy->used == 0);
+  assert(_M_cast(uintptr_t, buddy->base) % 64 == 0);
+
+  // the minimum block holds at least the free list links
+  buddy_t* tiny = buddy__new(1000, 1);
+  assert(tiny != NULL);
+  assert((_M_cast(size_t, 1) << tiny->min_order) >= sizeof(_buddy_node_t));
+  assert(tiny->size <= 1000);
+
+  assert(buddy__new(KiB(64), 100) == NULL);
+  assert(buddy__new(32, 64) == NULL);
+
+  // -- CLEANUP
+  buddy__free(buddy);
+  buddy__free(tiny);
+}
+
+void test__buddy__alloc() {
+  // -- PREPARE
+  buddy_t* buddy = buddy__new(KiB(1), 64);
+
+  // -- TEST
+  uint8_t* a = buddy__alloc(buddy, 100);
+  assert(a == buddy->base);
+  assert(buddy__size(buddy, a) == 128);
+  memset(a, 1, 100);
+
+  // the halves split off for `a` serve the next requests
+  uint8_t* b = buddy__alloc(buddy, 64);
+  assert(b == buddy->base + 128);
+  uint8_t* c = buddy__alloc(buddy, 200);
+  assert(c == buddy->base + 256);
+  uint8_t* d = buddy__alloc(buddy, 1);
+  assert(d == buddy->base + 192);
+  assert(buddy->used == 128 + 64 + 256 + 64);
+
+  // the remaining 512 bytes are one block, larger requests fail
+  assert(buddy__alloc(buddy, 513) == NULL);
+  uint8_t* e = buddy__alloc(buddy, 512);
+  assert(e == buddy->base + 512);
+  assert(buddy__alloc(buddy, 1) == NULL);
+  assert(buddy__alloc(buddy, KiB(2)) == NULL);
+
+  // -- CLEANUP
+  buddy__free(buddy);
+}
+
+void test__buddy__dealloc() {
+  // -- PREPARE
+  buddy_t* buddy = buddy__new(KiB(1), 64);
+  uint8_t* blocks[16];
+  for (size_t i = 0; i < 16; i++)
+    blocks[i] = buddy__alloc(buddy, 64);
+  assert(buddy__alloc(buddy, 1) == NULL);
+
+  // -- TEST
+  // freed buddies merge back into larger blocks
+  buddy__dealloc(buddy, blocks[0]);
+  buddy__dealloc(buddy, blocks[1]);
+  assert(buddy__alloc(buddy, 128) == blocks[0]);
+  buddy__dealloc(buddy, blocks[0]);
+
+  // a double free is caught and ignored
+  buddy__dealloc(buddy, blocks[0]);
+  assert(buddy->used == KiB(1) - 128);
+
+  // blocks that are not buddies do not merge
+  buddy__dealloc(buddy, blocks[3]);
+  assert(buddy__alloc(buddy, 256) == NULL);
+
+  // freeing everything restores the region as one block
+  for (size_t i = 2; i < 16; i++)
+    if (i != 3) buddy__dealloc(buddy, blocks[i]);
+  assert(buddy->used == 0);
+  assert(buddy__alloc(buddy, KiB(1)) == buddy->base);
+
+  // -- CLEANUP
+  buddy__free(buddy);
+}
+
+void test__buddy__uneven_size() {
+  // -- PREPARE
+  // 1024 + 256 + 64
+  buddy_t* buddy = buddy__new(1344, 64);
+
+  // -- TEST
+  assert(buddy->max_order == 10);
+  uint8_t* a = buddy__alloc(buddy, KiB(1));
+  uint8_t* b = buddy__alloc(buddy, 256);
+  uint8_t* c = buddy__alloc(buddy, 64);
+  assert(a == buddy->base);
+  assert(b == buddy->base + 1024);
+  assert(c == buddy->base + 1280);
+  assert(buddy__alloc(buddy, 1) == NULL);
+
+  // blocks at the end have no buddy to merge with
+  buddy__dealloc(buddy, b);
+  buddy__dealloc(buddy, c);
+  assert(buddy__alloc(buddy, 512) == NULL);
+  assert(buddy__alloc(buddy, 256) == b);
+
+  // -- CLEANUP
+  buddy__free(buddy);
+}
+
+void test__buddy__reset() {
+  // -- PREPARE
+  buddy_t* buddy = buddy__new(KiB(4), 64);
+  for (size_t i = 0; i < 10; i++)
+    buddy__alloc(buddy, 100);
+
+  // -- TEST
+  buddy__reset(buddy);
+  assert(buddy->used == 0);
+  assert(buddy__alloc(buddy, KiB(4)) == buddy->base);
+
+  // -- CLEANUP
+  buddy__free(buddy);
+}
+
+void test__buddy__churn() {
+  // -- PREPARE
+  buddy_t* buddy = buddy__new(MiB(1), 16);
+  uint8_t* ptrs[256] = {NULL};
+  size_t sizes[256] = {0};
+  uint64_t seed = 1;
+
+  // -- TEST
+  for (size_t round = 0; round < 20000; round++) {
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    const size_t i = (seed >> 33) % 256;
+
+    if (ptrs[i] != NULL) {
+      assert(ptrs[i][0] == _M_cast(uint8_t, sizes[i]));
+      assert(ptrs[i][sizes[i] - 1] == _M_cast(uint8_t, sizes[i]));
+      buddy__dealloc(buddy, ptrs[i]);
+    }
+    sizes[i] = 1 + (seed >> 40) % 2000;
+    ptrs[i] = buddy__alloc(buddy, sizes[i]);
+    assert(ptrs[i] != NULL);
+    memset(ptrs[i], _M_cast(uint8_t, sizes[i]), sizes[i]);
+  }
+
+  for (size_t i = 0; i < 256; i++)
+    buddy__dealloc(buddy, ptrs[i]);
+  assert(buddy->used == 0);
+  assert(buddy__alloc(buddy, MiB(1)) == buddy->base);
+
+  // -- CLEANUP
+  buddy__free(buddy);
+}
+
+//
+//
+// ------------------ main ------------------
+//
+//
+
+int main() {
+  // -- buddy_t
+  test__buddy__new_and_free();
+  test__buddy__alloc();
+  test__buddy__dealloc();
+  test__buddy__uneven_size();
+  test__buddy__reset();
+  test__buddy__churn();
+
+  return 0;
+}
@@ -0,0 +1,197 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// do not move or delete this #undef, otherwise the test will always pass, as
+// assert is only defined in debug mode. This #undef forces assert to be defined
+#undef NDEBUG
+#include <assert.h>
+#include <string.h>
+
+// Include the header file to test
+#include "ccms/alloc/heap.h"
+
+//
+//
+// ------------------ heap_t ------------------
+//
+//
+
+void test__heap__classes() {
+  // -- TEST
+  assert(_heap__class(0) == 0);
+  assert(_heap__class(1) == 0);
+  assert(_heap__class(16) == 0);
+  assert(_heap__class(17) == 1);
+  assert(_heap__class(128) == 7);
+  assert(_heap__class(129) == 8);
+  assert(_heap__class_size(8) == 160);
+  assert(_heap__class(__CCMS__HEAP_MAX_SMALL) == _HEAP_NCLASSES - 1);
+
+  // every class is the smallest one its size fits into
+  for (size_t size = 1; size <= __CCMS__HEAP_MAX_SMALL; size++) {
+    const size_t cls = _heap__class(size);
+    assert(cls < _HEAP_NCLASSES);
+    assert(_heap__class_size(cls) >= size);
+    assert(cls == 0 || _heap__class_size(cls - 1) < size);
+    assert(_heap__class_size(cls) % _M_MAX_ALIGN == 0);
+  }
+}
+
+void test__heap__alloc_and_dealloc() {
+  // -- PREPARE
+  heap_t* heap = heap__new();
+  const size_t sizes[] = {1, 16, 24, 100, 129, 1000, 8192, 8193, MiB(1)};
+  const size_t n = sizeof(sizes) / sizeof(sizes[0]);
+  uint8_t* ptrs[sizeof(sizes) / sizeof(sizes[0])];
+
+  // -- TEST
+  for (size_t i = 0; i < n; i++) {
+    ptrs[i] = heap__alloc(heap, sizes[i]);
+    assert(ptrs[i] != NULL);
+    assert(_M_cast(uintptr_t, ptrs[i]) % _M_MAX_ALIGN == 0);
+    assert(heap__size(heap, ptrs[i]) >= sizes[i]);
+    memset(ptrs[i], _M_cast(int, i), sizes[i]);
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    assert(ptrs[i][0] == i);
+    assert(ptrs[i][sizes[i] - 1] == i);
+  }
+
+  // the same size class hands out a freed object again
+  heap__dealloc(heap, ptrs[2]);
+  assert(heap__alloc(heap, 20) == ptrs[2]);
+
+  for (size_t i = 0; i < n; i++)
+    heap__dealloc(heap, ptrs[i]);
+  assert(heap->large == NULL);
+  heap__dealloc(heap, NULL);
+
+  // -- CLEANUP
+  heap__free(heap);
+}
+
+void test__heap__cache() {
+  // -- PREPARE
+  heap_t* heap = heap__new();
+  const size_t cacheable = __CCMS__HEAP_CACHE_SIZE / 16;
+  const size_t n = cacheable + 4;
+  uint8_t** ptrs = _M_new_arr(uint8_t*, n);
+
+  for (size_t i = 0; i < n; i++)
+    ptrs[i] = heap__alloc(heap, 16);
+  slab_t* slab = heap->classes[0];
+  assert(slab->nobjs == n);
+
+  // -- TEST
+  // freed objects are parked in the cache until it is full, the rest goes
+  // back to the slab
+  for (size_t i = 0; i < n; i++)
+    heap__dealloc(heap, ptrs[i]);
+  assert(heap->cached[0] == cacheable * 16);
+  assert(slab->nobjs == cacheable);
+
+  // the cache is used up (most recently freed first) before the slab
+  for (size_t i = cacheable; i > 0; i--)
+    assert(heap__alloc(heap, 16) == ptrs[i - 1]);
+  assert(heap->cache[0] == NULL && heap->cached[0] == 0);
+  assert(slab->nobjs == cacheable);
+  heap__alloc(heap, 16);
+  assert(slab->nobjs == cacheable + 1);
+
+  // -- CLEANUP
+  _M_free(ptrs);
+  heap__free(heap);
+}
+
+void test__heap__realloc() {
+  // -- PREPARE
+  heap_t* heap = heap__new();
+
+  // -- TEST
+  uint8_t* ptr = heap__realloc(heap, NULL, 10);
+  assert(ptr != NULL);
+  memcpy(ptr, "123456789", 10);
+
+  // within the same class the object stays where it is
+  assert(heap__realloc(heap, ptr, 16) == ptr);
+
+  // growing moves the contents into a larger class
+  ptr = heap__realloc(heap, ptr, 1000);
+  assert(heap__size(heap, ptr) >= 1000);
+  assert(strcmp(_M_cast(char*, ptr), "123456789") == 0);
+
+  // into a large block and back
+  ptr = heap__realloc(heap, ptr, KiB(100));
+  assert(heap__size(heap, ptr) >= KiB(100));
+  assert(strcmp(_M_cast(char*, ptr), "123456789") == 0);
+  assert(heap__realloc(heap, ptr, KiB(90)) == ptr);
+
+  ptr = heap__realloc(heap, ptr, 32);
+  assert(heap__size(heap, ptr) == 32);
+  assert(heap->large == NULL);
+  assert(strcmp(_M_cast(char*, ptr), "123456789") == 0);
+
+  // -- CLEANUP
+  heap__free(heap);
+}
+
+void test__heap__churn() {
+  // -- PREPARE
+  heap_t* heap = heap__new();
+  uint8_t* ptrs[1000] = {NULL};
+  size_t sizes[1000] = {0};
+  uint64_t seed = 1;
+
+  // -- TEST
+  for (size_t round = 0; round < 20000; round++) {
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    const size_t i = (seed >> 33) % 1000;
+
+    if (ptrs[i] != NULL) {
+      // contents survive as long as the object lives
+      assert(ptrs[i][0] == _M_cast(uint8_t, sizes[i]));
+      assert(ptrs[i][sizes[i] - 1] == _M_cast(uint8_t, sizes[i]));
+      heap__dealloc(heap, ptrs[i]);
+    }
+    sizes[i] = 1 + (seed >> 40) % 2000;
+    ptrs[i] = heap__alloc(heap, sizes[i]);
+    memset(ptrs[i], _M_cast(uint8_t, sizes[i]), sizes[i]);
+  }
+
+  // -- CLEANUP
+  heap__free(heap);
+}
+
+//
+//
+// ------------------ main ------------------
+//
+//
+
+int main() {
+  // -- heap_t
+  test__heap__classes();
+  test__heap__alloc_and_dealloc();
+  test__heap__cache();
+  test__heap__realloc();
+  test__heap__churn();
+
+  return 0;
+}
@@ -0,0 +1,202 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// do not move or delete this #undef, otherwise the test will always pass, as
+// assert is only defined in debug mode. This #undef forces assert to be defined
+#undef NDEBUG
+#include <assert.h>
+#include <string.h>
+
+// Include the header file to test
+#include "ccms/alloc/slab.h"
+
+//
+//
+// ------------------ slab_t ------------------
+//
+//
+
+void test__slab__new_and_free() {
+  // -- TEST
+  slab_t* slab = slab__new(24, KiB(4));
+  assert(slab != NULL);
+  assert(slab->slot_size == 24);
+  assert(slab->page_size == KiB(4));
+  assert(slab->slot_offset % _M_MAX_ALIGN == 0);
+  assert(slab->slots_per_page ==
+         (KiB(4) - slab->slot_offset) / slab->slot_size);
+  assert(slab->npages == 0);
+  assert(slab->nobjs == 0);
+
+  // slots are at least pointer sized, to link free slots together
+  slab_t* tiny = slab__new(1, KiB(4));
+  assert(tiny->slot_size == sizeof(void*));
+
+  // page size has to be a power of two that fits at least one object
+  assert(slab__new(24, 3000) == NULL);
+  assert(slab__new(KiB(8), KiB(4)) == NULL);
+
+  // -- CLEANUP
+  slab__free(slab);
+  slab__free(tiny);
+}
+
+void test__slab__alloc() {
+  // -- PREPARE
+  slab_t* slab = slab__new(32, KiB(4));
+  const size_t n = 3 * slab->slots_per_page + 1;
+  uint8_t** objs = _M_new_arr(uint8_t*, n);
+
+  // -- TEST
+  for (size_t i = 0; i < n; i++) {
+    objs[i] = slab__alloc(slab);
+    assert(objs[i] != NULL);
+    memset(objs[i], _M_cast(int, i), 32);
+  }
+  assert(slab->nobjs == n);
+  assert(slab->npages == 4);
+
+  // objects of one page are handed out back to back
+  assert(objs[1] == objs[0] + 32);
+
+  for (size_t i = 0; i < n; i++) {
+    // every object lies within the page its address is masked to
+    const uintptr_t page = _M_cast(uintptr_t, objs[i]) & ~(KiB(4) - 1);
+    assert(_M_cast(uintptr_t, objs[i]) >= page + slab->slot_offset);
+    assert(_M_cast(uintptr_t, objs[i]) + 32 <= page + KiB(4));
+    assert(objs[i][0] == _M_cast(uint8_t, i));
+    assert(objs[i][31] == _M_cast(uint8_t, i));
+  }
+
+  // -- CLEANUP
+  _M_free(objs);
+  slab__free(slab);
+}
+
+void test__slab__dealloc() {
+  // -- PREPARE
+  slab_t* slab = slab__new(32, KiB(4));
+  const size_t n = 2 * slab->slots_per_page;
+  uint8_t** objs = _M_new_arr(uint8_t*, n);
+  for (size_t i = 0; i < n; i++)
+    objs[i] = slab__alloc(slab);
+  assert(slab->partial == NULL);
+
+  // -- TEST
+  // a freed slot is reused by the next allocation
+  slab__dealloc(slab, objs[5]);
+  assert(slab->nobjs == n - 1);
+  assert(slab->partial != NULL);
+  assert(slab__alloc(slab) == objs[5]);
+  assert(slab->partial == NULL);
+
+  // freeing everything keeps the pages of an untracked slab
+  for (size_t i = 0; i < n; i++)
+    slab__dealloc(slab, objs[i]);
+  assert(slab->nobjs == 0);
+  assert(slab->npages == 2);
+
+  for (size_t i = 0; i < n; i++)
+    objs[i] = slab__alloc(slab);
+  assert(slab->npages == 2);
+
+  // -- CLEANUP
+  _M_free(objs);
+  slab__free(slab);
+}
+
+void test__slab__tracked() {
+  // -- PREPARE
+  slab_t* slab = slab__new_tracked(48, KiB(4));
+  const size_t n = 4 * slab->slots_per_page;
+  uint8_t** objs = _M_new_arr(uint8_t*, n);
+  for (size_t i = 0; i < n; i++)
+    objs[i] = slab__alloc(slab);
+  assert(slab->npages == 4);
+
+  // -- TEST
+  // a double free is caught and ignored
+  slab__dealloc(slab, objs[0]);
+  slab__dealloc(slab, objs[0]);
+  assert(slab->nobjs == n - 1);
+  assert(slab__alloc(slab) == objs[0]);
+  assert(slab->nobjs == n);
+
+  // empty pages are released, except for a single spare
+  for (size_t i = 0; i < n; i++)
+    slab__dealloc(slab, objs[i]);
+  assert(slab->nobjs == 0);
+  assert(slab->npages == 1);
+  assert(slab->spare != NULL);
+
+  // the spare page is picked up again before allocating a new one
+  uint8_t* obj = slab__alloc(slab);
+  assert(slab->npages == 1);
+  assert(slab->spare == NULL);
+  slab__dealloc(slab, obj);
+  assert(slab->spare != NULL);
+
+  // -- CLEANUP
+  _M_free(objs);
+  slab__free(slab);
+}
+
+void test__slab__reset() {
+  // -- PREPARE
+  slab_t* slab = slab__new_tracked(16, KiB(1));
+  const size_t n = 3 * slab->slots_per_page;
+  uint8_t* first = NULL;
+  for (size_t i = 0; i < n; i++) {
+    uint8_t* obj = slab__alloc(slab);
+    if (i == 0) first = obj;
+  }
+
+  // -- TEST
+  slab__reset(slab);
+  assert(slab->nobjs == 0);
+  assert(slab->npages == 3);
+  assert(slab->full == NULL);
+
+  // all pages are reused and the bitmaps start out empty again
+  for (size_t i = 0; i < n; i++)
+    assert(slab__alloc(slab) != NULL);
+  assert(slab->npages == 3);
+  slab__dealloc(slab, first);
+  assert(slab->nobjs == n - 1);
+
+  // -- CLEANUP
+  slab__free(slab);
+}
+
+//
+//
+// ------------------ main ------------------
+//
+//
+
+int main() {
+  // -- slab_t
+  test__slab__new_and_free();
+  test__slab__alloc();
+  test__slab__dealloc();
+  test__slab__tracked();
+  test__slab__reset();
+
+  return 0;
+}
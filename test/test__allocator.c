@@ -0,0 +1,227 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// do not move or delete this #undef, otherwise the test will always pass, as
+// assert is only defined in debug mode. This #undef forces assert to be defined
+#undef NDEBUG
+#include <assert.h>
+#include <string.h>
+
+// Include the header file to test
+#include "ccms/allocator.h"
+
+//
+//
+// ------------------ allocator_t ------------------
+//
+//
+
+static void check_allocator(allocator_t alloc) {
+  uint8_t* a = allocator__alloc(&alloc, 10, 8);
+  assert(a != NULL);
+  assert(_M_cast(uintptr_t, a) % 8 == 0);
+  memcpy(a, "123456789", 10);
+
+  a = allocator__realloc(&alloc, a, 10, 1000, 8);
+  assert(a != NULL);
+  assert(_M_cast(uintptr_t, a) % 8 == 0);
+  assert(strcmp(_M_cast(char*, a), "123456789") == 0);
+  memset(a + 10, 1, 990);
+
+  a = allocator__realloc(&alloc, a, 1000, 20, 8);
+  assert(strcmp(_M_cast(char*, a), "123456789") == 0);
+
+  allocator__dealloc(&alloc, a, 20);
+  allocator__dealloc(&alloc, NULL, 0);
+}
+
+void test__allocator__kinds() {
+  // -- PREPARE
+  heap_t* heap = heap__new();
+  st_arena_t* st_arena = st_arena__new(KiB(4));
+  pg_arena_t* pg_arena = pg_arena__new(KiB(4));
+  dyn_arena_t* dyn_arena = dyn_arena__new();
+  vm_arena_t* vm_arena = vm_arena__new(MiB(1));
+
+  // -- TEST
+  check_allocator(allocator__malloc());
+  check_allocator(allocator__heap(heap));
+  check_allocator(allocator__st_arena(st_arena));
+  check_allocator(allocator__pg_arena(pg_arena));
+  check_allocator(allocator__dyn_arena(dyn_arena));
+  check_allocator(allocator__vm_arena(vm_arena));
+
+  // -- CLEANUP
+  heap__free(heap);
+  st_arena__free(st_arena);
+  pg_arena__free(pg_arena);
+  dyn_arena__free(dyn_arena);
+  vm_arena__free(vm_arena);
+}
+
+void test__allocator__arena_tail() {
+  // -- PREPARE
+  st_arena_t* arena = st_arena__new(KiB(4));
+  allocator_t alloc = allocator__st_arena(arena);
+
+  // -- TEST
+  // the most recent chunk of an arena is resized in place and given back
+  uint8_t* a = allocator__alloc(&alloc, 100, 16);
+  assert(allocator__realloc(&alloc, a, 100, 1000, 16) == a);
+  assert(st_arena__cap(arena) == KiB(4) - 1000);
+  allocator__dealloc(&alloc, a, 1000);
+  assert(st_arena__cap(arena) == KiB(4));
+
+  // a moved chunk keeps the requested alignment
+  a = allocator__alloc(&alloc, 100, 1);
+  allocator__alloc(&alloc, 1, 1);
+  uint8_t* b = allocator__realloc(&alloc, a, 100, 200, 64);
+  assert(b != a);
+  assert(_M_cast(uintptr_t, b) % 64 == 0);
+
+  // -- CLEANUP
+  st_arena__free(arena);
+}
+
+void test__allocator__align() {
+  // -- PREPARE
+  allocator_t alloc = allocator__malloc();
+
+  // -- TEST
+  // _M_alloc does not support stricter alignments than max_align_t
+  assert(allocator__alloc(&alloc, 10, _M_MAX_ALIGN * 2) == NULL);
+}
+
+//
+//
+// ------------------ static dispatch ------------------
+//
+//
+
+// Same as check_allocator, through the ccms__* macros
+#define check_generic(a)                                            \
+  do {                                                              \
+    uint8_t* p = ccms__alloc_aligned(a, 10, 8);                     \
+    assert(p != NULL);                                              \
+    assert(_M_cast(uintptr_t, p) % 8 == 0);                         \
+    memcpy(p, "123456789", 10);                                     \
+                                                                    \
+    p = ccms__realloc_aligned(a, p, 10, 1000, 8);                   \
+    assert(p != NULL);                                              \
+    assert(strcmp(_M_cast(char*, p), "123456789") == 0);            \
+    memset(p + 10, 1, 990);                                         \
+                                                                    \
+    p = ccms__realloc_aligned(a, p, 1000, 20, 8);                   \
+    assert(strcmp(_M_cast(char*, p), "123456789") == 0);            \
+                                                                    \
+    ccms__dealloc(a, p, 20);                                        \
+    ccms__dealloc(a, NULL, 0);                                      \
+  } while (0)
+
+void test__ccms__alloc() {
+  // -- PREPARE
+  heap_t* heap = heap__new();
+  st_arena_t* st_arena = st_arena__new(KiB(4));
+  pg_arena_t* pg_arena = pg_arena__new(KiB(4));
+  dyn_arena_t* dyn_arena = dyn_arena__new();
+  vm_arena_t* vm_arena = vm_arena__new(MiB(1));
+  allocator_t runtime = allocator__st_arena(st_arena);
+
+  // -- TEST
+  check_generic(CCMS_MALLOC);
+  check_generic(heap);
+  check_generic(st_arena);
+  check_generic(pg_arena);
+  check_generic(dyn_arena);
+  check_generic(vm_arena);
+  check_generic(&runtime);
+
+  // the plain macros align to __CCMS__DEFAULT_ALIGN
+  uint8_t* a = ccms__alloc(pg_arena, 5);
+  assert(a != NULL);
+  assert(_M_cast(uintptr_t, a) % __CCMS__DEFAULT_ALIGN == 0);
+  a = ccms__realloc(pg_arena, a, 5, 50);
+  assert(a != NULL);
+  assert(_M_cast(uintptr_t, a) % __CCMS__DEFAULT_ALIGN == 0);
+  ccms__dealloc(pg_arena, a, 50);
+
+  a = ccms__alloc(CCMS_MALLOC, 5);
+  assert((a != NULL) == (__CCMS__DEFAULT_ALIGN <= _M_MAX_ALIGN));
+  ccms__dealloc(CCMS_MALLOC, a, 5);
+
+  // an arena takes back its last chunk
+  a = ccms__alloc(st_arena, 100);
+  ccms__dealloc(st_arena, a, 100);
+  assert(ccms__alloc(st_arena, 100) == a);
+
+  // _M_alloc and heap_t only support the alignment of max_align_t
+  assert(ccms__alloc_aligned(CCMS_MALLOC, 1, 2 * _M_MAX_ALIGN) == NULL);
+  assert(ccms__alloc_aligned(heap, 1, 2 * _M_MAX_ALIGN) == NULL);
+
+  // -- CLEANUP
+  heap__free(heap);
+  st_arena__free(st_arena);
+  pg_arena__free(pg_arena);
+  dyn_arena__free(dyn_arena);
+  vm_arena__free(vm_arena);
+}
+
+void test__ccms__allocator() {
+  // -- PREPARE
+  heap_t* heap = heap__new();
+  pg_arena_t* pg_arena = pg_arena__new(KiB(4));
+  dyn_arena_t* dyn_arena = dyn_arena__new();
+
+  // -- TEST
+  assert(ccms__allocator(CCMS_MALLOC).kind == ALLOCATOR_MALLOC);
+  assert(ccms__allocator(heap).kind == ALLOCATOR_HEAP);
+  assert(ccms__allocator(heap).ctx == heap);
+  assert(ccms__allocator(pg_arena).kind == ALLOCATOR_PG_ARENA);
+  assert(ccms__allocator(dyn_arena).kind == ALLOCATOR_DYN_ARENA);
+
+  allocator_t alloc = ccms__allocator(pg_arena);
+  allocator_t copy = ccms__allocator(&alloc);
+  assert(copy.kind == ALLOCATOR_PG_ARENA);
+  assert(copy.ctx == pg_arena);
+  check_allocator(copy);
+
+  // -- CLEANUP
+  heap__free(heap);
+  pg_arena__free(pg_arena);
+  dyn_arena__free(dyn_arena);
+}
+
+//
+//
+// ------------------ main ------------------
+//
+//
+
+int main() {
+  // -- allocator_t
+  test__allocator__kinds();
+  test__allocator__arena_tail();
+  test__allocator__align();
+
+  // -- static dispatch
+  test__ccms__alloc();
+  test__ccms__allocator();
+
+  return 0;
+}
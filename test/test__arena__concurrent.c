@@ -0,0 +1,213 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// do not move or delete this #undef, otherwise the test will always pass, as
+// assert is only defined in debug mode. This #undef forces assert to be defined
+#undef NDEBUG
+#include <assert.h>
+#include <pthread.h>
+#include <string.h>
+
+// Include the header file to test
+#include "ccms/arena/concurrent.h"
+
+// cst_arena__alloc only packs chunks back to back (through its own lock-free
+// path) with the default alignment of 1. The tests checking exact offsets pack
+// explicitly if __CCMS__DEFAULT_ALIGN is set to something else.
+#if __CCMS__DEFAULT_ALIGN == 1
+#define cst_arena__alloc_packed(arena, size) cst_arena__alloc(arena, size)
+#else
+#define cst_arena__alloc_packed(arena, size) \
+  cst_arena__alloc_aligned(arena, size, 1)
+#endif
+
+//
+//
+// ------------------ cst_arena_t ------------------
+//
+//
+
+void test__cst_arena__new_and_free() {
+  // -- TEST
+  cst_arena_t* arena = cst_arena__new(10);
+  assert(arena != NULL);
+  assert(arena->size == 10);
+  assert(atomic_load(&arena->offset) == 0);
+
+  // -- CLEANUP
+  cst_arena__free(arena);
+}
+
+void test__cst_arena__cap() {
+  // -- PREPARE
+  cst_arena_t* arena = cst_arena__new(10);
+
+  // -- TEST
+  assert(cst_arena__cap(arena) == 10);
+  cst_arena__alloc_packed(arena, 4);
+  assert(cst_arena__cap(arena) == 6);
+
+  // -- CLEANUP
+  cst_arena__free(arena);
+}
+
+void test__cst_arena__reset() {
+  // -- PREPARE
+  cst_arena_t* arena = cst_arena__new(10);
+  cst_arena__alloc_packed(arena, 5);
+
+  // -- TEST
+  cst_arena__reset(arena);
+  assert(cst_arena__cap(arena) == 10);
+
+  // -- CLEANUP
+  cst_arena__free(arena);
+}
+
+void test__cst_arena__alloc() {
+  // -- PREPARE
+  cst_arena_t* arena = cst_arena__new(10);
+
+  // -- TEST
+  uint8_t* a = cst_arena__alloc_packed(arena, 5);
+  uint8_t* b = cst_arena__alloc_packed(arena, 5);
+  assert(a != NULL && b == a + 5);
+  assert(cst_arena__cap(arena) == 0);
+
+  // a failed allocation does not move the offset past the end
+  assert(cst_arena__alloc(arena, 1) == NULL);
+  assert(atomic_load(&arena->offset) == 10);
+
+  // -- CLEANUP
+  cst_arena__free(arena);
+}
+
+void test__cst_arena__alloc_aligned() {
+  // -- PREPARE
+  cst_arena_t* arena = cst_arena__new(512);
+  cst_arena__alloc(arena, 3);
+
+  // -- TEST
+  for (size_t align = 1; align <= 64; align <<= 1) {
+    uint8_t* mem = cst_arena__alloc_aligned(arena, 3, align);
+    assert(mem != NULL);
+    assert(_M_cast(uintptr_t, mem) % align == 0);
+  }
+  assert(cst_arena__alloc_aligned(arena, 1, 12) == NULL);
+
+  // plain allocations are aligned to __CCMS__DEFAULT_ALIGN
+  uint8_t* mem = cst_arena__alloc(arena, 3);
+  assert(mem != NULL);
+  assert(_M_cast(uintptr_t, mem) % __CCMS__DEFAULT_ALIGN == 0);
+
+  // -- CLEANUP
+  cst_arena__free(arena);
+}
+
+#define STRESS_THREADS 8
+#define STRESS_CHUNK 16
+#define STRESS_CHUNKS 100000
+
+typedef struct {
+  cst_arena_t* arena;
+  uint8_t id;
+  size_t count;
+  int aligned;
+} stress_t;
+
+static void* stress_worker(void* arg) {
+  stress_t* ctx = _M_cast(stress_t*, arg);
+
+  for (;;) {
+    uint8_t* chunk =
+        ctx->aligned
+            ? cst_arena__alloc_aligned(ctx->arena, STRESS_CHUNK, STRESS_CHUNK)
+            : cst_arena__alloc_packed(ctx->arena, STRESS_CHUNK);
+    if (chunk == NULL) break;
+
+    memset(chunk, ctx->id, STRESS_CHUNK);
+    ctx->count++;
+  }
+
+  return NULL;
+}
+
+static void stress(const int aligned) {
+  // -- PREPARE
+  cst_arena_t* arena = cst_arena__new(STRESS_CHUNK * STRESS_CHUNKS);
+  pthread_t threads[STRESS_THREADS];
+  stress_t ctx[STRESS_THREADS];
+  size_t per_thread[STRESS_THREADS] = {0};
+
+  // -- TEST
+  for (size_t i = 0; i < STRESS_THREADS; i++) {
+    ctx[i] = (stress_t){.arena = arena, .id = i + 1, .aligned = aligned};
+    pthread_create(&threads[i], NULL, stress_worker, &ctx[i]);
+  }
+  for (size_t i = 0; i < STRESS_THREADS; i++)
+    pthread_join(threads[i], NULL);
+
+  // every byte of the arena was handed out exactly once ...
+  size_t total = 0;
+  for (size_t i = 0; i < STRESS_THREADS; i++)
+    total += ctx[i].count;
+  assert(total == STRESS_CHUNKS);
+
+  // ... and no chunk was handed out twice (it would carry a mixed id)
+  uint8_t* data = _cst_arena__data(arena);
+  for (size_t c = 0; c < STRESS_CHUNKS; c++) {
+    const uint8_t id = data[c * STRESS_CHUNK];
+    assert(id >= 1 && id <= STRESS_THREADS);
+    for (size_t j = 1; j < STRESS_CHUNK; j++)
+      assert(data[c * STRESS_CHUNK + j] == id);
+    per_thread[id - 1]++;
+  }
+  for (size_t i = 0; i < STRESS_THREADS; i++)
+    assert(per_thread[i] == ctx[i].count);
+
+  // -- CLEANUP
+  cst_arena__free(arena);
+}
+
+void test__cst_arena__alloc_stress() {
+  stress(0);
+}
+
+void test__cst_arena__alloc_aligned_stress() {
+  stress(1);
+}
+
+//
+//
+// ------------------ main ------------------
+//
+//
+
+int main() {
+  // -- cst_arena_t
+  test__cst_arena__new_and_free();
+  test__cst_arena__cap();
+  test__cst_arena__reset();
+  test__cst_arena__alloc();
+  test__cst_arena__alloc_aligned();
+  test__cst_arena__alloc_stress();
+  test__cst_arena__alloc_aligned_stress();
+
+  return 0;
+}
@@ -69,6 +69,9 @@ void test__dyn_arena__new() {
   assert(arena != NULL);
   assert(arena->head == NULL);
   assert(arena->tail == NULL);
+  assert(arena->chunks == NULL);
+  assert(arena->chunk_size == __CCMS__DYN_ARENA_CHUNK_SIZE);
+  assert(arena->threshold == __CCMS__DYN_ARENA_THRESHOLD);
 
   // -- CLEANUP
   dyn_arena__free(arena);
@@ -78,10 +81,15 @@ void test__dyn_arena__reset() {
   // -- PREPARE
   dyn_arena_t* arena = dyn_arena__new();
 
+  dyn_arena__alloc(arena, 10);
+  dyn_arena__alloc(arena, KiB(64));
+
   // -- TEST
+  // frees everything, including the chunks
   dyn_arena__reset(arena);
   assert(arena->head == NULL);
   assert(arena->tail == NULL);
+  assert(arena->chunks == NULL && arena->chunk == NULL);
 
   // -- CLEANUP
   dyn_arena__free(arena);
@@ -99,6 +107,102 @@ void test__dyn_arena__alloc() {
   dyn_arena__free(arena);
 }
 
+void test__dyn_arena__alloc_chunked() {
+  // -- PREPARE
+  // room for several requests at a raised __CCMS__DEFAULT_ALIGN as well
+  dyn_arena_t* arena = dyn_arena__new_chunked(256, 16);
+
+  // -- TEST
+  // small requests are carved from one chunk ...
+  uint8_t* a = dyn_arena__alloc(arena, 10);
+  uint8_t* b = dyn_arena__alloc(arena, 16);
+  assert(b == a + _M_align_up(10, __CCMS__DEFAULT_ALIGN));
+  assert(arena->chunks != NULL && arena->chunk == arena->chunks);
+  assert(arena->head == NULL);
+
+  // ... until it is full
+  uint8_t* c = b;
+  while (arena->chunk == arena->chunks) {
+    assert(c != NULL);
+    c = dyn_arena__alloc(arena, 16);
+  }
+  assert(arena->chunk == arena->chunks->next);
+  assert(c + 16 == _dyn_arena_chunk__data(arena->chunk) + arena->chunk->pos);
+  assert(arena->chunks->size - arena->chunks->pos <
+         _M_align_up(16, __CCMS__DEFAULT_ALIGN));
+
+  // requests above the threshold get a block of their own
+  uint8_t* big = dyn_arena__alloc(arena, 17);
+  assert(big != NULL);
+  assert(arena->head != NULL && arena->head == arena->tail);
+  assert(arena->head->size >= 17);
+
+  // -- CLEANUP
+  dyn_arena__free(arena);
+}
+
+void test__dyn_arena__soft_reset() {
+  // -- PREPARE
+  // counts whole 16 byte chunks, so no padding from __CCMS__DEFAULT_ALIGN
+  dyn_arena_t* arena = dyn_arena__new_chunked(64, 16);
+  uint8_t* first = dyn_arena__alloc_aligned(arena, 16, 1);
+  for (size_t i = 0; i < 8; i++)
+    dyn_arena__alloc_aligned(arena, 16, 1);
+  dyn_arena__alloc_aligned(arena, 32, 1);
+  _dyn_arena_chunk_t* second = arena->chunks->next;
+
+  // -- TEST
+  dyn_arena__soft_reset(arena);
+  assert(arena->head == NULL);
+  assert(arena->chunk == arena->chunks);
+  assert(arena->chunks->pos == 0);
+  assert(dyn_arena__alloc_aligned(arena, 16, 1) == first);
+
+  // later chunks are reused (and reset) once allocation reaches them
+  for (size_t i = 0; i < 4; i++)
+    dyn_arena__alloc_aligned(arena, 16, 1);
+  assert(arena->chunk == second);
+  assert(second->pos == 16);
+
+  dyn_arena__reset(arena);
+  assert(arena->chunks == NULL && arena->chunk == NULL);
+
+  // -- CLEANUP
+  dyn_arena__free(arena);
+}
+
+void test__dyn_arena__alloc_unchunked() {
+  // -- PREPARE
+  dyn_arena_t* arena = dyn_arena__new_chunked(64, 0);
+
+  // -- TEST
+  dyn_arena__alloc(arena, 1);
+  dyn_arena__alloc(arena, 1);
+  assert(arena->chunks == NULL);
+  assert(arena->head != NULL && arena->head->next == arena->tail);
+
+  // -- CLEANUP
+  dyn_arena__free(arena);
+}
+
+void test__dyn_arena__alloc_aligned() {
+  // -- PREPARE
+  dyn_arena_t* arena = dyn_arena__new();
+
+  // -- TEST
+  for (size_t align = 1; align <= 256; align <<= 1) {
+    uint8_t* memory = dyn_arena__alloc_aligned(arena, 3, align);
+    assert(memory != NULL);
+    assert(_M_cast(uintptr_t, memory) % align == 0);
+  }
+
+  // alignment must be a power of two
+  assert(dyn_arena__alloc_aligned(arena, 1, 6) == NULL);
+
+  // -- CLEANUP
+  dyn_arena__free(arena);
+}
+
 //
 //
 // ------------------ main ------------------
@@ -114,6 +218,10 @@ int main() {
   test__dyn_arena__new();
   test__dyn_arena__reset();
   test__dyn_arena__alloc();
+  test__dyn_arena__alloc_chunked();
+  test__dyn_arena__soft_reset();
+  test__dyn_arena__alloc_unchunked();
+  test__dyn_arena__alloc_aligned();
 
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,207 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// do not move or delete this #undef, otherwise the test will always pass, as
+// assert is only defined in debug mode. This #undef forces assert to be defined
+#undef NDEBUG
+#include <assert.h>
+#include <pthread.h>
+#include <string.h>
+
+// Include the header file to test
+#include "ccms/arena/page_pool.h"
+#include "ccms/arena/paged.h"
+
+//
+//
+// ------------------ pg_pool_t ------------------
+//
+//
+
+void test__pg_pool__new() {
+  // -- TEST
+  pg_pool_t* pool = pg_pool__new(64, 4);
+  assert(pool != NULL);
+  assert(pool->block_size == 64);
+  assert(pool->capacity == 4);
+  assert(atomic_load(&pool->count) == 0);
+
+  // -- CLEANUP
+  pg_pool__free(pool);
+}
+
+void test__pg_pool__acquire_release() {
+  // -- PREPARE
+  pg_pool_t* pool = pg_pool__new(64, 4);
+
+  // -- TEST
+  uint8_t* a = pg_pool__acquire(pool);
+  uint8_t* b = pg_pool__acquire(pool);
+  assert(a != NULL && b != NULL && a != b);
+  assert(_M_cast(uintptr_t, a) % _M_MAX_ALIGN == 0);
+  assert(atomic_load(&pool->count) == 2);
+  memset(a, 0xAA, 64);
+  memset(b, 0xBB, 64);
+
+  // released blocks are handed out again (LIFO) instead of growing the pool
+  pg_pool__release(pool, a);
+  pg_pool__release(pool, b);
+  assert(pg_pool__acquire(pool) == b);
+  assert(pg_pool__acquire(pool) == a);
+  assert(atomic_load(&pool->count) == 2);
+
+  pg_pool__release(pool, a);
+  pg_pool__release(pool, b);
+
+  // -- CLEANUP
+  pg_pool__free(pool);
+}
+
+void test__pg_pool__over_capacity() {
+  // -- PREPARE
+  pg_pool_t* pool = pg_pool__new(16, 2);
+  uint8_t* blocks[4];
+
+  // -- TEST
+  for (size_t i = 0; i < 4; i++)
+    blocks[i] = pg_pool__acquire(pool);
+  assert(atomic_load(&pool->count) <= 3);
+
+  // blocks beyond the capacity are not tracked and go straight back to _M_free
+  for (size_t i = 0; i < 4; i++)
+    pg_pool__release(pool, blocks[i]);
+
+  uint8_t* again0 = pg_pool__acquire(pool);
+  uint8_t* again1 = pg_pool__acquire(pool);
+  assert((again0 == blocks[0] || again0 == blocks[1]) &&
+         (again1 == blocks[0] || again1 == blocks[1]));
+
+  // -- CLEANUP
+  pg_pool__free(pool);
+}
+
+#define POOL_THREADS 4
+#define POOL_ROUNDS 10000
+
+static void* pool_worker(void* arg) {
+  pg_pool_t* pool = _M_cast(pg_pool_t*, arg);
+  uint8_t* held[8];
+
+  for (size_t round = 0; round < POOL_ROUNDS; round++) {
+    for (size_t i = 0; i < 8; i++) {
+      held[i] = pg_pool__acquire(pool);
+      // stamp the block, nobody else may touch it while we hold it
+      memset(held[i], _M_cast(int, i), pool->block_size);
+    }
+    for (size_t i = 0; i < 8; i++) {
+      for (size_t j = 0; j < pool->block_size; j++)
+        assert(held[i][j] == i);
+      pg_pool__release(pool, held[i]);
+    }
+  }
+
+  return NULL;
+}
+
+void test__pg_pool__concurrent() {
+  // -- PREPARE
+  pg_pool_t* pool = pg_pool__new(32, 64);
+  pthread_t threads[POOL_THREADS];
+
+  // -- TEST
+  for (size_t i = 0; i < POOL_THREADS; i++)
+    pthread_create(&threads[i], NULL, pool_worker, pool);
+  for (size_t i = 0; i < POOL_THREADS; i++)
+    pthread_join(threads[i], NULL);
+
+  assert(atomic_load(&pool->count) <= 8 * POOL_THREADS);
+
+  // -- CLEANUP
+  pg_pool__free(pool);
+}
+
+//
+//
+// ------------------ pg_arena_t (pooled) ------------------
+//
+//
+
+void test__pg_arena__new_pooled() {
+  // -- PREPARE
+  pg_pool_t* pool = pg_arena__new_pool(128, 8);
+
+  // -- TEST
+  pg_arena_t* arena = pg_arena__new_pooled(pool);
+  assert(arena != NULL);
+  assert(arena->pool == pool);
+  assert(arena->page_size == 128);
+  assert(arena->head != NULL);
+  assert(arena->head == arena->tail);
+  assert(atomic_load(&pool->count) == 1);
+
+  // -- CLEANUP
+  pg_arena__free(arena);
+  pg_pool__free(pool);
+}
+
+void test__pg_arena__pooled_pages_are_recycled() {
+  // -- PREPARE
+  pg_pool_t* pool = pg_arena__new_pool(128, 8);
+  pg_arena_t* arena = pg_arena__new_pooled(pool);
+
+  // -- TEST
+  // one page each, whatever __CCMS__DEFAULT_ALIGN is
+  for (size_t i = 0; i < 4; i++)
+    assert(pg_arena__alloc_aligned(arena, 100, 1) != NULL);
+  assert(atomic_load(&pool->count) == 4);
+
+  // pages released by one arena are picked up by the next one
+  pg_arena__hard_reset(arena);
+  pg_arena_t* other = pg_arena__new_pooled(pool);
+  for (size_t i = 0; i < 3; i++)
+    assert(pg_arena__alloc_aligned(other, 100, 1) != NULL);
+  assert(atomic_load(&pool->count) == 4);
+
+  pg_arena__free(other);
+  pg_arena__free(arena);
+  assert(atomic_load(&pool->count) == 4);
+
+  // -- CLEANUP
+  pg_pool__free(pool);
+}
+
+//
+//
+// ------------------ main ------------------
+//
+//
+
+int main() {
+  // -- pg_pool_t
+  test__pg_pool__new();
+  test__pg_pool__acquire_release();
+  test__pg_pool__over_capacity();
+  test__pg_pool__concurrent();
+
+  // -- pg_arena_t (pooled)
+  test__pg_arena__new_pooled();
+  test__pg_arena__pooled_pages_are_recycled();
+
+  return 0;
+}
@@ -21,10 +21,20 @@
 // assert is only defined in debug mode. This #undef forces assert to be defined
 #undef NDEBUG
 #include <assert.h>
+#include <string.h>
 
 // Include the header file to test
 #include "ccms/arena/paged.h"
 
+// Most tests fill tiny pages byte by byte, which needs chunks packed back to
+// back. pg_arena__alloc only does that with the default alignment of 1.
+#if __CCMS__DEFAULT_ALIGN == 1
+#define pg_arena__alloc_packed(arena, size) pg_arena__alloc(arena, size)
+#else
+#define pg_arena__alloc_packed(arena, size) \
+  pg_arena__alloc_aligned(arena, size, 1)
+#endif
+
 //
 //
 // ------------------ _pg_arena_page_t ------------------
@@ -36,6 +46,7 @@ void test___pg_arena_page__new() {
   _pg_arena_page_t* page = _pg_arena_page__new(10, NULL);
   assert(page != NULL);
   assert(page->pos == 0);
+  assert(page->size == 10);
   assert(page->next == NULL);
 
   // -- CLEANUP
@@ -76,7 +87,7 @@ void test__pg_arena__new() {
 void test__pg_arena__reset() {
   // -- PREPARE
   pg_arena_t* arena = pg_arena__new(10);
-  uint8_t* chunk = pg_arena__alloc(arena, 5);
+  uint8_t* chunk = pg_arena__alloc_packed(arena, 5);
 
   // -- TEST
   pg_arena__reset(arena);
@@ -92,7 +103,7 @@ void test__pg_arena__reset() {
 void test__pg_arena__hard_reset() {
   // -- PREPARE
   pg_arena_t* arena = pg_arena__new(10);
-  uint8_t* chunk = pg_arena__alloc(arena, 5);
+  uint8_t* chunk = pg_arena__alloc_packed(arena, 5);
 
   // -- TEST
   pg_arena__hard_reset(arena);
@@ -108,11 +119,279 @@ void test__pg_arena__hard_reset() {
 
 void test__pg_arena__alloc() {
   // -- PREPARE
-  pg_arena_t* arena = pg_arena__new(10);
+  pg_arena_t* arena = pg_arena__new(256);
 
   // -- TEST
   uint8_t* chunk = pg_arena__alloc(arena, 5);
   assert(chunk != NULL);
+  assert(_M_cast(uintptr_t, chunk) % __CCMS__DEFAULT_ALIGN == 0);
+
+  // consecutive chunks are __CCMS__DEFAULT_ALIGN apart
+  assert(pg_arena__alloc(arena, 5) ==
+         chunk + _M_align_up(5, __CCMS__DEFAULT_ALIGN));
+
+  // -- CLEANUP
+  pg_arena__free(arena);
+}
+
+void test__pg_arena__alloc_aligned() {
+  // -- PREPARE
+  pg_arena_t* arena = pg_arena__new(128);
+  assert(_PG_ARENA_PAGE_HEADER_SIZE % _M_MAX_ALIGN == 0);
+
+  // -- TEST
+  // odd sized chunks followed by aligned ones, spilling over several pages
+  for (size_t i = 0; i < 32; i++) {
+    assert(pg_arena__alloc_packed(arena, 3) != NULL);
+
+    uint8_t* chunk = pg_arena__alloc_aligned(arena, 24, 32);
+    assert(chunk != NULL);
+    assert(_M_cast(uintptr_t, chunk) % 32 == 0);
+    assert(chunk + 24 <= _pg_arena_page__data(arena->tail) + arena->page_size);
+  }
+  assert(arena->tail != arena->head);
+
+  // after a reset the already allocated pages are reused with the same result
+  pg_arena__reset(arena);
+  for (size_t i = 0; i < 32; i++) {
+    uint8_t* chunk = pg_arena__alloc_aligned(arena, 40, 64);
+    assert(chunk != NULL);
+    assert(_M_cast(uintptr_t, chunk) % 64 == 0);
+  }
+
+  // alignment must be a power of two
+  assert(pg_arena__alloc_aligned(arena, 1, 3) == NULL);
+
+  // -- CLEANUP
+  pg_arena__free(arena);
+}
+
+void test__pg_arena__alloc_large() {
+  // -- PREPARE
+  pg_arena_t* arena = pg_arena__new(16);
+  _pg_arena_page_t* tail = arena->tail;
+
+  // -- TEST
+  // chunks larger than a page get a block of their own ...
+  uint8_t* big = pg_arena__alloc_packed(arena, 100);
+  assert(big != NULL);
+  memset(big, 1, 100);
+  assert(arena->large != NULL);
+  assert(arena->large->size >= 100);
+  // ... which leaves the pages alone
+  assert(arena->tail == tail);
+  assert(arena->tail->pos == 0);
+
+  // so do chunks that fit, but not once they are aligned
+  uint8_t* aligned = pg_arena__alloc_aligned(arena, 16, 64);
+  assert(aligned != NULL);
+  assert(_M_cast(uintptr_t, aligned) % 64 == 0);
+  assert(arena->large->next != NULL);
+
+  // by default large blocks are freed on reset
+  pg_arena__reset(arena);
+  assert(arena->large == NULL);
+  assert(arena->large_free == NULL);
+
+  // -- CLEANUP
+  pg_arena__free(arena);
+}
+
+void test__pg_arena__keep_large() {
+  // -- PREPARE
+  pg_arena_t* arena = pg_arena__new(16);
+  pg_arena__set_keep_large(arena, 1);
+  uint8_t* big = pg_arena__alloc_packed(arena, 100);
+  pg_arena__alloc_packed(arena, 20);
+
+  // -- TEST
+  pg_arena__reset(arena);
+  assert(arena->large == NULL);
+  assert(arena->large_free != NULL);
+  assert(arena->large_free->next != NULL);
+
+  // a kept block that is large enough is reused
+  assert(pg_arena__alloc_packed(arena, 90) == big);
+  assert(arena->large != NULL);
+
+  pg_arena__hard_reset(arena);
+  assert(arena->large == NULL);
+  assert(arena->large_free == NULL);
+
+  // -- CLEANUP
+  pg_arena__free(arena);
+}
+
+void test__pg_arena__reset_lazy() {
+  // -- PREPARE
+  pg_arena_t* arena = pg_arena__new(10);
+  for (size_t i = 0; i < 4; i++)
+    pg_arena__alloc_packed(arena, 8);
+  _pg_arena_page_t* second = arena->head->next;
+
+  // -- TEST
+  // only the first page is touched by the reset ...
+  pg_arena__reset(arena);
+  assert(arena->tail == arena->head);
+  assert(arena->head->pos == 0);
+  assert(second->pos == 8);
+  assert(pg_arena__avg_util(arena) == 0.f);
+
+  // ... the others are reset once the tail reaches them
+  pg_arena__alloc_packed(arena, 8);
+  uint8_t* chunk = pg_arena__alloc_packed(arena, 3);
+  assert(arena->tail == second);
+  assert(second->pos == 3);
+  assert(chunk == _pg_arena_page__data(second));
+  assert(arena->npages == 4);
+
+  // -- CLEANUP
+  pg_arena__free(arena);
+}
+
+void test__pg_arena__growth_double() {
+  // -- PREPARE
+  pg_arena_t* arena = pg_arena__new(16);
+  pg_arena__set_growth(arena, PG_ARENA_GROWTH_DOUBLE, 64);
+
+  // -- TEST
+  // 15 chunks fill pages of 16 + 32 + 64 + 64 + 64 bytes
+  for (size_t i = 0; i < 15; i++)
+    pg_arena__alloc_packed(arena, 16);
+
+  size_t expected[] = {16, 32, 64, 64, 64};
+  size_t i = 0;
+  for (_pg_arena_page_t* itr = arena->head; itr != NULL; itr = itr->next, i++)
+    assert(itr->size == expected[i]);
+  assert(i == 5);
+  assert(arena->npages == 5);
+
+  // chunks above the first page size still go to large blocks
+  pg_arena__alloc_packed(arena, 17);
+  assert(arena->large != NULL);
+
+  pg_arena__hard_reset(arena);
+  assert(arena->npages == 1);
+
+  // -- CLEANUP
+  pg_arena__free(arena);
+}
+
+static size_t grow_triple(void* ctx, size_t npages, size_t last_page_size) {
+  *_M_cast(size_t*, ctx) = npages;
+  return last_page_size * 3;
+}
+
+void test__pg_arena__growth_custom() {
+  // -- PREPARE
+  pg_arena_t* arena = pg_arena__new(16);
+  size_t npages = 0;
+  pg_arena__set_grow_fn(arena, grow_triple, &npages);
+
+  // -- TEST
+  pg_arena__alloc_packed(arena, 16);
+  pg_arena__alloc_packed(arena, 16);
+  assert(arena->tail->size == 48);
+  assert(npages == 1);
+  for (size_t i = 0; i < 3; i++)
+    pg_arena__alloc_packed(arena, 16);
+  assert(arena->tail->size == 144);
+  assert(npages == 2);
+
+  // -- CLEANUP
+  pg_arena__free(arena);
+}
+
+void test__pg_arena__growth_custom_without_fn() {
+  // -- PREPARE
+  pg_arena_t* arena = pg_arena__new(16);
+
+  // -- TEST
+  // custom growth needs a grow function, the arena keeps growing as before
+  pg_arena__set_growth(arena, PG_ARENA_GROWTH_CUSTOM, 64);
+  assert(arena->growth == PG_ARENA_GROWTH_FIXED);
+  pg_arena__set_grow_fn(arena, NULL, NULL);
+  assert(arena->growth == PG_ARENA_GROWTH_FIXED);
+  pg_arena__alloc_packed(arena, 16);
+  pg_arena__alloc_packed(arena, 16);
+  assert(arena->tail->size == 16);
+
+  // but can be switched back to once there is one
+  pg_arena__set_grow_fn(arena, grow_triple, NULL);
+  pg_arena__set_growth(arena, PG_ARENA_GROWTH_FIXED, 16);
+  pg_arena__set_growth(arena, PG_ARENA_GROWTH_CUSTOM, 16);
+  assert(arena->growth == PG_ARENA_GROWTH_CUSTOM);
+
+  // -- CLEANUP
+  pg_arena__free(arena);
+}
+
+void test__pg_arena__mark_and_rewind() {
+  // -- PREPARE
+  pg_arena_t* arena = pg_arena__new(16);
+  pg_arena__alloc_packed(arena, 10);
+
+  // -- TEST
+  pg_arena_mark_t mark = pg_arena__mark(arena);
+  uint8_t* first = pg_arena__alloc_packed(arena, 4);
+  for (size_t i = 0; i < 8; i++)
+    pg_arena__alloc_packed(arena, 12);
+  pg_arena__alloc_packed(arena, 100);
+  assert(arena->tail != arena->head);
+  assert(arena->large != NULL);
+
+  // back on the first page, the large block is gone, pages are kept
+  pg_arena__rewind(arena, mark);
+  assert(arena->tail == arena->head);
+  assert(arena->head->pos == 10);
+  assert(arena->large == NULL);
+  assert(arena->npages == 9);
+  assert(pg_arena__alloc_packed(arena, 4) == first);
+
+  // pages behind the mark are reused from the start
+  pg_arena__alloc_packed(arena, 12);
+  assert(arena->tail == arena->head->next);
+  assert(arena->tail->pos == 12);
+
+  // -- CLEANUP
+  pg_arena__free(arena);
+}
+
+void test__pg_arena__rewind_keep_large() {
+  // -- PREPARE
+  pg_arena_t* arena = pg_arena__new(16);
+  pg_arena__set_keep_large(arena, 1);
+  pg_arena__alloc_packed(arena, 100);
+
+  // -- TEST
+  pg_arena_mark_t mark = pg_arena__mark(arena);
+  uint8_t* big = pg_arena__alloc_packed(arena, 200);
+  pg_arena__rewind(arena, mark);
+  assert(arena->large != NULL && arena->large->next == NULL);
+  assert(arena->large_free != NULL);
+  assert(pg_arena__alloc_packed(arena, 150) == big);
+
+  // -- CLEANUP
+  pg_arena__free(arena);
+}
+
+void test__pg_arena__scope() {
+  // -- PREPARE
+  pg_arena_t* arena = pg_arena__new(16);
+  pg_arena__alloc_packed(arena, 4);
+
+  // -- TEST
+  pg_arena__scope(arena) {
+    for (size_t i = 0; i < 4; i++)
+      pg_arena__alloc_packed(arena, 16);
+    pg_arena__scope(arena) {
+      pg_arena__alloc_packed(arena, 8);
+      assert(arena->tail->pos == 8);
+    }
+    assert(arena->tail->pos == 16);
+  }
+  assert(arena->tail == arena->head);
+  assert(arena->head->pos == 4);
 
   // -- CLEANUP
   pg_arena__free(arena);
@@ -121,7 +400,7 @@ void test__pg_arena__alloc() {
 void test__pg_arena__avg_util() {
   // -- PREPARE
   pg_arena_t* arena = pg_arena__new(10);
-  uint8_t* chunk = pg_arena__alloc(arena, 5);
+  uint8_t* chunk = pg_arena__alloc_packed(arena, 5);
 
   // -- TEST
   float avg_util = pg_arena__avg_util(arena);
@@ -131,6 +410,226 @@ void test__pg_arena__avg_util() {
   pg_arena__free(arena);
 }
 
+void test__pg_arena__realloc() {
+  // -- PREPARE
+  // the page boundaries below assume unpadded chunks, so this asks for an
+  // alignment of 1 instead of __CCMS__DEFAULT_ALIGN
+  pg_arena_t* arena = pg_arena__new(100);
+
+  // -- TEST
+  uint8_t* a = pg_arena__realloc_aligned(arena, NULL, 0, 10, 1);
+  memset(a, 1, 10);
+
+  // the last chunk grows and shrinks in place while the page has room
+  assert(pg_arena__realloc_aligned(arena, a, 10, 60, 1) == a);
+  assert(arena->tail->pos == 60);
+  assert(pg_arena__realloc_aligned(arena, a, 60, 30, 1) == a);
+  assert(arena->tail->pos == 30);
+  assert(pg_arena__realloc_aligned(arena, a, 30, 100, 1) == a);
+  assert(arena->tail->pos == 100);
+  pg_arena__shrink(arena, a, 100, 10);
+  assert(arena->tail->pos == 10);
+
+  // without room it moves on to the next page
+  uint8_t* x = pg_arena__alloc_aligned(arena, 50, 1);
+  memset(x, 1, 50);
+  uint8_t* b = pg_arena__realloc_aligned(arena, x, 50, 95, 1);
+  assert(b != x);
+  assert(arena->tail == arena->head->next);
+  assert(b[0] == 1 && b[49] == 1);
+
+  // chunks that are not the last one are copied
+  uint8_t* c = pg_arena__alloc_aligned(arena, 2, 1);
+  uint8_t* d = pg_arena__realloc_aligned(arena, b, 95, 500, 1);
+  assert(d != b && d[0] == 1 && d[9] == 1);
+  pg_arena__shrink(arena, b, 95, 10);
+  assert(arena->tail->pos == 97);
+  pg_arena__shrink(arena, c, 2, 1);
+  assert(arena->tail->pos == 96);
+
+  // -- CLEANUP
+  pg_arena__free(arena);
+}
+
+void test__pg_arena__new_huge() {
+  // -- TEST
+  pg_arena_t* arena = pg_arena__new_huge(MiB(2));
+  assert(arena != NULL);
+  assert(arena->page_size == MiB(2) - _PG_ARENA_PAGE_HEADER_SIZE);
+  assert(arena->head->huge);
+  assert(_M_cast(uintptr_t, arena->head) % __CCMS__HUGE_PAGE_SIZE == 0);
+
+  // fills the first page exactly, then moves on to a second one
+  uint8_t* a = pg_arena__alloc_packed(arena, arena->page_size);
+  assert(a == _pg_arena_page__data(arena->head));
+  memset(a, 1, arena->page_size);
+  uint8_t* b = pg_arena__alloc_packed(arena, 64);
+  assert(arena->npages == 2);
+  assert(b == _pg_arena_page__data(arena->head->next));
+  assert(_M_cast(uintptr_t, arena->head->next) % __CCMS__HUGE_PAGE_SIZE == 0);
+
+  // grown pages fill their huge pages as well
+  pg_arena__set_growth(arena, PG_ARENA_GROWTH_DOUBLE, MiB(8));
+  pg_arena__alloc_packed(arena, arena->page_size);
+  assert(arena->npages == 3);
+  assert((arena->tail->size + _PG_ARENA_PAGE_HEADER_SIZE) %
+             __CCMS__HUGE_PAGE_SIZE ==
+         0);
+
+  // large chunks still come from _M_alloc
+  assert(pg_arena__alloc_packed(arena, MiB(16)) != NULL);
+
+  pg_arena__hard_reset(arena);
+  assert(arena->npages == 1);
+
+  // -- CLEANUP
+  pg_arena__free(arena);
+}
+
+// Fills exactly `n` pages of an arena with fixed page sizes
+static void use_pages(pg_arena_t* arena, const size_t n) {
+  for (size_t i = 0; i < n; i++)
+    pg_arena__alloc_packed(arena, arena->page_size);
+}
+
+void test__pg_arena__retention() {
+  // -- PREPARE
+  pg_arena_t* arena = pg_arena__new(64);
+  pg_arena__set_retention(arena, 2, 0, PG_ARENA_TRIM_FREE);
+
+  // -- TEST
+  // a spike is retained right away
+  use_pages(arena, 8);
+  assert(arena->nused == 8);
+  pg_arena__reset(arena);
+  assert(arena->npages == 8);
+  assert(arena->nused == 1);
+
+  // and decays by half of the distance at every reset
+  use_pages(arena, 1);
+  pg_arena__reset(arena);
+  assert(arena->npages == 5);
+  use_pages(arena, 1);
+  pg_arena__reset(arena);
+  assert(arena->npages == 3);
+  use_pages(arena, 1);
+  pg_arena__reset(arena);
+  assert(arena->npages == 2);
+
+  for (size_t i = 0; i < 20; i++) {
+    use_pages(arena, 1);
+    pg_arena__reset(arena);
+  }
+  assert(arena->npages == 1);
+  assert(arena->head->next == NULL);
+
+  // in a steady state the same pages are reused
+  use_pages(arena, 3);
+  pg_arena__reset(arena);
+  _pg_arena_page_t* second = arena->head->next;
+  for (size_t i = 0; i < 10; i++) {
+    use_pages(arena, 3);
+    assert(arena->head->next == second);
+    assert(arena->npages == 3);
+    pg_arena__reset(arena);
+  }
+
+  // with a mark, the pages used are rewound as well
+  pg_arena_mark_t mark = pg_arena__mark(arena);
+  use_pages(arena, 3);
+  pg_arena__rewind(arena, mark);
+  assert(arena->nused == 1);
+
+  // -- CLEANUP
+  pg_arena__free(arena);
+}
+
+void test__pg_arena__retention_min_pages() {
+  // -- PREPARE
+  pg_arena_t* arena = pg_arena__new(64);
+  pg_arena__set_retention(arena, 1, 3, PG_ARENA_TRIM_FREE);
+
+  // -- TEST
+  use_pages(arena, 6);
+  pg_arena__reset(arena);
+  assert(arena->npages == 6);
+
+  // a decay of 1 follows the pages in use right away, down to min_pages
+  pg_arena__reset(arena);
+  assert(arena->npages == 3);
+  pg_arena__reset(arena);
+  assert(arena->npages == 3);
+
+  pg_arena__hard_reset(arena);
+  assert(arena->npages == 1);
+  assert(arena->nused == 1);
+
+  // -- CLEANUP
+  pg_arena__free(arena);
+}
+
+void test__pg_arena__retention_hard_reset() {
+  // -- PREPARE
+  pg_arena_t* arena = pg_arena__new(64);
+  pg_arena__set_retention(arena, 2, 0, PG_ARENA_TRIM_FREE);
+  use_pages(arena, 8);
+  pg_arena__reset(arena);
+  assert(arena->npages == 8);
+
+  // -- TEST
+  // the spike before the hard reset is forgotten
+  pg_arena__hard_reset(arena);
+  assert(arena->npages == 1);
+  assert(arena->hwm == 0);
+
+  use_pages(arena, 4);
+  pg_arena__reset(arena);
+  assert(arena->npages == 4);
+  use_pages(arena, 1);
+  pg_arena__reset(arena);
+  assert(arena->npages == 3);
+
+  // -- CLEANUP
+  pg_arena__free(arena);
+}
+
+#ifdef __CCMS__HAS_VMEM
+void test__pg_arena__retention_purge() {
+  // -- PREPARE
+  pg_arena_t* arena = pg_arena__new(KiB(64));
+  pg_arena__set_retention(arena, 1, 0, PG_ARENA_TRIM_PURGE);
+
+  // -- TEST
+  use_pages(arena, 4);
+  uint8_t* last = _pg_arena_page__data(arena->tail);
+  memset(last, 0xAB, arena->page_size);
+  pg_arena__reset(arena);
+  assert(arena->npages == 4);
+  pg_arena__reset(arena);
+
+  // purged pages stay in the arena
+  assert(arena->npages == 4);
+  assert(arena->nkept == 1);
+#ifdef __linux__
+  // and read back as zero, as far as they cover whole OS pages
+  assert(last[KiB(32)] == 0);
+#endif
+
+  // nothing left to purge
+  pg_arena__reset(arena);
+  assert(arena->nkept == 1);
+
+  // and are backed by memory again once they are used
+  use_pages(arena, 4);
+  assert(_pg_arena_page__data(arena->tail) == last);
+  memset(last, 0xCD, arena->page_size);
+  assert(last[KiB(32)] == 0xCD);
+
+  // -- CLEANUP
+  pg_arena__free(arena);
+}
+#endif
+
 //
 //
 // ------------------ main ------------------
@@ -147,7 +646,25 @@ int main() {
   test__pg_arena__reset();
   test__pg_arena__hard_reset();
   test__pg_arena__alloc();
+  test__pg_arena__alloc_aligned();
+  test__pg_arena__alloc_large();
+  test__pg_arena__realloc();
+  test__pg_arena__keep_large();
+  test__pg_arena__reset_lazy();
+  test__pg_arena__growth_double();
+  test__pg_arena__growth_custom();
+  test__pg_arena__growth_custom_without_fn();
+  test__pg_arena__mark_and_rewind();
+  test__pg_arena__rewind_keep_large();
+  test__pg_arena__scope();
   test__pg_arena__avg_util();
+  test__pg_arena__new_huge();
+  test__pg_arena__retention();
+  test__pg_arena__retention_min_pages();
+  test__pg_arena__retention_hard_reset();
+#ifdef __CCMS__HAS_VMEM
+  test__pg_arena__retention_purge();
+#endif
 
   return 0;
 }
\ No newline at end of file
@@ -24,6 +24,49 @@
 
 // Include the header file to test
 #include "ccms/arena/static.h"
+#include "ccms/relptr.h"
+
+// The tests counting bytes need chunks packed back to back, which is what
+// st_arena__alloc does with the default alignment of 1 only
+#if __CCMS__DEFAULT_ALIGN == 1
+#define st_arena__alloc_packed(arena, size) st_arena__alloc(arena, size)
+#else
+#define st_arena__alloc_packed(arena, size) \
+  st_arena__alloc_aligned(arena, size, 1)
+#endif
+
+#define TEST_FILE "test__arena__static.tmp"
+
+typedef struct node_t {
+  relptr_t next;
+  uint32_t value;
+} node_t;
+
+// Builds a list of `n` nodes linked through relative pointers, the head is the
+// first chunk of the arena
+static void make_list(st_arena_t* arena, const uint32_t n) {
+  node_t* prev = NULL;
+
+  for (uint32_t i = 0; i < n; i++) {
+    node_t* node =
+        _M_cast(node_t*, st_arena__alloc_aligned(arena, sizeof(node_t), 8));
+    relptr__set(&node->next, NULL);
+    node->value = i;
+    if (prev != NULL) relptr__set(&prev->next, node);
+    prev = node;
+  }
+}
+
+static void check_list(const uint8_t* head, const uint32_t n) {
+  const node_t* node = _M_cast(const node_t*, head);
+
+  for (uint32_t i = 0; i < n; i++) {
+    assert(node != NULL);
+    assert(node->value == i);
+    node = relptr__deref(node_t, &node->next);
+  }
+  assert(node == NULL);
+}
 
 //
 //
@@ -69,7 +112,7 @@ void test__st_arena__cap() {
 void test__st_arena__reset() {
   // -- PREPARE
   st_arena_t* sa = st_arena__new(10);
-  st_arena__alloc(sa, 5);
+  st_arena__alloc_packed(sa, 5);
   assert(st_arena__cap(sa) == 5);
 
   // -- TEST
@@ -82,17 +125,188 @@ void test__st_arena__reset() {
 
 void test__st_arena__alloc() {
   // -- PREPARE
-  st_arena_t* sa = st_arena__new(10);
+  st_arena_t* sa = st_arena__new(256);
 
   // -- TEST
   uint8_t* mem = st_arena__alloc(sa, 5);
   assert(mem != NULL);
-  assert(st_arena__cap(sa) == 5);
+  assert(_M_cast(uintptr_t, mem) % __CCMS__DEFAULT_ALIGN == 0);
+  assert(sa->writehead == mem + 5);
+
+  // consecutive chunks are __CCMS__DEFAULT_ALIGN apart
+  assert(st_arena__alloc(sa, 5) == mem + _M_align_up(5, __CCMS__DEFAULT_ALIGN));
 
   // -- CLEANUP
   st_arena__free(sa);
 }
 
+void test__st_arena__alloc_aligned() {
+  // -- PREPARE
+  st_arena_t* sa = st_arena__new(256);
+  assert(_ST_ARENA_HEADER_SIZE % _M_MAX_ALIGN == 0);
+
+  // -- TEST
+  uint8_t* odd = st_arena__alloc(sa, 3);
+  assert(odd != NULL);
+
+  for (size_t align = 1; align <= 64; align <<= 1) {
+    uint8_t* mem = st_arena__alloc_aligned(sa, 3, align);
+    assert(mem != NULL);
+    assert(_M_cast(uintptr_t, mem) % align == 0);
+  }
+
+  // alignment must be a power of two
+  assert(st_arena__alloc_aligned(sa, 1, 24) == NULL);
+  // padding counts against the capacity
+  st_arena__reset(sa);
+  st_arena__alloc_packed(sa, 1);
+  assert(st_arena__alloc_aligned(sa, 255, 2) == NULL);
+  assert(st_arena__alloc_aligned(sa, 254, 2) != NULL);
+  assert(st_arena__cap(sa) == 0);
+
+  // -- CLEANUP
+  st_arena__free(sa);
+}
+
+void test__st_arena__mark_and_rewind() {
+  // -- PREPARE
+  st_arena_t* sa = st_arena__new(64);
+  uint8_t* keep = st_arena__alloc_packed(sa, 8);
+
+  // -- TEST
+  st_arena_mark_t mark = st_arena__mark(sa);
+  uint8_t* tmp = st_arena__alloc_packed(sa, 16);
+  st_arena__alloc_packed(sa, 16);
+  assert(st_arena__cap(sa) == 24);
+
+  st_arena__rewind(sa, mark);
+  assert(st_arena__cap(sa) == 56);
+  assert(st_arena__alloc_packed(sa, 1) == tmp);
+  assert(keep != tmp);
+
+  // -- CLEANUP
+  st_arena__free(sa);
+}
+
+void test__st_arena__scope() {
+  // -- PREPARE
+  st_arena_t* sa = st_arena__new(64);
+  st_arena__alloc_packed(sa, 8);
+
+  // -- TEST
+  st_arena__scope(sa) {
+    st_arena__alloc_packed(sa, 8);
+    st_arena__scope(sa) {
+      st_arena__alloc_packed(sa, 8);
+      assert(st_arena__cap(sa) == 40);
+    }
+    assert(st_arena__cap(sa) == 48);
+  }
+  assert(st_arena__cap(sa) == 56);
+
+  // -- CLEANUP
+  st_arena__free(sa);
+}
+
+void test__st_arena__realloc() {
+  // -- PREPARE
+  // room for the padding of a raised __CCMS__DEFAULT_ALIGN
+  st_arena_t* arena = st_arena__new(256);
+
+  // -- TEST
+  uint8_t* a = st_arena__realloc(arena, NULL, 0, 10);
+  memset(a, 1, 10);
+
+  // the last chunk grows and shrinks in place
+  assert(st_arena__realloc(arena, a, 10, 40) == a);
+  assert(arena->writehead == a + 40);
+  assert(st_arena__realloc(arena, a, 40, 20) == a);
+  assert(arena->writehead == a + 20);
+  assert(st_arena__realloc(arena, a, 20, 300) == NULL);
+  assert(arena->writehead == a + 20);
+
+  // any other chunk is copied when it grows
+  uint8_t* b = st_arena__alloc(arena, 10);
+  uint8_t* c = st_arena__realloc(arena, a, 20, 30);
+  assert(c == b + _M_align_up(10, __CCMS__DEFAULT_ALIGN));
+  assert(c[0] == 1 && c[9] == 1);
+  assert(arena->writehead == c + 30);
+
+  // and keeps its space when it shrinks
+  st_arena__shrink(arena, b, 10, 5);
+  assert(arena->writehead == c + 30);
+  st_arena__shrink(arena, c, 30, 5);
+  assert(arena->writehead == c + 5);
+
+  // -- CLEANUP
+  st_arena__free(arena);
+}
+
+void test__st_arena__save_and_load() {
+  // -- PREPARE
+  st_arena_t* arena = st_arena__new(KiB(4));
+  make_list(arena, 100);
+  const size_t used = KiB(4) - st_arena__cap(arena);
+
+  // -- TEST
+  assert(st_arena__save(arena, TEST_FILE) == 0);
+
+  // the copy lives somewhere else, the relative pointers still work
+  st_arena_t* loaded = st_arena__load(TEST_FILE, KiB(8));
+  assert(loaded != NULL);
+  assert(st_arena__data(loaded) != st_arena__data(arena));
+  assert(st_arena__cap(loaded) == KiB(8) - used);
+  assert(memcmp(st_arena__data(loaded), st_arena__data(arena), used) == 0);
+  check_list(st_arena__data(loaded), 100);
+
+  // and it can keep growing
+  assert(st_arena__alloc(loaded, KiB(4)) != NULL);
+  st_arena__free(loaded);
+
+  // a clone is relocated the same way
+  st_arena_t* clone = st_arena__clone(arena);
+  check_list(st_arena__data(clone), 100);
+  st_arena__free(clone);
+
+  // the file has to fit, and to exist
+  assert(st_arena__load(TEST_FILE, used - 1) == NULL);
+  loaded = st_arena__load(TEST_FILE, used);
+  assert(loaded != NULL);
+  assert(st_arena__cap(loaded) == 0);
+  st_arena__free(loaded);
+
+  remove(TEST_FILE);
+  assert(st_arena__load(TEST_FILE, KiB(8)) == NULL);
+
+  // -- CLEANUP
+  st_arena__free(arena);
+}
+
+void test__st_arena__new_huge() {
+  // -- TEST
+  st_arena_t* arena = st_arena__new_huge(MiB(3));
+  assert(arena != NULL);
+  assert(_M_cast(uintptr_t, arena) % __CCMS__HUGE_PAGE_SIZE == 0);
+  // rounded up to whole huge pages
+  assert(st_arena__cap(arena) >= MiB(3));
+  assert((st_arena__cap(arena) + _ST_ARENA_HEADER_SIZE) %
+             __CCMS__HUGE_PAGE_SIZE ==
+         0);
+
+  uint8_t* chunk = st_arena__alloc_packed(arena, MiB(3));
+  assert(chunk == st_arena__data(arena));
+  memset(chunk, 0xAB, MiB(3));
+
+  // the clone is a regular arena
+  st_arena_t* clone = st_arena__clone(arena);
+  assert(clone->huge == 0);
+  assert(st_arena__data(clone)[MiB(3) - 1] == 0xAB);
+
+  // -- CLEANUP
+  st_arena__free(clone);
+  st_arena__free(arena);
+}
+
 //
 //
 // ------------------ main ------------------
@@ -106,6 +320,12 @@ int main() {
   test__st_arena__cap();
   test__st_arena__reset();
   test__st_arena__alloc();
+  test__st_arena__alloc_aligned();
+  test__st_arena__realloc();
+  test__st_arena__mark_and_rewind();
+  test__st_arena__scope();
+  test__st_arena__save_and_load();
+  test__st_arena__new_huge();
 
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,319 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// do not move or delete this #undef, otherwise the test will always pass, as
+// assert is only defined in debug mode. This #undef forces assert to be defined
+#undef NDEBUG
+#include <assert.h>
+
+// The statistics only exist with this defined
+#ifndef __CCMS__ARENA_STATS
+#define __CCMS__ARENA_STATS
+#endif
+
+// Include the header files to test
+#include "ccms/arena/concurrent.h"
+#include "ccms/arena/dynamic.h"
+#include "ccms/arena/paged.h"
+#include "ccms/arena/static.h"
+#include "ccms/arena/virtual.h"
+
+// The byte counts below assume unpadded chunks, so the tests allocate with an
+// explicit alignment of 1 instead of __CCMS__DEFAULT_ALIGN.
+
+//
+//
+// ------------------ st_arena_t ------------------
+//
+//
+
+void test__st_arena__stats() {
+  // -- PREPARE
+  st_arena_t* arena = st_arena__new(100);
+
+  // -- TEST
+  arena_stats_t stats = st_arena__stats(arena);
+  assert(stats.allocs == 0);
+  assert(stats.in_use == 0);
+  assert(stats.reserved == _ST_ARENA_HEADER_SIZE + 100);
+  assert(stats.blocks == 1);
+
+  uint8_t* a = st_arena__alloc_aligned(arena, 10, 1);
+  // the data region is aligned to max_align_t, so this needs 6 bytes padding
+  uint8_t* b = st_arena__alloc_aligned(arena, 1, 16);
+  stats = st_arena__stats(arena);
+  assert(stats.allocs == 2);
+  assert(stats.requested == 11);
+  assert(stats.padding == 6);
+  assert(stats.in_use == 17);
+  assert(stats.peak == 17);
+
+  // in-place growth and shrinking
+  assert(st_arena__realloc_aligned(arena, b, 1, 5, 1) == b);
+  st_arena__shrink(arena, b, 5, 2);
+  stats = st_arena__stats(arena);
+  assert(stats.allocs == 2);
+  assert(stats.requested == 15);
+  assert(stats.in_use == 18);
+  assert(stats.peak == 21);
+
+  st_arena_mark_t mark = st_arena__mark(arena);
+  st_arena__alloc_aligned(arena, 30, 1);
+  st_arena__rewind(arena, mark);
+  stats = st_arena__stats(arena);
+  assert(stats.in_use == 18);
+  assert(stats.peak == 48);
+
+  st_arena__reset(arena);
+  stats = st_arena__stats(arena);
+  assert(stats.resets == 1);
+  assert(stats.in_use == 0);
+  assert(stats.peak == 48);
+  assert(stats.allocs == 3);
+  (void)a;
+
+  // -- CLEANUP
+  st_arena__free(arena);
+}
+
+//
+//
+// ------------------ pg_arena_t ------------------
+//
+//
+
+void test__pg_arena__stats() {
+  // -- PREPARE
+  pg_arena_t* arena = pg_arena__new(64);
+  const size_t page = _PG_ARENA_PAGE_HEADER_SIZE + 64;
+
+  // -- TEST
+  arena_stats_t stats = pg_arena__stats(arena);
+  assert(stats.blocks == 1);
+  assert(stats.reserved == page);
+
+  pg_arena__alloc_aligned(arena, 60, 1);
+  // does not fit into the rest of the first page, which is wasted
+  pg_arena__alloc_aligned(arena, 10, 1);
+  stats = pg_arena__stats(arena);
+  assert(stats.allocs == 2);
+  assert(stats.requested == 70);
+  assert(stats.wasted == 4);
+  assert(stats.in_use == 74);
+  assert(stats.blocks == 2);
+  assert(stats.reserved == 2 * page);
+
+  // large chunks get a block of their own
+  pg_arena_mark_t mark = pg_arena__mark(arena);
+  pg_arena__alloc_aligned(arena, 100, 1);
+  stats = pg_arena__stats(arena);
+  assert(stats.blocks == 3);
+  assert(stats.reserved == 2 * page + _PG_ARENA_LARGE_HEADER_SIZE + 100);
+  assert(stats.in_use == 174);
+
+  pg_arena__rewind(arena, mark);
+  stats = pg_arena__stats(arena);
+  assert(stats.blocks == 2);
+  assert(stats.reserved == 2 * page);
+  assert(stats.in_use == 74);
+  assert(stats.peak == 174);
+
+  // the second page is kept by a reset, but not by a hard reset
+  pg_arena__reset(arena);
+  stats = pg_arena__stats(arena);
+  assert(stats.resets == 1);
+  assert(stats.in_use == 0);
+  assert(stats.blocks == 2);
+
+  pg_arena__hard_reset(arena);
+  stats = pg_arena__stats(arena);
+  assert(stats.resets == 2);
+  assert(stats.blocks == 1);
+  assert(stats.reserved == page);
+  assert(stats.allocs == 3);
+
+  // -- CLEANUP
+  pg_arena__free(arena);
+}
+
+void test__pg_arena__stats_keep_large() {
+  // -- PREPARE
+  pg_arena_t* arena = pg_arena__new(64);
+  pg_arena__set_keep_large(arena, 1);
+
+  // -- TEST
+  pg_arena__alloc_aligned(arena, 100, 1);
+  pg_arena__reset(arena);
+  arena_stats_t stats = pg_arena__stats(arena);
+  assert(stats.blocks == 2);
+  assert(stats.in_use == 0);
+
+  // the kept block is reused
+  pg_arena__alloc_aligned(arena, 90, 1);
+  stats = pg_arena__stats(arena);
+  assert(stats.blocks == 2);
+  assert(stats.in_use == 90);
+
+  pg_arena__hard_reset(arena);
+  stats = pg_arena__stats(arena);
+  assert(stats.blocks == 1);
+
+  // -- CLEANUP
+  pg_arena__free(arena);
+}
+
+//
+//
+// ------------------ vm_arena_t ------------------
+//
+//
+
+void test__vm_arena__stats() {
+  // -- PREPARE
+  vm_arena_t* arena = vm_arena__new(MiB(1));
+
+  // -- TEST
+  arena_stats_t stats = vm_arena__stats(arena);
+  assert(stats.reserved == 0);
+  assert(stats.blocks == 1);
+
+  vm_arena__alloc_aligned(arena, 100, 1);
+  stats = vm_arena__stats(arena);
+  assert(stats.allocs == 1);
+  assert(stats.in_use == 100);
+  assert(stats.reserved == arena->commit_size);
+
+  vm_arena__reset(arena);
+  vm_arena__decommit(arena);
+  stats = vm_arena__stats(arena);
+  assert(stats.resets == 1);
+  assert(stats.in_use == 0);
+  assert(stats.peak == 100);
+  assert(stats.reserved == 0);
+
+  // -- CLEANUP
+  vm_arena__free(arena);
+}
+
+//
+//
+// ------------------ dyn_arena_t ------------------
+//
+//
+
+void test__dyn_arena__stats() {
+  // -- PREPARE
+  dyn_arena_t* arena = dyn_arena__new_chunked(64, 16);
+  const size_t chunk = _DYN_ARENA_CHUNK_HEADER_SIZE + 64;
+
+  // -- TEST
+  arena_stats_t stats = dyn_arena__stats(arena);
+  assert(stats.blocks == 0);
+  assert(stats.reserved == 0);
+
+  for (size_t i = 0; i < 7; i++)
+    dyn_arena__alloc_aligned(arena, 10, 1);
+  stats = dyn_arena__stats(arena);
+  // the seventh request moves on to a second chunk
+  assert(stats.allocs == 7);
+  assert(stats.wasted == 4);
+  assert(stats.in_use == 74);
+  assert(stats.blocks == 2);
+  assert(stats.reserved == 2 * chunk);
+
+  // above the threshold
+  dyn_arena__alloc_aligned(arena, 20, 1);
+  stats = dyn_arena__stats(arena);
+  assert(stats.blocks == 3);
+  assert(stats.reserved == 2 * chunk + _DYN_ARENA_BLOCK_HEADER_SIZE + 20);
+  assert(stats.in_use == 94);
+
+  dyn_arena__soft_reset(arena);
+  stats = dyn_arena__stats(arena);
+  assert(stats.resets == 1);
+  assert(stats.in_use == 0);
+  assert(stats.peak == 94);
+  assert(stats.blocks == 2);
+
+  dyn_arena__reset(arena);
+  stats = dyn_arena__stats(arena);
+  assert(stats.blocks == 0);
+  assert(stats.reserved == 0);
+
+  // -- CLEANUP
+  dyn_arena__free(arena);
+}
+
+//
+//
+// ------------------ cst_arena_t ------------------
+//
+//
+
+void test__cst_arena__stats() {
+  // -- PREPARE
+  cst_arena_t* arena = cst_arena__new(100);
+
+  // -- TEST
+  cst_arena__alloc_aligned(arena, 10, 1);
+  cst_arena__alloc_aligned(arena, 1, 16);
+  arena_stats_t stats = cst_arena__stats(arena);
+  assert(stats.allocs == 2);
+  assert(stats.requested == 11);
+  assert(stats.padding == 6);
+  assert(stats.in_use == 17);
+  assert(stats.peak == 17);
+  assert(stats.reserved == _CST_ARENA_HEADER_SIZE + 100);
+
+  cst_arena__reset(arena);
+  cst_arena__alloc_aligned(arena, 5, 1);
+  stats = cst_arena__stats(arena);
+  assert(stats.resets == 1);
+  assert(stats.in_use == 5);
+  assert(stats.peak == 17);
+
+  // -- CLEANUP
+  cst_arena__free(arena);
+}
+
+//
+//
+// ------------------ main ------------------
+//
+//
+
+int main() {
+  // -- st_arena_t
+  test__st_arena__stats();
+
+  // -- pg_arena_t
+  test__pg_arena__stats();
+  test__pg_arena__stats_keep_large();
+
+  // -- vm_arena_t
+  test__vm_arena__stats();
+
+  // -- dyn_arena_t
+  test__dyn_arena__stats();
+
+  // -- cst_arena_t
+  test__cst_arena__stats();
+
+  return 0;
+}
@@ -0,0 +1,296 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// do not move or delete this #undef, otherwise the test will always pass, as
+// assert is only defined in debug mode. This #undef forces assert to be defined
+#undef NDEBUG
+#include <assert.h>
+#include <string.h>
+
+// Include the header file to test
+#include "ccms/arena/virtual.h"
+#include "ccms/relptr.h"
+
+#define TEST_FILE "test__arena__virtual.tmp"
+
+typedef struct node_t {
+  relptr_t next;
+  uint32_t value;
+} node_t;
+
+// Builds a list of `n` nodes linked through relative pointers, the head is the
+// first chunk of the arena
+static void make_list(vm_arena_t* arena, const uint32_t n) {
+  node_t* prev = NULL;
+
+  for (uint32_t i = 0; i < n; i++) {
+    node_t* node =
+        _M_cast(node_t*, vm_arena__alloc_aligned(arena, sizeof(node_t), 8));
+    relptr__set(&node->next, NULL);
+    node->value = i;
+    if (prev != NULL) relptr__set(&prev->next, node);
+    prev = node;
+  }
+}
+
+static void check_list(const uint8_t* head, const uint32_t n) {
+  const node_t* node = _M_cast(const node_t*, head);
+
+  for (uint32_t i = 0; i < n; i++) {
+    assert(node != NULL);
+    assert(node->value == i);
+    node = relptr__deref(node_t, &node->next);
+  }
+  assert(node == NULL);
+}
+
+//
+//
+// ------------------ vm_arena_t ------------------
+//
+//
+
+void test__vm_arena__new_and_free() {
+  // -- TEST
+  // reserving a lot of address space is cheap, nothing is committed yet
+  vm_arena_t* arena = vm_arena__new(GiB(_M_cast(size_t, 4)));
+  assert(arena != NULL);
+  assert(arena->base != NULL);
+  assert(arena->reserved == GiB(_M_cast(size_t, 4)));
+  assert(arena->committed == 0);
+  assert(arena->pos == 0);
+
+  // -- CLEANUP
+  vm_arena__free(arena);
+}
+
+void test__vm_arena__cap() {
+  // -- PREPARE
+  vm_arena_t* arena = vm_arena__new(MiB(1));
+
+  // -- TEST
+  assert(vm_arena__cap(arena) == MiB(1));
+  vm_arena__alloc(arena, 10);
+  assert(vm_arena__cap(arena) == MiB(1) - 10);
+
+  // -- CLEANUP
+  vm_arena__free(arena);
+}
+
+void test__vm_arena__alloc() {
+  // -- PREPARE
+  vm_arena_t* arena = vm_arena__new(GiB(1));
+
+  // -- TEST
+  uint8_t* a = vm_arena__alloc(arena, 10);
+  uint8_t* b = vm_arena__alloc(arena, 10);
+  assert(a != NULL);
+  assert(b == a + _M_align_up(10, __CCMS__DEFAULT_ALIGN));
+  assert(arena->committed >= arena->pos);
+  memset(a, 1, 10);
+  memset(b, 1, 10);
+
+  // one chunk much larger than the commit step is contiguous and writable
+  uint8_t* big = vm_arena__alloc(arena, MiB(8) + 3);
+  assert(big == b + _M_align_up(10, __CCMS__DEFAULT_ALIGN));
+  assert(arena->committed >= arena->pos);
+  big[0] = 1;
+  big[MiB(8) + 2] = 2;
+
+  // allocating past the reservation fails
+  assert(vm_arena__alloc(arena, GiB(1)) == NULL);
+
+  // -- CLEANUP
+  vm_arena__free(arena);
+}
+
+void test__vm_arena__alloc_aligned() {
+  // -- PREPARE
+  vm_arena_t* arena = vm_arena__new(MiB(1));
+  vm_arena__alloc(arena, 3);
+
+  // -- TEST
+  for (size_t align = 1; align <= 4096; align <<= 1) {
+    uint8_t* mem = vm_arena__alloc_aligned(arena, 3, align);
+    assert(mem != NULL);
+    assert(_M_cast(uintptr_t, mem) % align == 0);
+  }
+  assert(vm_arena__alloc_aligned(arena, 1, 5) == NULL);
+
+  // -- CLEANUP
+  vm_arena__free(arena);
+}
+
+void test__vm_arena__reset() {
+  // -- PREPARE
+  vm_arena_t* arena = vm_arena__new(MiB(16));
+  uint8_t* first = vm_arena__alloc(arena, MiB(2));
+  const size_t committed = arena->committed;
+
+  // -- TEST
+  vm_arena__reset(arena);
+  assert(arena->pos == 0);
+  assert(arena->committed == committed);
+  assert(vm_arena__alloc(arena, 1) == first);
+
+  // -- CLEANUP
+  vm_arena__free(arena);
+}
+
+void test__vm_arena__decommit() {
+  // -- PREPARE
+  vm_arena_t* arena = vm_arena__new(MiB(16));
+  vm_arena__alloc(arena, MiB(2));
+  vm_arena__reset(arena);
+
+  // -- TEST
+  uint8_t* mem = vm_arena__alloc(arena, 100);
+  vm_arena__decommit(arena);
+  assert(arena->committed >= arena->pos);
+  assert(arena->committed <= arena->commit_size);
+  mem[99] = 1;
+
+  // decommitted memory is committed again on demand
+  uint8_t* big = vm_arena__alloc(arena, MiB(4));
+  assert(big != NULL);
+  big[MiB(4) - 1] = 1;
+
+  // -- CLEANUP
+  vm_arena__free(arena);
+}
+
+void test__vm_arena__realloc() {
+  // -- PREPARE
+  vm_arena_t* arena = vm_arena__new(MiB(4));
+
+  // -- TEST
+  uint8_t* a = vm_arena__realloc(arena, NULL, 0, 10);
+  memset(a, 1, 10);
+
+  // the last chunk grows in place, committing memory on the way
+  assert(vm_arena__realloc(arena, a, 10, MiB(1)) == a);
+  assert(arena->pos == MiB(1));
+  assert(arena->committed >= MiB(1));
+  a[MiB(1) - 1] = 1;
+  assert(vm_arena__realloc(arena, a, MiB(1), 20) == a);
+  assert(arena->pos == 20);
+  assert(vm_arena__realloc(arena, a, 20, MiB(8)) == NULL);
+  assert(arena->pos == 20);
+
+  // any other chunk is copied when it grows
+  uint8_t* b = vm_arena__alloc(arena, 10);
+  uint8_t* c = vm_arena__realloc(arena, a, 20, 40);
+  assert(c == b + _M_align_up(10, __CCMS__DEFAULT_ALIGN));
+  assert(c[0] == 1 && c[9] == 1);
+  vm_arena__shrink(arena, b, 10, 1);
+  assert(arena->base + arena->pos == c + 40);
+  vm_arena__shrink(arena, c, 40, 1);
+  assert(arena->base + arena->pos == c + 1);
+
+  // -- CLEANUP
+  vm_arena__free(arena);
+}
+
+void test__vm_arena__save_and_load() {
+  // -- PREPARE
+  vm_arena_t* arena = vm_arena__new(MiB(64));
+  // spans a few pages
+  make_list(arena, 10000);
+  const size_t used = arena->pos;
+
+  // -- TEST
+  assert(vm_arena__save(arena, TEST_FILE) == 0);
+
+  vm_arena_t* loaded = vm_arena__load(TEST_FILE, MiB(64));
+  assert(loaded != NULL);
+  assert(loaded->base != arena->base);
+  assert(loaded->pos == used);
+  assert(memcmp(loaded->base, arena->base, used) == 0);
+  check_list(loaded->base, 10000);
+
+  // the loaded part is writable, and the arena keeps growing behind it
+  _M_cast(node_t*, loaded->base)->value = 42;
+  uint8_t* chunk = vm_arena__alloc(loaded, MiB(1));
+  assert(chunk == loaded->base + used);
+  memset(chunk, 0xAB, MiB(1));
+
+  // writes never reach the file
+  vm_arena_t* again = vm_arena__load(TEST_FILE, MiB(1));
+  assert(again != NULL);
+  check_list(again->base, 10000);
+  vm_arena__free(again);
+
+  // a reset arena reuses the loaded part
+  vm_arena__reset(loaded);
+  assert(vm_arena__alloc(loaded, used + MiB(1)) == loaded->base);
+  vm_arena__decommit(loaded);
+  vm_arena__free(loaded);
+
+  // the file has to fit, and to exist
+  assert(vm_arena__load(TEST_FILE, KiB(4)) == NULL);
+  remove(TEST_FILE);
+  assert(vm_arena__load(TEST_FILE, MiB(64)) == NULL);
+
+  // -- CLEANUP
+  vm_arena__free(arena);
+}
+
+void test__vm_arena__new_huge() {
+  // -- TEST
+  vm_arena_t* arena = vm_arena__new_huge(MiB(64) + 1);
+  assert(arena != NULL);
+  assert(_M_cast(uintptr_t, arena->base) % __CCMS__HUGE_PAGE_SIZE == 0);
+  assert(arena->reserved == MiB(64) + __CCMS__HUGE_PAGE_SIZE);
+
+  // commits whole huge pages
+  uint8_t* chunk = vm_arena__alloc(arena, 100);
+  assert(chunk == arena->base);
+  assert(arena->committed == __CCMS__HUGE_PAGE_SIZE);
+  chunk = vm_arena__alloc(arena, MiB(5));
+  memset(chunk, 0xAB, MiB(5));
+  assert(arena->committed % __CCMS__HUGE_PAGE_SIZE == 0);
+
+  vm_arena__reset(arena);
+  vm_arena__decommit(arena);
+  assert(arena->committed == 0);
+
+  // -- CLEANUP
+  vm_arena__free(arena);
+}
+
+//
+//
+// ------------------ main ------------------
+//
+//
+
+int main() {
+  // -- vm_arena_t
+  test__vm_arena__new_and_free();
+  test__vm_arena__cap();
+  test__vm_arena__alloc();
+  test__vm_arena__alloc_aligned();
+  test__vm_arena__realloc();
+  test__vm_arena__reset();
+  test__vm_arena__decommit();
+  test__vm_arena__save_and_load();
+  test__vm_arena__new_huge();
+
+  return 0;
+}
@@ -21,6 +21,7 @@
 // assert is only defined in debug mode. This #undef forces assert to be defined
 #undef NDEBUG
 #include <assert.h>
+#include <stdlib.h>
 
 // Include the header file to test
 #include "ccms/box.h"
@@ -52,6 +53,139 @@ void test__box__clone() {
   assert(b2.size == b1.size);
 }
 
+static box_t make_bytes(const size_t size, uint8_t seed) {
+  uint8_t* ptr = _M_cast(uint8_t*, malloc(size > 0 ? size : 1));
+
+  for (size_t i = 0; i < size; i++)
+    ptr[i] = _M_cast(uint8_t, i * 31 + seed);
+
+  return box__ctor(ptr, size);
+}
+
+void test__box__eq() {
+  // -- PREPARE
+  box_t a = make_bytes(300, 7);
+  box_t b = make_bytes(300, 7);
+
+  // -- TEST
+  assert(box__eq(box__ctor(NULL, 0), box__ctor(NULL, 0)));
+  assert(box__eq(box__ctor(a.ptr, 0), box__ctor(b.ptr, 0)));
+  assert(box__eq(a, a));
+  assert(box__eq(a, b));
+  assert(!box__eq(a, box__ctor(b.ptr, 299)));
+
+  // a single differing byte is found at every position and size, across the
+  // vector, word and byte loops
+  for (size_t size = 1; size <= 300; size++) {
+    for (size_t i = 0; i < size; i++) {
+      b.ptr[i] ^= 0x10;
+      assert(!box__eq(box__ctor(a.ptr, size), box__ctor(b.ptr, size)));
+      b.ptr[i] ^= 0x10;
+    }
+    assert(box__eq(box__ctor(a.ptr, size), box__ctor(b.ptr, size)));
+  }
+
+  // -- CLEANUP
+  free(a.ptr);
+  free(b.ptr);
+}
+
+void test__box__cmp() {
+  // -- PREPARE
+  box_t a = make_bytes(300, 3);
+  box_t b = make_bytes(300, 3);
+
+  // -- TEST
+  assert(box__cmp(a, b) == 0);
+  assert(box__cmp(a, a) == 0);
+  assert(box__cmp(box__ctor(NULL, 0), box__ctor(NULL, 0)) == 0);
+  assert(box__cmp(box__ctor(NULL, 0), a) < 0);
+
+  // a prefix orders first
+  assert(box__cmp(box__ctor(a.ptr, 100), b) < 0);
+  assert(box__cmp(a, box__ctor(b.ptr, 100)) > 0);
+
+  // bytes compare as unsigned values, like memcmp
+  for (size_t i = 0; i < 300; i++) {
+    const uint8_t old = b.ptr[i];
+    b.ptr[i] = _M_cast(uint8_t, a.ptr[i] + 0x80);
+    assert((box__cmp(a, b) < 0) == (memcmp(a.ptr, b.ptr, 300) < 0));
+    assert((box__cmp(b, a) < 0) == (memcmp(b.ptr, a.ptr, 300) < 0));
+    assert(box__cmp(a, b) != 0);
+    assert(box__cmp(box__ctor(a.ptr, i), box__ctor(b.ptr, i)) == 0);
+    // the first difference decides, not the size
+    assert((box__cmp(box__ctor(a.ptr, i + 1), b) < 0) ==
+           (box__cmp(a, b) < 0));
+    b.ptr[i] = old;
+  }
+
+  // -- CLEANUP
+  free(a.ptr);
+  free(b.ptr);
+}
+
+void test__box__starts_with() {
+  // -- PREPARE
+  box_t a = make_bytes(100, 1);
+  box_t b = make_bytes(100, 1);
+
+  // -- TEST
+  assert(box__starts_with(a, box__ctor(NULL, 0)));
+  assert(box__starts_with(a, b));
+  assert(box__starts_with(a, box__ctor(b.ptr, 64)));
+  assert(!box__starts_with(box__ctor(a.ptr, 64), b));
+
+  b.ptr[63] ^= 1;
+  assert(box__starts_with(a, box__ctor(b.ptr, 63)));
+  assert(!box__starts_with(a, box__ctor(b.ptr, 64)));
+
+  // -- CLEANUP
+  free(a.ptr);
+  free(b.ptr);
+}
+
+void test__box__hash() {
+  // -- PREPARE
+  box_t a = make_bytes(5000, 7);
+  box_t b = make_bytes(5000, 7);
+
+  // hashes are fixed, with or without SIMD and on every platform
+  const size_t sizes[] = {0, 1, 3, 4, 8, 16, 17, 49, 256, 257, 1025, 4999};
+  const uint64_t hashes[] = {
+      0x0409638EE2BDE459ull, 0xFDDEEEEA8CC2709Cull, 0xAA4DADA6D17EEBB0ull,
+      0x8D9D4657E96CC294ull, 0x9654832F28858268ull, 0x36B53F8551944DB0ull,
+      0x904849BDD1E93C7Cull, 0x30161CB91C8DF53Eull, 0xE4E465A228B2D552ull,
+      0xB5215CEB11EF2957ull, 0xACF49CA54F2797C0ull, 0xF652F5DE136A7A1Aull,
+  };
+
+  // -- TEST
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    assert(box__hash(box__ctor(a.ptr, sizes[i])) == hashes[i]);
+
+  // equal bytes hash equal, a flipped bit or a different seed changes the
+  // hash on both the short and the long path
+  const size_t checked[] = {5, 100, 256, 300, 1024, 5000};
+  for (size_t i = 0; i < sizeof(checked) / sizeof(checked[0]); i++) {
+    const size_t size = checked[i];
+    const uint64_t hash = box__hash(box__ctor(a.ptr, size));
+
+    assert(hash == box__hash(box__ctor(b.ptr, size)));
+    assert(hash != box__hash_seeded(box__ctor(a.ptr, size), 1));
+    for (size_t j = 0; j < size; j += size / 5 + 1) {
+      b.ptr[j] ^= 1;
+      assert(hash != box__hash(box__ctor(b.ptr, size)));
+      b.ptr[j] ^= 1;
+    }
+    b.ptr[size - 1] ^= 0x80;
+    assert(hash != box__hash(box__ctor(b.ptr, size)));
+    b.ptr[size - 1] ^= 0x80;
+  }
+
+  // -- CLEANUP
+  free(a.ptr);
+  free(b.ptr);
+}
+
 //
 //
 // ------------------ main ------------------
@@ -62,6 +196,10 @@ int main() {
   // -- box_t
   test__box__ctor();
   test__box__clone();
+  test__box__eq();
+  test__box__cmp();
+  test__box__starts_with();
+  test__box__hash();
 
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,251 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// do not move or delete this #undef, otherwise the test will always pass, as
+// assert is only defined in debug mode. This #undef forces assert to be defined
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+// Include the header file to test
+#include "ccms/box_map.h"
+
+static box_t str(const char* s) {
+  return box__ctor(_M_cast(uint8_t*, s), strlen(s));
+}
+
+//
+//
+// ------------------ box_map_t ------------------
+//
+//
+
+void test__box_map__new_and_free() {
+  // -- TEST
+  box_map_t* map = box_map__new(allocator__malloc());
+  assert(map != NULL);
+  assert(map->len == 0);
+  assert(map->cap == 0);
+  assert(map->keys != NULL);
+  assert(box_map__get(map, str("missing")) == NULL);
+
+  // -- CLEANUP
+  box_map__free(map);
+}
+
+void test__box_map__insert_and_get() {
+  // -- PREPARE
+  box_map_t* map = box_map__new(allocator__malloc());
+  char key[] = "key";
+
+  // -- TEST
+  assert(*box_map__insert(map, str(key), 1) == 1);
+  assert(*box_map__insert(map, str("other"), 2) == 2);
+  assert(*box_map__insert(map, str(""), 3) == 3);
+  assert(map->len == 3);
+
+  // keys are copied into the map
+  key[0] = 'x';
+  assert(box_map__get(map, str("key")) != NULL);
+  assert(*box_map__get(map, str("key")) == 1);
+  assert(box_map__get(map, str("xey")) == NULL);
+  assert(*box_map__get(map, str("")) == 3);
+
+  // inserting an existing key overwrites its value
+  assert(*box_map__insert(map, str("other"), 4) == 4);
+  assert(*box_map__get(map, str("other")) == 4);
+  assert(map->len == 3);
+
+  // -- CLEANUP
+  box_map__free(map);
+}
+
+void test__box_map__entry() {
+  // -- PREPARE
+  box_map_t* map = box_map__new(allocator__malloc());
+  int inserted = 0;
+
+  // -- TEST
+  uint64_t* value = box_map__entry(map, str("a"), &inserted);
+  assert(inserted == 1);
+  assert(*value == 0);
+  *value = 7;
+
+  value = box_map__entry(map, str("a"), &inserted);
+  assert(inserted == 0);
+  assert(*value == 7);
+
+  // the stored copy of the key can be found from its value
+  const box_t key = box_map__key_of(value);
+  assert(key.size == 1 && key.ptr[0] == 'a');
+  assert(key.ptr != _M_cast(const uint8_t*, "a"));
+
+  // -- CLEANUP
+  box_map__free(map);
+}
+
+void test__box_map__grow() {
+  // -- PREPARE
+  box_map_t* map = box_map__new(allocator__malloc());
+  char buf[32];
+
+  // -- TEST
+  for (uint64_t i = 0; i < 100000; i++) {
+    snprintf(buf, sizeof(buf), "key-%lu", _M_cast(unsigned long, i));
+    assert(box_map__insert(map, str(buf), i) != NULL);
+  }
+  assert(map->len == 100000);
+  assert(map->len <= map->cap - map->cap / 8);
+
+  for (uint64_t i = 0; i < 100000; i++) {
+    snprintf(buf, sizeof(buf), "key-%lu", _M_cast(unsigned long, i));
+    uint64_t* value = box_map__get(map, str(buf));
+    assert(value != NULL && *value == i);
+  }
+  assert(box_map__get(map, str("key-100000")) == NULL);
+
+  // -- CLEANUP
+  box_map__free(map);
+}
+
+void test__box_map__remove() {
+  // -- PREPARE
+  box_map_t* map = box_map__new(allocator__malloc());
+  char buf[32];
+  for (uint64_t i = 0; i < 1000; i++) {
+    snprintf(buf, sizeof(buf), "%lu", _M_cast(unsigned long, i));
+    box_map__insert(map, str(buf), i);
+  }
+
+  // -- TEST
+  for (uint64_t i = 0; i < 1000; i += 2) {
+    snprintf(buf, sizeof(buf), "%lu", _M_cast(unsigned long, i));
+    assert(box_map__remove(map, str(buf)) == 1);
+    assert(box_map__remove(map, str(buf)) == 0);
+  }
+  assert(map->len == 500);
+
+  for (uint64_t i = 0; i < 1000; i++) {
+    snprintf(buf, sizeof(buf), "%lu", _M_cast(unsigned long, i));
+    assert((box_map__get(map, str(buf)) == NULL) == (i % 2 == 0));
+  }
+
+  // churning through deleted slots does not grow the map forever
+  const size_t cap = map->cap;
+  for (uint64_t i = 0; i < 100000; i++) {
+    snprintf(buf, sizeof(buf), "churn-%lu", _M_cast(unsigned long, i));
+    box_map__insert(map, str(buf), i);
+    assert(box_map__remove(map, str(buf)) == 1);
+  }
+  assert(map->cap == cap);
+  assert(map->len == 500);
+
+  // -- CLEANUP
+  box_map__free(map);
+}
+
+void test__box_map__next() {
+  // -- PREPARE
+  box_map_t* map = box_map__new(allocator__malloc());
+  box_map__insert(map, str("a"), 1);
+  box_map__insert(map, str("b"), 2);
+  box_map__insert(map, str("c"), 3);
+
+  // -- TEST
+  size_t itr = 0, count = 0;
+  uint64_t sum = 0;
+  box_t key;
+  uint64_t* value;
+  while (box_map__next(map, &itr, &key, &value)) {
+    assert(key.size == 1);
+    assert(*value == _M_cast(uint64_t, key.ptr[0] - 'a' + 1));
+    sum += *value;
+    count++;
+  }
+  assert(count == 3);
+  assert(sum == 6);
+
+  // -- CLEANUP
+  box_map__free(map);
+}
+
+void test__box_map__arena() {
+  // -- PREPARE
+  pg_arena_t* arena = pg_arena__new(KiB(64));
+  char buf[32];
+
+  // -- TEST
+  // everything lives in the arena, a reset drops the whole map
+  for (int round = 0; round < 3; round++) {
+    box_map_t* map = box_map__new(allocator__pg_arena(arena));
+    assert(map->keys == NULL);
+    for (uint64_t i = 0; i < 10000; i++) {
+      snprintf(buf, sizeof(buf), "%lu", _M_cast(unsigned long, i));
+      box_map__insert(map, str(buf), i);
+    }
+    assert(*box_map__get(map, str("1234")) == 1234);
+    pg_arena__reset(arena);
+  }
+
+  // -- CLEANUP
+  pg_arena__free(arena);
+}
+
+void test__box_map__clear() {
+  // -- PREPARE
+  box_map_t* map = box_map__new(allocator__malloc());
+  box_map__insert(map, str("a"), 1);
+  const size_t cap = map->cap;
+
+  // -- TEST
+  box_map__clear(map);
+  assert(map->len == 0);
+  assert(map->cap == cap);
+  assert(box_map__get(map, str("a")) == NULL);
+  box_map__insert(map, str("a"), 2);
+  assert(*box_map__get(map, str("a")) == 2);
+
+  assert(box_map__reserve(map, 1000) == 0);
+  assert(map->cap - map->cap / 8 >= 1000);
+  assert(*box_map__get(map, str("a")) == 2);
+
+  // -- CLEANUP
+  box_map__free(map);
+}
+
+//
+//
+// ------------------ main ------------------
+//
+//
+
+int main() {
+  // -- box_map_t
+  test__box_map__new_and_free();
+  test__box_map__insert_and_get();
+  test__box_map__entry();
+  test__box_map__grow();
+  test__box_map__remove();
+  test__box_map__next();
+  test__box_map__arena();
+  test__box_map__clear();
+
+  return 0;
+}
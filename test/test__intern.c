@@ -0,0 +1,139 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// do not move or delete this #undef, otherwise the test will always pass, as
+// assert is only defined in debug mode. This #undef forces assert to be defined
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+// Include the header file to test
+#include "ccms/intern.h"
+
+static box_t str(const char* s) {
+  return box__ctor(_M_cast(uint8_t*, s), strlen(s));
+}
+
+//
+//
+// ------------------ intern_t ------------------
+//
+//
+
+void test__intern__new_and_free() {
+  // -- TEST
+  intern_t* pool = intern__new();
+  assert(pool != NULL);
+  assert(intern__len(pool) == 0);
+  assert(intern__find(pool, str("a")) == INTERN_NONE);
+
+  // -- CLEANUP
+  intern__free(pool);
+}
+
+void test__intern__id() {
+  // -- PREPARE
+  intern_t* pool = intern__new();
+  char label[] = "method";
+
+  // -- TEST
+  // ids are handed out in the order strings are first seen
+  assert(intern__id(pool, str("host")) == 0);
+  assert(intern__id(pool, str(label)) == 1);
+  assert(intern__id(pool, str("")) == 2);
+  assert(intern__id(pool, str("host")) == 0);
+  assert(intern__id(pool, str("method")) == 1);
+  assert(intern__len(pool) == 3);
+
+  assert(intern__find(pool, str("method")) == 1);
+  assert(intern__find(pool, str("path")) == INTERN_NONE);
+  assert(intern__len(pool) == 3);
+
+  // the pool keeps its own copy
+  label[0] = 'x';
+  const box_t method = intern__get(pool, 1);
+  assert(method.size == 6);
+  assert(memcmp(method.ptr, "method", 6) == 0);
+  assert(intern__get(pool, 2).size == 0);
+
+  // -- CLEANUP
+  intern__free(pool);
+}
+
+void test__intern__box() {
+  // -- PREPARE
+  intern_t* pool = intern__new();
+  char a[] = "status";
+  char b[] = "status";
+
+  // -- TEST
+  // equal strings give the same pointer
+  const box_t x = intern__box(pool, str(a));
+  const box_t y = intern__box(pool, str(b));
+  assert(x.ptr == y.ptr);
+  assert(x.size == y.size);
+  assert(x.ptr != _M_cast(uint8_t*, a));
+  assert(intern__box(pool, str("code")).ptr != x.ptr);
+
+  // -- CLEANUP
+  intern__free(pool);
+}
+
+void test__intern__stable() {
+  // -- PREPARE
+  intern_t* pool = intern__new();
+  char buf[32];
+  const box_t first = intern__box(pool, str("first"));
+
+  // -- TEST
+  // interned strings do not move while the pool grows
+  for (int i = 0; i < 100000; i++) {
+    snprintf(buf, sizeof(buf), "label-%d", i);
+    assert(intern__id(pool, str(buf)) == _M_cast(uint32_t, i + 1));
+  }
+  assert(intern__box(pool, str("first")).ptr == first.ptr);
+  assert(memcmp(first.ptr, "first", 5) == 0);
+
+  for (int i = 0; i < 100000; i += 1000) {
+    snprintf(buf, sizeof(buf), "label-%d", i);
+    const box_t label = intern__get(pool, _M_cast(uint32_t, i + 1));
+    assert(label.size == strlen(buf));
+    assert(memcmp(label.ptr, buf, label.size) == 0);
+  }
+
+  // -- CLEANUP
+  intern__free(pool);
+}
+
+//
+//
+// ------------------ main ------------------
+//
+//
+
+int main() {
+  // -- intern_t
+  test__intern__new_and_free();
+  test__intern__id();
+  test__intern__box();
+  test__intern__stable();
+
+  return 0;
+}
@@ -0,0 +1,151 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// do not move or delete this #undef, otherwise the test will always pass, as
+// assert is only defined in debug mode. This #undef forces assert to be defined
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+// Include the header file to test
+#include "ccms/mapped_memory.h"
+
+#define TEST_FILE "test__mapped_memory.tmp"
+
+static void write_file(const char* data, const size_t size) {
+  FILE* file = fopen(TEST_FILE, "wb");
+  assert(file != NULL);
+  assert(fwrite(data, 1, size, file) == size);
+  fclose(file);
+}
+
+static size_t read_file(char* data, const size_t size) {
+  FILE* file = fopen(TEST_FILE, "rb");
+  assert(file != NULL);
+  const size_t n = fread(data, 1, size, file);
+  fclose(file);
+  return n;
+}
+
+//
+//
+// ------------------ mapped_mem_t ------------------
+//
+//
+
+void test__mapped_mem__new_read() {
+  // -- PREPARE
+  write_file("hello mapped world", 18);
+
+  // -- TEST
+  mapped_mem_t* mm = mapped_mem__new(TEST_FILE, MAPPED_MEM_READ);
+  assert(mm != NULL);
+  assert(mm->size == 18);
+  assert(memcmp(mm->ptr, "hello mapped world", 18) == 0);
+
+  box_t b = mapped_mem__as_box(mm);
+  assert(b.ptr == mm->ptr);
+  assert(b.size == mm->size);
+  assert(box__starts_with(b, box__ctor((uint8_t*)"hello", 5)));
+
+#ifndef _WIN32
+  // the mapping outlives the file
+  remove(TEST_FILE);
+  assert(memcmp(mm->ptr, "hello mapped world", 18) == 0);
+#endif
+
+  // -- CLEANUP
+  mapped_mem__free(mm);
+  remove(TEST_FILE);
+}
+
+void test__mapped_mem__new_private() {
+  // -- PREPARE
+  char data[16];
+  write_file("0123456789", 10);
+
+  // -- TEST
+  mapped_mem_t* mm = mapped_mem__new(TEST_FILE, MAPPED_MEM_PRIVATE);
+  assert(mm != NULL);
+  assert(mm->size == 10);
+
+  // writes are private to the mapping
+  memcpy(mm->ptr, "abc", 3);
+  assert(memcmp(mm->ptr, "abc3456789", 10) == 0);
+  assert(read_file(data, sizeof(data)) == 10);
+  assert(memcmp(data, "0123456789", 10) == 0);
+
+  // -- CLEANUP
+  mapped_mem__free(mm);
+  remove(TEST_FILE);
+}
+
+void test__mapped_mem__new_empty_and_missing() {
+  // -- PREPARE
+  write_file("", 0);
+
+  // -- TEST
+  mapped_mem_t* mm = mapped_mem__new(TEST_FILE, MAPPED_MEM_READ);
+  assert(mm != NULL);
+  assert(mm->ptr == NULL);
+  assert(mm->size == 0);
+  assert(mapped_mem__advise(mm, MAPPED_MEM_WILLNEED) == 0);
+  mapped_mem__free(mm);
+
+  remove(TEST_FILE);
+  assert(mapped_mem__new(TEST_FILE, MAPPED_MEM_READ) == NULL);
+}
+
+void test__mapped_mem__advise() {
+  // -- PREPARE
+  char data[KiB(64)];
+  memset(data, 'x', sizeof(data));
+  write_file(data, sizeof(data));
+  mapped_mem_t* mm = mapped_mem__new(TEST_FILE, MAPPED_MEM_READ);
+  assert(mm != NULL);
+
+  // -- TEST
+  assert(mapped_mem__advise(mm, MAPPED_MEM_SEQUENTIAL) == 0);
+  assert(mapped_mem__advise(mm, MAPPED_MEM_RANDOM) == 0);
+  assert(mapped_mem__advise(mm, MAPPED_MEM_NORMAL) == 0);
+  // huge pages for files depend on the kernel, it is only a hint either way
+  mapped_mem__advise(mm, MAPPED_MEM_HUGEPAGE);
+  assert(mm->ptr[KiB(64) - 1] == 'x');
+
+  // -- CLEANUP
+  mapped_mem__free(mm);
+  remove(TEST_FILE);
+}
+
+//
+//
+// ------------------ main ------------------
+//
+//
+
+int main() {
+  // -- mapped_mem_t
+  test__mapped_mem__new_read();
+  test__mapped_mem__new_private();
+  test__mapped_mem__new_empty_and_missing();
+  test__mapped_mem__advise();
+
+  return 0;
+}
@@ -0,0 +1,275 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// do not move or delete this #undef, otherwise the test will always pass, as
+// assert is only defined in debug mode. This #undef forces assert to be defined
+#undef NDEBUG
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+// Include the header file to test
+#include "ccms/mpmc_queue.h"
+
+#define STRESS_PRODUCERS 4
+#define STRESS_CONSUMERS 4
+#define STRESS_ITEMS 50000
+
+//
+//
+// ------------------ mpmc_queue_t ------------------
+//
+//
+
+void test__mpmc_queue__new() {
+  // -- PREPARE
+  st_arena_t* arena = st_arena__new(KiB(4));
+  uint8_t* writehead = arena->writehead;
+
+  // -- TEST
+  assert(mpmc_queue__new(arena, 0) == NULL);
+  assert(mpmc_queue__new(arena, 1) == NULL);
+  assert(mpmc_queue__new(arena, 12) == NULL);
+  assert(arena->writehead == writehead);
+
+  mpmc_queue_t* queue = mpmc_queue__new(arena, 16);
+  assert(queue != NULL);
+  assert(mpmc_queue__cap(queue) == 16);
+  assert(_M_cast(uintptr_t, queue) % 64 == 0);
+  assert(_M_cast(uintptr_t, queue->cells) % 64 == 0);
+
+  // does not fit, the arena is left as it was
+  writehead = arena->writehead;
+  assert(mpmc_queue__new(arena, 1024) == NULL);
+  assert(arena->writehead == writehead);
+
+  // -- CLEANUP
+  st_arena__free(arena);
+}
+
+void test__mpmc_queue__init() {
+  // -- PREPARE
+  _mpmc_queue_cell_t cells[8];
+  mpmc_queue_t queue;
+  void* item;
+
+  // -- TEST
+  assert(mpmc_queue__buffer_size(8) == sizeof(cells));
+  assert(mpmc_queue__init(&queue, cells, 6) == -1);
+  assert(mpmc_queue__init(&queue, cells, 8) == 0);
+  assert(mpmc_queue__cap(&queue) == 8);
+
+  assert(mpmc_queue__try_enqueue(&queue, &queue) == 1);
+  assert(mpmc_queue__try_dequeue(&queue, &item) == 1);
+  assert(item == &queue);
+}
+
+void test__mpmc_queue__enqueue_and_dequeue() {
+  // -- PREPARE
+  st_arena_t* arena = st_arena__new(KiB(4));
+  mpmc_queue_t* queue = mpmc_queue__new(arena, 4);
+  size_t values[16];
+  void* item;
+
+  // -- TEST
+  assert(mpmc_queue__try_dequeue(queue, &item) == 0);
+
+  // wraps around the cells a few times
+  for (size_t round = 0; round < 4; round++) {
+    for (size_t i = 0; i < 4; i++)
+      assert(mpmc_queue__try_enqueue(queue, &values[round * 4 + i]) == 1);
+    assert(mpmc_queue__try_enqueue(queue, &values[0]) == 0);
+
+    for (size_t i = 0; i < 4; i++) {
+      assert(mpmc_queue__try_dequeue(queue, &item) == 1);
+      assert(item == &values[round * 4 + i]);
+    }
+    assert(mpmc_queue__try_dequeue(queue, &item) == 0);
+  }
+
+  // interleaved
+  assert(mpmc_queue__try_enqueue(queue, &values[1]) == 1);
+  assert(mpmc_queue__try_enqueue(queue, &values[2]) == 1);
+  assert(mpmc_queue__try_dequeue(queue, &item) == 1);
+  assert(item == &values[1]);
+  assert(mpmc_queue__try_enqueue(queue, NULL) == 1);
+  assert(mpmc_queue__try_dequeue(queue, &item) == 1);
+  assert(item == &values[2]);
+  assert(mpmc_queue__try_dequeue(queue, &item) == 1);
+  assert(item == NULL);
+
+  // -- CLEANUP
+  st_arena__free(arena);
+}
+
+void test__mpmc_queue__batch() {
+  // -- PREPARE
+  st_arena_t* arena = st_arena__new(KiB(4));
+  mpmc_queue_t* queue = mpmc_queue__new(arena, 8);
+  size_t values[12];
+  void* items[12];
+  void* out[12];
+  void* item;
+
+  for (size_t i = 0; i < 12; i++)
+    items[i] = &values[i];
+
+  // -- TEST
+  assert(mpmc_queue__try_dequeue_batch(queue, out, 4) == 0);
+
+  // only as many as there is room for
+  assert(mpmc_queue__try_enqueue_batch(queue, items, 5) == 5);
+  assert(mpmc_queue__try_enqueue_batch(queue, items + 5, 7) == 3);
+  assert(mpmc_queue__try_enqueue_batch(queue, items, 1) == 0);
+  assert(mpmc_queue__try_enqueue(queue, items[0]) == 0);
+
+  assert(mpmc_queue__try_dequeue_batch(queue, out, 3) == 3);
+  assert(out[0] == items[0] && out[1] == items[1] && out[2] == items[2]);
+
+  // the batch wraps around the end of the cells
+  assert(mpmc_queue__try_enqueue_batch(queue, items + 8, 4) == 3);
+  assert(mpmc_queue__try_dequeue_batch(queue, out, 12) == 8);
+  for (size_t i = 0; i < 8; i++)
+    assert(out[i] == items[i + 3]);
+  assert(mpmc_queue__try_dequeue(queue, &item) == 0);
+
+  // single and batch operations mix
+  assert(mpmc_queue__try_enqueue(queue, items[0]) == 1);
+  assert(mpmc_queue__try_enqueue_batch(queue, items + 1, 2) == 2);
+  assert(mpmc_queue__try_dequeue_batch(queue, out, 2) == 2);
+  assert(out[0] == items[0] && out[1] == items[1]);
+  assert(mpmc_queue__try_dequeue(queue, &item) == 1);
+  assert(item == items[2]);
+
+  // empty batches do nothing, whether there is room/items or not
+  assert(mpmc_queue__try_enqueue_batch(queue, items, 0) == 0);
+  assert(mpmc_queue__try_dequeue_batch(queue, out, 0) == 0);
+  assert(mpmc_queue__try_enqueue(queue, items[0]) == 1);
+  assert(mpmc_queue__try_dequeue_batch(queue, out, 0) == 0);
+  assert(mpmc_queue__try_dequeue(queue, &item) == 1);
+  assert(item == items[0]);
+
+  // -- CLEANUP
+  st_arena__free(arena);
+}
+
+typedef struct {
+  mpmc_queue_t* queue;
+  size_t* values;
+  _Atomic size_t* seen;
+  _Atomic size_t* received;
+  size_t id;
+} stress_ctx_t;
+
+static void* stress_producer(void* arg) {
+  stress_ctx_t* ctx = _M_cast(stress_ctx_t*, arg);
+  size_t* values = ctx->values + ctx->id * STRESS_ITEMS;
+  size_t i = 0;
+
+  while (i < STRESS_ITEMS) {
+    // alternate between single and batch enqueues
+    if (i % 2 == 0) {
+      if (mpmc_queue__try_enqueue(ctx->queue, &values[i]))
+        i++;
+      else
+        sched_yield();
+    } else {
+      void* batch[7];
+      size_t n = STRESS_ITEMS - i < 7 ? STRESS_ITEMS - i : 7;
+      for (size_t k = 0; k < n; k++)
+        batch[k] = &values[i + k];
+      n = mpmc_queue__try_enqueue_batch(ctx->queue, batch, n);
+      if (n == 0) sched_yield();
+      i += n;
+    }
+  }
+
+  return NULL;
+}
+
+static void* stress_consumer(void* arg) {
+  stress_ctx_t* ctx = _M_cast(stress_ctx_t*, arg);
+  const size_t total = STRESS_PRODUCERS * STRESS_ITEMS;
+  void* batch[5];
+  size_t n;
+
+  while (atomic_load(ctx->received) < total) {
+    n = mpmc_queue__try_dequeue_batch(ctx->queue, batch, 5);
+    for (size_t k = 0; k < n; k++)
+      atomic_fetch_add(&ctx->seen[*_M_cast(size_t*, batch[k])], 1);
+    if (n == 0) sched_yield();
+    atomic_fetch_add(ctx->received, n);
+  }
+
+  return NULL;
+}
+
+void test__mpmc_queue__stress() {
+  // -- PREPARE
+  const size_t total = STRESS_PRODUCERS * STRESS_ITEMS;
+  st_arena_t* arena = st_arena__new(KiB(64));
+  mpmc_queue_t* queue = mpmc_queue__new(arena, 64);
+  size_t* values = _M_new_arr(size_t, total);
+  _Atomic size_t* seen = _M_new_arr(_Atomic size_t, total);
+  pthread_t producers[STRESS_PRODUCERS];
+  pthread_t consumers[STRESS_CONSUMERS];
+  stress_ctx_t ctxs[STRESS_PRODUCERS];
+  _Atomic size_t received;
+
+  atomic_init(&received, 0);
+
+  for (size_t v = 0; v < total; v++) {
+    values[v] = v;
+    atomic_init(&seen[v], 0);
+  }
+
+  // -- TEST
+  for (size_t t = 0; t < STRESS_PRODUCERS; t++) {
+    ctxs[t] = (stress_ctx_t){queue, values, seen, &received, t};
+    pthread_create(&producers[t], NULL, stress_producer, &ctxs[t]);
+  }
+  for (size_t t = 0; t < STRESS_CONSUMERS; t++)
+    pthread_create(&consumers[t], NULL, stress_consumer, &ctxs[0]);
+
+  for (size_t t = 0; t < STRESS_PRODUCERS; t++)
+    pthread_join(producers[t], NULL);
+  for (size_t t = 0; t < STRESS_CONSUMERS; t++)
+    pthread_join(consumers[t], NULL);
+
+  // every item was dequeued exactly once
+  assert(atomic_load(&received) == total);
+  for (size_t v = 0; v < total; v++)
+    assert(atomic_load(&seen[v]) == 1);
+
+  // -- CLEANUP
+  _M_free(values);
+  _M_free(seen);
+  st_arena__free(arena);
+}
+
+int main() {
+  test__mpmc_queue__new();
+  test__mpmc_queue__init();
+  test__mpmc_queue__enqueue_and_dequeue();
+  test__mpmc_queue__batch();
+  test__mpmc_queue__stress();
+
+  return 0;
+}
@@ -0,0 +1,85 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// do not move or delete this #undef, otherwise the test will always pass, as
+// assert is only defined in debug mode. This #undef forces assert to be defined
+#undef NDEBUG
+#include <assert.h>
+#include <string.h>
+
+// Include the header file to test
+#include "ccms/relptr.h"
+
+typedef struct pair_t {
+  relptr_t first;
+  relptr_t second;
+  uint64_t values[2];
+} pair_t;
+
+//
+//
+// ------------------ relptr_t ------------------
+//
+//
+
+void test__relptr__set_and_get() {
+  // -- PREPARE
+  pair_t pair = {{0}, {0}, {1, 2}};
+
+  // -- TEST
+  relptr__set(&pair.first, &pair.values[0]);
+  relptr__set(&pair.second, NULL);
+  assert(relptr__get(&pair.first) == &pair.values[0]);
+  assert(!relptr__is_null(&pair.first));
+  assert(relptr__get(&pair.second) == NULL);
+  assert(relptr__is_null(&pair.second));
+
+  // backwards works as well
+  relptr__set(&pair.second, &pair.first);
+  assert(relptr__deref(relptr_t, &pair.second) == &pair.first);
+}
+
+void test__relptr__relocate() {
+  // -- PREPARE
+  pair_t pairs[2];
+  pairs[0].values[0] = 1;
+  pairs[0].values[1] = 2;
+  relptr__set(&pairs[0].first, &pairs[0].values[0]);
+  relptr__set(&pairs[0].second, &pairs[0].values[1]);
+
+  // -- TEST
+  memcpy(&pairs[1], &pairs[0], sizeof(pair_t));
+  assert(relptr__deref(uint64_t, &pairs[1].first) == &pairs[1].values[0]);
+  assert(relptr__deref(uint64_t, &pairs[1].second) == &pairs[1].values[1]);
+  assert(*relptr__deref(uint64_t, &pairs[1].second) == 2);
+}
+
+//
+//
+// ------------------ main ------------------
+//
+//
+
+int main() {
+  // -- relptr_t
+  test__relptr__set_and_get();
+  test__relptr__relocate();
+
+  return 0;
+}
@@ -83,6 +83,30 @@ void test__sized_mem__from_box() {
   sized_mem__free(sm);
 }
 
+void test__sized_mem__compare_and_hash() {
+  // -- PREPARE
+  sized_mem_t* sm1 = sized_mem__from_box(box__ctor((uint8_t*)"hello", 5));
+  sized_mem_t* sm2 = sized_mem__clone(sm1);
+  sized_mem_t* sm3 = sized_mem__from_box(box__ctor((uint8_t*)"help", 4));
+
+  // -- TEST
+  assert(sized_mem__eq(sm1, sm2));
+  assert(!sized_mem__eq(sm1, sm3));
+  assert(sized_mem__cmp(sm1, sm2) == 0);
+  assert(sized_mem__cmp(sm1, sm3) < 0);
+  assert(sized_mem__cmp(sm3, sm1) > 0);
+  assert(sized_mem__starts_with(sm1, box__ctor((uint8_t*)"hel", 3)));
+  assert(!sized_mem__starts_with(sm3, box__ctor((uint8_t*)"hello", 5)));
+  assert(sized_mem__hash(sm1) == sized_mem__hash(sm2));
+  assert(sized_mem__hash(sm1) == box__hash(sized_mem__as_box(sm1)));
+  assert(sized_mem__hash(sm1) != sized_mem__hash(sm3));
+
+  // -- CLEANUP
+  sized_mem__free(sm1);
+  sized_mem__free(sm2);
+  sized_mem__free(sm3);
+}
+
 //
 //
 // ------------------ main ------------------
@@ -95,6 +119,7 @@ int main() {
   test__sized_mem__clone();
   test__sized_mem__as_box();
   test__sized_mem__from_box();
+  test__sized_mem__compare_and_hash();
 
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,185 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// do not move or delete this #undef, otherwise the test will always pass, as
+// assert is only defined in debug mode. This #undef forces assert to be defined
+#undef NDEBUG
+#include <assert.h>
+#include <pthread.h>
+#include <string.h>
+
+// Include the header file to test
+#include "ccms/spsc_ring.h"
+
+//
+//
+// ------------------ spsc_ring_t ------------------
+//
+//
+
+void test__spsc_ring__new_and_free() {
+  // -- TEST
+  spsc_ring_t* ring = spsc_ring__new(1);
+  assert(ring != NULL);
+  assert(spsc_ring__cap(ring) == KiB(64));
+
+  spsc_ring_t* large = spsc_ring__new(KiB(100));
+  assert(spsc_ring__cap(large) == KiB(128));
+
+  // the buffer is visible twice, back to back
+  ring->data[10] = 42;
+  assert(ring->data[KiB(64) + 10] == 42);
+  ring->data[KiB(64) + 20] = 43;
+  assert(ring->data[20] == 43);
+
+  // -- CLEANUP
+  spsc_ring__free(ring);
+  spsc_ring__free(large);
+}
+
+void test__spsc_ring__reserve_and_peek() {
+  // -- PREPARE
+  spsc_ring_t* ring = spsc_ring__new(KiB(64));
+  assert(ring != NULL);
+
+  // -- TEST
+  assert(spsc_ring__peek(ring).ptr == NULL);
+
+  box_t box = spsc_ring__reserve(ring, 10);
+  assert(box.ptr == ring->data);
+  assert(box.size == KiB(64));
+  memcpy(box.ptr, "0123456789", 10);
+
+  // nothing is readable before the commit
+  assert(spsc_ring__peek(ring).ptr == NULL);
+  spsc_ring__commit(ring, 10);
+
+  box = spsc_ring__peek(ring);
+  assert(box.size == 10);
+  assert(memcmp(box.ptr, "0123456789", 10) == 0);
+  spsc_ring__release(ring, 4);
+  box = spsc_ring__peek(ring);
+  assert(box.size == 6);
+  assert(memcmp(box.ptr, "456789", 6) == 0);
+
+  // the free space shrinks by what is not released yet
+  assert(spsc_ring__reserve(ring, KiB(64)).ptr == NULL);
+  assert(spsc_ring__reserve(ring, 1).size == KiB(64) - 6);
+
+  // -- CLEANUP
+  spsc_ring__free(ring);
+}
+
+void test__spsc_ring__wrap() {
+  // -- PREPARE
+  spsc_ring_t* ring = spsc_ring__new(KiB(64));
+  assert(ring != NULL);
+  const size_t cap = spsc_ring__cap(ring);
+
+  // move both positions close to the end of the buffer
+  spsc_ring__reserve(ring, cap - 8);
+  spsc_ring__commit(ring, cap - 8);
+  spsc_ring__peek(ring);
+  spsc_ring__release(ring, cap - 8);
+
+  // -- TEST
+  // a write across the end is one contiguous box
+  box_t box = spsc_ring__reserve(ring, 16);
+  assert(box.ptr == ring->data + cap - 8);
+  assert(box.size == cap);
+  memcpy(box.ptr, "abcdefghijklmnop", 16);
+  spsc_ring__commit(ring, 16);
+
+  // and so is the read
+  box = spsc_ring__peek(ring);
+  assert(box.size == 16);
+  assert(memcmp(box.ptr, "abcdefghijklmnop", 16) == 0);
+  assert(memcmp(ring->data, "ijklmnop", 8) == 0);
+  spsc_ring__release(ring, 16);
+
+  box = spsc_ring__reserve(ring, 1);
+  assert(box.ptr == ring->data + 8);
+
+  // -- CLEANUP
+  spsc_ring__free(ring);
+}
+
+#define STREAM_BYTES (MiB(64))
+
+static void* producer(void* arg) {
+  spsc_ring_t* ring = _M_cast(spsc_ring_t*, arg);
+  uint64_t seed = 1;
+  size_t written = 0;
+
+  while (written < STREAM_BYTES) {
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    size_t n = 1 + (seed >> 33) % 5000;
+    if (n > STREAM_BYTES - written) n = STREAM_BYTES - written;
+
+    box_t box;
+    while ((box = spsc_ring__reserve(ring, n)).ptr == NULL) {
+    }
+    for (size_t i = 0; i < n; i++)
+      box.ptr[i] = _M_cast(uint8_t, (written + i) * 31);
+    spsc_ring__commit(ring, n);
+    written += n;
+  }
+
+  return NULL;
+}
+
+void test__spsc_ring__threads() {
+  // -- PREPARE
+  spsc_ring_t* ring = spsc_ring__new(KiB(64));
+  assert(ring != NULL);
+  pthread_t thread;
+  pthread_create(&thread, NULL, producer, ring);
+
+  // -- TEST
+  // the consumer sees every byte exactly once and in order
+  size_t read = 0;
+  while (read < STREAM_BYTES) {
+    const box_t box = spsc_ring__peek(ring);
+    for (size_t i = 0; i < box.size; i++)
+      assert(box.ptr[i] == _M_cast(uint8_t, (read + i) * 31));
+    spsc_ring__release(ring, box.size);
+    read += box.size;
+  }
+  assert(read == STREAM_BYTES);
+
+  // -- CLEANUP
+  pthread_join(thread, NULL);
+  spsc_ring__free(ring);
+}
+
+//
+//
+// ------------------ main ------------------
+//
+//
+
+int main() {
+  // -- spsc_ring_t
+  test__spsc_ring__new_and_free();
+  test__spsc_ring__reserve_and_peek();
+  test__spsc_ring__wrap();
+  test__spsc_ring__threads();
+
+  return 0;
+}
@@ -0,0 +1,200 @@
+/******************************************************************************/
+/* CCMS - Collection of C Memory Structures, a lightweight header-only C      */
+/* library.                                                                   */
+/* Copyright (C) 2024, Hendrik Boeck <hendrikboeck.dev@protonmail.com>        */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify  it   */
+/* under the terms of the GNU General Public License as published by the Free */
+/* Software Foundation, either version 3 of the License, or (at your option)  */
+/* any later version.                                                         */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful, but        */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY */
+/* or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   */
+/* for more details.                                                          */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License along    */
+/* with this program.  If not, see <https://www.gnu.org/licenses/>.           */
+/******************************************************************************/
+
+// do not move or delete this #undef, otherwise the test will always pass, as
+// assert is only defined in debug mode. This #undef forces assert to be defined
+#undef NDEBUG
+#include <assert.h>
+#include <string.h>
+
+// Include the header file to test
+#include "ccms/vec.h"
+
+vec__define(ivec, int)
+
+typedef struct point_t {
+  double x, y;
+} point_t;
+
+vec__define(point_vec, point_t)
+
+//
+//
+// ------------------ vec__define ------------------
+//
+//
+
+void test__vec__ctor_and_free() {
+  // -- TEST
+  ivec_t vec = ivec__ctor(allocator__malloc());
+  assert(vec.data == NULL);
+  assert(vec.len == 0);
+  assert(vec.cap == 0);
+
+  assert(ivec__push(&vec, 1) != NULL);
+  assert(vec.cap == __CCMS__VEC_MIN_CAP);
+
+  // -- CLEANUP
+  ivec__free(&vec);
+  assert(vec.data == NULL);
+  assert(vec.cap == 0);
+}
+
+void test__vec__push_and_pop() {
+  // -- PREPARE
+  ivec_t vec = ivec__ctor(allocator__malloc());
+
+  // -- TEST
+  for (int i = 0; i < 1000; i++)
+    assert(*ivec__push(&vec, i) == i);
+  assert(vec.len == 1000);
+  assert(vec.cap >= 1000 && vec.cap < 2000);
+
+  for (int i = 0; i < 1000; i++)
+    assert(vec.data[i] == i);
+
+  assert(ivec__pop(&vec) == 999);
+  assert(vec.len == 999);
+
+  ivec__clear(&vec);
+  assert(vec.len == 0);
+
+  // -- CLEANUP
+  ivec__free(&vec);
+}
+
+void test__vec__reserve() {
+  // -- PREPARE
+  point_vec_t vec = point_vec__ctor(allocator__malloc());
+
+  // -- TEST
+  assert(point_vec__reserve(&vec, 100) == 0);
+  assert(vec.cap == 100);
+  point_t* data = vec.data;
+  for (int i = 0; i < 100; i++)
+    point_vec__push(&vec, (point_t){.x = i, .y = -i});
+  assert(vec.data == data);
+
+  // never shrinks
+  assert(point_vec__reserve(&vec, 10) == 0);
+  assert(vec.cap == 100);
+
+  // -- CLEANUP
+  point_vec__free(&vec);
+}
+
+void test__vec__append() {
+  // -- PREPARE
+  ivec_t vec = ivec__ctor(allocator__malloc());
+  int values[] = {1, 2, 3, 4, 5};
+
+  // -- TEST
+  ivec__push(&vec, 0);
+  assert(ivec__append(&vec, box__ctor(_M_cast(uint8_t*, values),
+                                      sizeof(values))) == 0);
+  assert(vec.len == 6);
+  for (int i = 0; i < 6; i++)
+    assert(vec.data[i] == i);
+
+  // only whole elements can be appended
+  assert(ivec__append(&vec, box__ctor(_M_cast(uint8_t*, values), 3)) == -1);
+  assert(vec.len == 6);
+
+  box_t box = ivec__as_box(&vec);
+  assert(box.ptr == _M_cast(uint8_t*, vec.data));
+  assert(box.size == 6 * sizeof(int));
+
+  // -- CLEANUP
+  ivec__free(&vec);
+}
+
+void test__vec__swap_remove() {
+  // -- PREPARE
+  ivec_t vec = ivec__ctor(allocator__malloc());
+  for (int i = 0; i < 5; i++)
+    ivec__push(&vec, i);
+
+  // -- TEST
+  assert(ivec__swap_remove(&vec, 1) == 1);
+  assert(vec.len == 4);
+  assert(vec.data[1] == 4);
+  assert(ivec__swap_remove(&vec, 3) == 3);
+  assert(vec.len == 3);
+
+  // -- CLEANUP
+  ivec__free(&vec);
+}
+
+void test__vec__arena_tail() {
+  // -- PREPARE
+  st_arena_t* arena = st_arena__new(KiB(64));
+  ivec_t vec = ivec__ctor(allocator__st_arena(arena));
+
+  // -- TEST
+  // as long as the vector owns the tail of the arena it never moves
+  ivec__push(&vec, 0);
+  int* data = vec.data;
+  for (int i = 1; i < 10000; i++)
+    ivec__push(&vec, i);
+  assert(vec.data == data);
+  assert(st_arena__cap(arena) == KiB(64) - vec.cap * sizeof(int));
+
+  // and gives its storage back when freed
+  ivec__free(&vec);
+  assert(st_arena__cap(arena) == KiB(64));
+
+  // -- CLEANUP
+  st_arena__free(arena);
+}
+
+void test__vec__pg_arena() {
+  // -- PREPARE
+  pg_arena_t* arena = pg_arena__new(KiB(4));
+  point_vec_t vec = point_vec__ctor(allocator__pg_arena(arena));
+
+  // -- TEST
+  // grows past the page size into large blocks
+  for (int i = 0; i < 10000; i++)
+    point_vec__push(&vec, (point_t){.x = i, .y = -i});
+  for (int i = 0; i < 10000; i++)
+    assert(vec.data[i].x == i && vec.data[i].y == -i);
+  assert(_M_cast(uintptr_t, vec.data) % _M_alignof(point_t) == 0);
+
+  // -- CLEANUP
+  pg_arena__free(arena);
+}
+
+//
+//
+// ------------------ main ------------------
+//
+//
+
+int main() {
+  // -- vec__define
+  test__vec__ctor_and_free();
+  test__vec__push_and_pop();
+  test__vec__reserve();
+  test__vec__append();
+  test__vec__swap_remove();
+  test__vec__arena_tail();
+  test__vec__pg_arena();
+
+  return 0;
+}
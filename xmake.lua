@@ -4,6 +4,12 @@ set_languages("c11")
 
 add_rules("mode.debug", "mode.release")
 
+-- The mmap based structures use MAP_ANONYMOUS, madvise etc. which glibc hides
+-- in strict ISO C mode
+if is_plat("linux") then
+  add_defines("_GNU_SOURCE")
+end
+
 --[[
 This script sets up a target named "ccms" which is a header-only library.
 
@@ -19,6 +25,7 @@ target("ccms")
   set_kind("headeronly")
   add_headerfiles("include/(ccms/*.h)")
   add_headerfiles("include/(ccms/arena/*.h)")
+  add_headerfiles("include/(ccms/alloc/*.h)")
   add_includedirs("include", { public = true })
   add_rules("utils.install.cmake_importfiles")
   add_rules("utils.install.pkgconfig_importfiles")
@@ -38,17 +45,110 @@ build, and adds the corresponding C file to the build files.
 
 It also adds a dependency on the "ccms" target, adds a "default" test with plain
 output, and sets a policy that the test should return zero on failure.
+
+Every test is built a second time as "<name>__align64" with
+__CCMS__DEFAULT_ALIGN set to 64, so that the plain `*_alloc` functions are
+also tested with padding between chunks.
 ]]
+local test_variants = {
+  { suffix = "" },
+  { suffix = "__align64", align = 64 },
+}
+
 for _, file in ipairs(os.files("test/test__*.c")) do
   -- Extract the base name of the file
   local name = path.basename(file)
 
+  for _, variant in ipairs(test_variants) do
+    -- Create a new target with the base name of the file
+    target(name .. variant.suffix)
+      set_kind("binary")
+      set_default(false)
+      add_files("test/" .. name .. ".c")
+      add_deps("ccms")
+      add_tests("default", { plain = true })
+      set_policy("test.return_zero_on_failure", true)
+      if variant.align then
+        add_defines("__CCMS__DEFAULT_ALIGN=" .. variant.align)
+      end
+      if is_plat("linux", "macosx", "bsd") then
+        add_syslinks("pthread")
+      end
+      -- shm_open (fallback of the mirrored mappings) lives in librt before
+      -- glibc 2.34
+      if is_plat("linux") then
+        add_syslinks("rt")
+      end
+  end
+end
+
+--[[
+This script is used to create a separate xmake target for each C file in the
+bench directory that matches the pattern "bench__*.c".
+
+Benchmarks are excluded from the default build and are always compiled with
+optimizations. Every benchmark prints its results as CSV to stdout; run one
+with e.g. `xmake run bench__arena__page_pool`.
+]]
+for _, file in ipairs(os.files("bench/bench__*.c")) do
+  -- Extract the base name of the file
+  local name = path.basename(file)
+
   -- Create a new target with the base name of the file
   target(name)
     set_kind("binary")
     set_default(false)
-    add_files("test/" .. name .. ".c")
+    set_optimize("fastest")
+    add_files("bench/" .. name .. ".c")
+    add_includedirs("bench")
     add_deps("ccms")
-    add_tests("default", { plain = true })
-    set_policy("test.return_zero_on_failure", true)
-end
\ No newline at end of file
+    if is_plat("linux", "macosx", "bsd") then
+      add_syslinks("pthread")
+    end
+end
+
+--[[
+This script adds a task that builds and runs every benchmark in turn and
+collects their results into one CSV table (one header line, then the rows of
+all benchmarks), e.g. `xmake bench -o results.csv` to keep track of results
+over time. BENCH_THREADS limits the number of threads of the multi-threaded
+benchmarks (default 8).
+]]
+task("bench")
+  set_category("plugin")
+  on_run(function ()
+    import("core.base.option")
+
+    local rows = {}
+    local header = nil
+    for _, file in ipairs(os.files(path.join(os.projectdir(),
+                                             "bench/bench__*.c"))) do
+      local name = path.basename(file)
+      os.exec("xmake build %s", name)
+
+      local out = os.iorun("xmake run %s", name)
+      for line in out:gmatch("[^\r\n]+") do
+        if line:startswith("benchmark,") then
+          header = line
+        else
+          table.insert(rows, line)
+        end
+      end
+    end
+
+    local csv = (header or "") .. "\n" .. table.concat(rows, "\n") .. "\n"
+    local output = option.get("output")
+    if output then
+      io.writefile(output, csv)
+      print("results written to %s", output)
+    else
+      io.write(csv)
+    end
+  end)
+  set_menu {
+    usage = "xmake bench [options]",
+    description = "Build and run all benchmarks, printing one CSV table.",
+    options = {
+      {'o', "output", "kv", nil, "Write the table to this file instead."}
+    }
+  }